@@ -0,0 +1,284 @@
+// Agent
+//
+// The ScriptingAgent answers scripting requests that come in over a
+// socket; see Agent.h.
+//
+// Each client gets a thread reading its requests.  Every request is sent
+// on to the target with a handler of its own for the reply, so the
+// reader never waits for the target; the handler writes the reply back
+// (tagged with the request's id) and goes away.  Writes to a client take
+// turns on its lock, and the client's socket lives until the reader and
+// every outstanding handler are done with it.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Agent.h"
+#include "Wire.h"
+
+#include <app/Handler.h>
+#include <app/Message.h>
+#include <app/Roster.h>
+#include <new>
+#include <string.h>
+
+// One client.
+struct agent_connection {
+	ScriptingAgent *agent;
+	int sock;
+	BLocker write_lock;
+	int32 refs;				// the reader, plus one per outstanding request
+	thread_id reader;
+};
+
+// ----------------------------------------------------------------------
+static void release_connection( agent_connection *conn )
+{
+	if( atomic_add( &conn->refs, -1 ) == 1 ) {
+		wire_close( conn->sock );
+		delete conn;
+	}
+}
+
+static void write_reply( agent_connection *conn, uint32 id,
+                         const BMessage &reply )
+{
+	if( conn->write_lock.Lock() ) {
+		(void)wire_write( conn->sock, id, reply );
+		conn->write_lock.Unlock();
+	}
+}
+
+// ======================================================================
+// AgentReplyHandler
+// ======================================================================
+
+// Waits for the target's reply to one request, sends it back to the
+// client, and deletes itself.
+class AgentReplyHandler : public BHandler {
+public:
+	AgentReplyHandler( agent_connection *connection, uint32 request_id )
+		: BHandler( "hey agent reply" ),
+		  conn( connection ),
+		  id( request_id )
+	{
+		(void)atomic_add( &conn->refs, 1 );
+	}
+
+	virtual ~AgentReplyHandler()
+	{
+		release_connection( conn );
+	}
+
+	virtual void MessageReceived( BMessage *msg )
+	{
+		write_reply( conn, id, *msg );
+
+		// Nothing touches the handler once MessageReceived() returns.
+		Looper()->RemoveHandler( this );
+		delete this;
+	}
+
+private:
+	agent_connection *conn;
+	uint32 id;
+};
+
+// ======================================================================
+// ScriptingAgent
+// ======================================================================
+
+ScriptingAgent::ScriptingAgent( const BMessenger &the_target )
+	: target( the_target ),
+	  address( NULL ),
+	  listener( -1 ),
+	  accept_thread( -1 ),
+	  looper( NULL ),
+	  lock( "hey agent" )
+{
+}
+
+ScriptingAgent::~ScriptingAgent()
+{
+	if( accept_thread >= 0 ) {
+		wire_shutdown( listener );
+		wire_close( listener );
+
+		status_t retval;
+		(void)wait_for_thread( accept_thread, &retval );
+		wire_unlink( address );
+	}
+
+	// Hang up on everybody, then wait for their readers to notice.  The
+	// readers take themselves off the list, so don't hold the lock while
+	// we wait.
+	BList readers;
+	if( lock.Lock() ) {
+		for( int32 idx = 0; idx < connections.CountItems(); idx++ ) {
+			agent_connection *conn = (agent_connection *)connections.ItemAt( idx );
+			wire_shutdown( conn->sock );
+			readers.AddItem( (void *)conn->reader );
+		}
+		lock.Unlock();
+	}
+	for( int32 idx = 0; idx < readers.CountItems(); idx++ ) {
+		status_t retval;
+		(void)wait_for_thread( (thread_id)readers.ItemAt( idx ), &retval );
+	}
+
+	// Handlers still waiting for the target have nobody to answer; the
+	// looper doesn't delete them, so we do (which lets their clients go).
+	if( looper && looper->Lock() ) {
+		for( int32 idx = looper->CountHandlers() - 1; idx > 0; idx-- ) {
+			BHandler *handler = looper->HandlerAt( idx );
+			looper->RemoveHandler( handler );
+			delete handler;
+		}
+		looper->Quit();
+	}
+
+	delete [] address;
+}
+
+const char *ScriptingAgent::Address( void ) const
+{
+	return address;
+}
+
+// ----------------------------------------------------------------------
+status_t ScriptingAgent::Listen( const char *where )
+{
+	if( accept_thread >= 0 ) return B_NOT_ALLOWED;
+
+	try {
+		address = new char[strlen( where ) + 1];
+		strcpy( address, where );
+
+		looper = new BLooper( "hey agent replies" );
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+	(void)looper->Run();
+
+	status_t retval = wire_listen( address, &listener );
+	if( retval != B_OK ) return retval;
+
+	accept_thread = spawn_thread( accepter, "hey agent", B_NORMAL_PRIORITY,
+	                              this );
+	if( accept_thread < B_OK ) {
+		retval = accept_thread;
+		accept_thread = -1;
+		wire_close( listener );
+		return retval;
+	}
+
+	return resume_thread( accept_thread );
+}
+
+// ----------------------------------------------------------------------
+// Take connections until the listener goes away.
+int32 ScriptingAgent::accepter( void *data )
+{
+	ScriptingAgent *agent = (ScriptingAgent *)data;
+
+	int sock;
+	while( wire_accept( agent->listener, &sock ) == B_OK ) {
+		agent_connection *conn;
+		try {
+			conn = new agent_connection;
+		} catch ( bad_alloc &ex ) {
+			wire_close( sock );
+			continue;
+		}
+		conn->agent = agent;
+		conn->sock = sock;
+		conn->refs = 1;
+
+		// Tell the client who it's talking to.
+		BMessage hello( HEY_WIRE_HELLO );
+		hello.AddInt32( "team", agent->target.Team() );
+		app_info info;
+		if( be_roster->GetRunningAppInfo( agent->target.Team(),
+		                                  &info ) == B_OK ) {
+			hello.AddString( "signature", info.signature );
+		}
+		if( wire_write( sock, 0, hello ) != B_OK ) {
+			release_connection( conn );
+			continue;
+		}
+
+		conn->reader = spawn_thread( reader, "hey agent client",
+		                             B_NORMAL_PRIORITY, conn );
+		if( conn->reader < B_OK ) {
+			release_connection( conn );
+			continue;
+		}
+
+		agent->lock.Lock();
+		agent->connections.AddItem( conn );
+		agent->lock.Unlock();
+
+		(void)resume_thread( conn->reader );
+	}
+
+	return B_OK;
+}
+
+// ----------------------------------------------------------------------
+// Pass one client's requests on to the target until it hangs up.
+int32 ScriptingAgent::reader( void *data )
+{
+	agent_connection *conn = (agent_connection *)data;
+	ScriptingAgent *agent = conn->agent;
+
+	uint32 id;
+	BMessage request;
+	while( wire_read( conn->sock, &id, &request ) == B_OK ) {
+		AgentReplyHandler *handler;
+		try {
+			handler = new AgentReplyHandler( conn, id );
+		} catch ( bad_alloc &ex ) {
+			handler = NULL;
+		}
+
+		status_t retval = B_NO_MEMORY;
+		if( handler && agent->looper->Lock() ) {
+			agent->looper->AddHandler( handler );
+			agent->looper->Unlock();
+
+			retval = agent->target.SendMessage( &request, handler );
+			if( retval != B_OK && agent->looper->Lock() ) {
+				agent->looper->RemoveHandler( handler );
+				agent->looper->Unlock();
+				delete handler;
+			}
+		} else {
+			delete handler;
+		}
+
+		// The target never saw it, so answer for it.
+		if( retval != B_OK ) {
+			BMessage reply( B_ERROR );
+			reply.AddInt32( "error", retval );
+			reply.AddString( "message", "the agent couldn't reach its target" );
+			write_reply( conn, id, reply );
+		}
+
+		request.MakeEmpty();
+	}
+
+	agent->lock.Lock();
+	agent->connections.RemoveItem( conn );
+	agent->lock.Unlock();
+
+	wire_shutdown( conn->sock );
+	release_connection( conn );
+
+	return B_OK;
+}
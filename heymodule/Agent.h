@@ -0,0 +1,61 @@
+// Agent
+//
+// The ScriptingAgent lives in a target's team and answers scripting
+// requests that come in over a socket (see Wire.h), by passing them on to
+// a messenger and sending the replies back.  Any number of clients can be
+// connected, and each of them can have any number of requests waiting;
+// replies go back as soon as the target gives them.
+//
+// It doesn't need Python, so an application can link Agent.o and Wire.o
+// and make itself scriptable over a socket:
+//
+//     ScriptingAgent *agent = new ScriptingAgent( BMessenger( be_app ) );
+//     agent->Listen( "/tmp/myapp.hey" );
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Agent_H
+#define PyHey_Agent_H
+
+#include <app/Looper.h>
+#include <app/Messenger.h>
+#include <support/List.h>
+#include <support/Locker.h>
+#include <kernel/OS.h>
+
+class ScriptingAgent {
+public:
+	ScriptingAgent( const BMessenger &target );
+
+	// Hangs up on every client; replies still on their way are dropped.
+	~ScriptingAgent();
+
+	// Start taking connections on address.
+	status_t Listen( const char *address );
+
+	// Where we're listening, or NULL.
+	const char *Address( void ) const;
+
+private:
+	static int32 accepter( void *data );
+	static int32 reader( void *data );
+
+	BMessenger target;
+	char *address;
+	int listener;
+	thread_id accept_thread;
+
+	BLooper *looper;		// where the target's replies land
+
+	BLocker lock;
+	BList connections;		// agent_connection *s
+};
+
+#endif
@@ -0,0 +1,404 @@
+// Batch
+//
+// The Batch object is used by heymodule to queue up a pile of scripting
+// requests for one application and send them all at once; the replies
+// come back in the order the requests were queued.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Batch.h"
+#include "FanOut.h"
+#include "Reply.h"
+#include "Specifier.h"
+#include "Suites.h"
+
+#include <app/Message.h>
+
+static void clear_requests( BList *requests );
+static PyObject *queued( BatchObject *self, BMessage *msg );
+static PyObject *pending_error( void );
+
+// ======================================================================
+// Batch object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Create a new Batch object for the given Hey object.
+BatchObject *newBatchObject( HeyObject *hey )
+{
+	BatchObject *self;
+	self = PyObject_NEW( BatchObject, &Batch_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	// Keep the target alive as long as we've got requests for it.
+	Py_INCREF( hey );
+	self->hey = hey;
+	self->requests = NULL;
+
+	try {
+		self->requests = new BList;
+	} catch ( bad_alloc &ex ) {
+		Py_DECREF( self );
+		return (BatchObject *)PyErr_NoMemory();
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Delete a Batch object
+static void Batch_dealloc( BatchObject *self )
+{
+	if( self->requests ) {
+		clear_requests( self->requests );
+		delete self->requests;
+	}
+	Py_DECREF( self->hey );
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Throw away everything that's been queued.
+static void clear_requests( BList *requests )
+{
+	for( int32 idx = 0; idx < requests->CountItems(); idx++ ) {
+		delete (BMessage *)requests->ItemAt( idx );
+	}
+	requests->MakeEmpty();
+}
+
+// ----------------------------------------------------------------------
+// Add a finished request to the queue; returns its position, which is
+// also where its reply will be in Execute()'s list.
+static PyObject *queued( BatchObject *self, BMessage *msg )
+{
+	if( refuse_fanout( *msg ) ||
+		!validate_request( self->hey, msg, self->hey->validation,
+	                       self->hey->send_timeout, self->hey->reply_timeout ) ) {
+		delete msg;
+		return NULL;
+	}
+
+	if( !self->requests->AddItem( msg ) ) {
+		delete msg;
+		return PyErr_NoMemory();
+	}
+
+	return PyInt_FromLong( self->requests->CountItems() - 1 );
+}
+
+// ----------------------------------------------------------------------
+// Swap the current exception for its value, so it can sit in a result
+// list instead of being raised.
+static PyObject *pending_error( void )
+{
+	PyObject *type, *value, *traceback;
+	PyErr_Fetch( &type, &value, &traceback );
+	PyErr_NormalizeException( &type, &value, &traceback );
+
+	Py_XDECREF( type );
+	Py_XDECREF( traceback );
+	if( value == NULL ) {
+		Py_INCREF( Py_None );
+		value = Py_None;
+	}
+
+	return value;
+}
+
+// ----------------------------------------------------------------------
+// Queue simple commands; these take a Specifier or a hey-style string.
+static PyObject *Batch_simple( BatchObject *self, PyObject *args, uint32 what )
+{
+	SpecifierObject *spec = parse_specifier( args );
+	if( spec == NULL ) {
+		return NULL;
+	}
+
+	BMessage *msg = new_request( spec, what );
+	Py_DECREF( spec );
+	if( msg == NULL ) {
+		return NULL;
+	}
+
+	return queued( self, msg );
+}
+
+static PyObject *Batch_Get( BatchObject *self, PyObject *args )
+{
+	return Batch_simple( self, args, B_GET_PROPERTY );
+}
+
+static PyObject *Batch_Count( BatchObject *self, PyObject *args )
+{
+	return Batch_simple( self, args, B_COUNT_PROPERTIES );
+}
+
+static PyObject *Batch_Create( BatchObject *self, PyObject *args )
+{
+	return Batch_simple( self, args, B_CREATE_PROPERTY );
+}
+
+static PyObject *Batch_Delete( BatchObject *self, PyObject *args )
+{
+	return Batch_simple( self, args, B_DELETE_PROPERTY );
+}
+
+static PyObject *Batch_GetSuites( BatchObject *self, PyObject *args )
+{
+	SpecifierObject *spec = NULL;
+	if( !PyArg_ParseTuple( args, "|O!", &Specifier_Type, &spec ) ) {
+		PyErr_SetString( PyExc_TypeError,
+				"invalid arguments; expected a Specifier" );
+		return NULL;
+	}
+
+	BMessage *msg = new_request( spec, B_GET_SUPPORTED_SUITES );
+	if( msg == NULL ) {
+		return NULL;
+	}
+
+	return queued( self, msg );
+}
+
+// ----------------------------------------------------------------------
+// Queue "set" commands; same arguments as the Hey object's versions (see
+// new_set_request()).
+static PyObject *Batch_set( BatchObject *self, PyObject *args, int kind )
+{
+	BMessage *msg = new_set_request( args, kind );
+	if( msg == NULL ) return NULL;
+
+	return queued( self, msg );
+}
+
+static PyObject *Batch_SetString( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_STRING );
+}
+
+static PyObject *Batch_SetPath( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_PATH );
+}
+
+static PyObject *Batch_SetColor( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_COLOR );
+}
+
+static PyObject *Batch_SetInt8( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_INT8 );
+}
+
+static PyObject *Batch_SetInt16( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_INT16 );
+}
+
+static PyObject *Batch_SetInt32( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_INT32 );
+}
+
+static PyObject *Batch_SetFloat( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_FLOAT );
+}
+
+static PyObject *Batch_SetDouble( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_DOUBLE );
+}
+
+static PyObject *Batch_SetBool( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_BOOL );
+}
+
+static PyObject *Batch_SetRect( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_RECT );
+}
+
+static PyObject *Batch_SetPoint( BatchObject *self, PyObject *args )
+{
+	return Batch_set( self, args, SET_POINT );
+}
+
+// ----------------------------------------------------------------------
+// Send everything and collect the replies.
+//
+// Call with an optional timeout (in seconds) for the whole batch; the
+// default is the Hey object's reply timeout.  You get back a list with
+// one entry per queued request; if a request failed, its entry is the
+// exception Hey would have raised for it (a TimeoutError if it wasn't
+// answered in time).  The queue is empty afterwards, so the Batch can be
+// reused.
+static PyObject *Batch_Execute( BatchObject *self, PyObject *args )
+{
+	double seconds = -1.0;
+	if( !PyArg_ParseTuple( args, "|d", &seconds ) ) {
+		return NULL;
+	}
+
+	bigtime_t timeout = self->hey->reply_timeout;
+	if( seconds >= 0.0 ) {
+		timeout = (bigtime_t)( seconds * 1000000.0 );
+	}
+
+	int32 count = self->requests->CountItems();
+	PyObject *results = PyList_New( count );
+	if( results == NULL ) return NULL;
+	if( count == 0 ) return results;
+
+	BMessage **replies = NULL;
+	try {
+		replies = new BMessage *[count];
+	} catch ( bad_alloc &ex ) {
+		Py_DECREF( results );
+		return PyErr_NoMemory();
+	}
+
+	// Other threads can use the Batch while we're waiting for replies,
+	// so give it a fresh queue and send the old one.
+	BList *sending = self->requests;
+	try {
+		self->requests = new BList;
+	} catch ( bad_alloc &ex ) {
+		self->requests = sending;
+		delete [] replies;
+		Py_DECREF( results );
+		return PyErr_NoMemory();
+	}
+
+	BMessage **requests = (BMessage **)sending->Items();
+	status_t retval;
+	Py_BEGIN_ALLOW_THREADS
+	retval = hey_send_pipelined( self->hey, requests, replies, count,
+	                             timeout, self->hey->send_timeout );
+	Py_END_ALLOW_THREADS
+
+	for( int32 idx = 0; idx < count; idx++ ) {
+		PyObject *obj;
+		if( replies[idx] == NULL ) {
+			if( retval == B_TIMED_OUT ) {
+				PyErr_SetString( HeyTimeoutError,
+					        "timed out waiting for reply" );
+			} else {
+				PyErr_SetString( PyExc_RuntimeError,
+					        "error sending message" );
+			}
+			obj = pending_error();
+		} else {
+			if( self->hey->lazy_replies ) {
+				obj = lazy_reply( replies[idx] );
+			} else {
+				obj = explain_reply( *replies[idx] );
+				delete replies[idx];
+			}
+			if( obj == NULL ) {
+				obj = pending_error();
+			}
+		}
+
+		(void)PyList_SetItem( results, idx, obj );
+	}
+
+	delete [] replies;
+	clear_requests( sending );
+	delete sending;
+
+	return results;
+}
+
+// ----------------------------------------------------------------------
+// Forget about everything that's been queued.
+static PyObject *Batch_Clear( BatchObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	clear_requests( self->requests );
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+// ----------------------------------------------------------------------
+// len( batch ) is the number of queued requests.
+static int Batch_length( BatchObject *self )
+{
+	return self->requests->CountItems();
+}
+
+// ----------------------------------------------------------------------
+// Method table and whatnot for the Batch object.
+static PyMethodDef BatchObject_methods[] = {
+	{ "Get",	(PyCFunction)Batch_Get,	1,	"Queue a Get for the given specifier." },
+	{ "Count",	(PyCFunction)Batch_Count,	1,	"Queue a Count for the given specifier." },
+	{ "Create",	(PyCFunction)Batch_Create,	1,	"Queue a Create for the given specifier." },
+	{ "Delete",	(PyCFunction)Batch_Delete,	1,	"Queue a Delete for the given specifier." },
+	{ "GetSuites",	(PyCFunction)Batch_GetSuites,	1,	"Queue a GetSuites for the given specifier." },
+	{ "SetString",	(PyCFunction)Batch_SetString,	1,	"Queue setting the given specifier to a string." },
+	{ "SetPath",	(PyCFunction)Batch_SetPath,	1,	"Queue setting the given specifier to a path." },
+	{ "SetColor",	(PyCFunction)Batch_SetColor,	1,	"Queue setting the given specifier to a color." },
+	{ "SetColour",	(PyCFunction)Batch_SetColor,	1,	"Queue setting the given specifier to a colour." },
+	{ "SetInt",	(PyCFunction)Batch_SetInt32,	1,	"Queue setting the given specifier to a number." },
+	{ "SetInt8",	(PyCFunction)Batch_SetInt8,	1,	"Queue setting the given specifier to an 8-bit number." },
+	{ "SetInt16",	(PyCFunction)Batch_SetInt16,	1,	"Queue setting the given specifier to a 16-bit number." },
+	{ "SetInt32",	(PyCFunction)Batch_SetInt32,	1,	"Queue setting the given specifier to a 32-bit number." },
+	{ "SetFloat",	(PyCFunction)Batch_SetFloat,	1,	"Queue setting the given specifier to a floating-point number." },
+	{ "SetDouble",	(PyCFunction)Batch_SetDouble,	1,	"Queue setting the given specifier to a double-precision floating-point number." },
+	{ "SetBool",	(PyCFunction)Batch_SetBool,	1,	"Queue setting the given specifier to 'true' or 'false'." },
+	{ "SetRect",	(PyCFunction)Batch_SetRect,	1,	"Queue setting the given specifier to a rectangle." },
+	{ "SetPoint",	(PyCFunction)Batch_SetPoint,	1,	"Queue setting the given specifier to a point." },
+	{ "Execute",	(PyCFunction)Batch_Execute,	1,	"Send the queued requests and return their replies in order." },
+	{ "Clear",	(PyCFunction)Batch_Clear,	1,	"Throw away the queued requests." },
+	{ NULL,		NULL }		// sentinel
+};
+
+static PyObject *Batch_getattr( BatchObject *self, char *name )
+{
+	return Py_FindMethod( BatchObject_methods, (PyObject *)self, name );
+}
+
+static PySequenceMethods Batch_as_sequence = {
+	(inquiry)Batch_length,	// sq_length
+	0,			// sq_concat
+	0,			// sq_repeat
+	0,			// sq_item
+	0,			// sq_slice
+	0,			// sq_ass_item
+	0,			// sq_ass_slice
+};
+
+PyTypeObject Batch_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"Batch",			// tp_name
+	sizeof(BatchObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)Batch_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)Batch_getattr, // tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	&Batch_as_sequence,	// tp_as_sequence
+	0,			// tp_as_mapping
+	0,			// tp_hash
+};
@@ -0,0 +1,40 @@
+// Batch
+//
+// The Batch object is used by heymodule to queue up a pile of scripting
+// requests for one application and send them all at once.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Batch_H
+#define PyHey_Batch_H
+
+#include "Python.h"
+
+#include "Hey.h"
+
+#include <support/List.h>
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	HeyObject *hey;		// where the requests go
+	BList *requests;	// queued BMessage *s, in submission order
+} BatchObject;
+
+// The object's type:
+extern PyTypeObject Batch_Type;
+
+// Macro for checking the type:
+#define BatchObject_Check(v)	((v)->ob_type == &Batch_Type)
+
+// Methods you can use.
+BatchObject *newBatchObject( HeyObject *hey );
+
+#endif
@@ -0,0 +1,505 @@
+// Connection
+//
+// HeyConnection carries scripting requests to a ScriptingAgent over a
+// socket; see Connection.h.
+//
+// Every call gets a run of request ids and a semaphore; its requests go
+// out back-to-back (taking turns with other threads at the frame level),
+// and the connection's reader thread hands each reply to the call whose
+// run its id falls in.  Replies for calls that have given up are
+// dropped.  If the agent hangs up, everybody still waiting is woken up
+// empty-handed.
+//
+// Serve() keeps its agents in a list, by address, so StopServing() can
+// find them again.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Connection.h"
+#include "Agent.h"
+#include "Hey.h"
+#include "Recorder.h"
+#include "StandIn.h"
+#include "Stats.h"
+#include "Wire.h"
+
+#include <app/AppDefs.h>
+#include <app/Messenger.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+// One request of a call.
+struct connection_waiter {
+	BMessage *reply;
+	bigtime_t sent;
+	bigtime_t arrived;
+	bool done;				// sem released for it, or given up on
+};
+
+// One call's worth of requests, with ids first .. first + count - 1.
+struct connection_call {
+	uint32 first;
+	int32 count;
+	sem_id sem;
+	connection_waiter *waiters;
+};
+
+// ======================================================================
+// HeyConnection
+// ======================================================================
+
+HeyConnection::HeyConnection( int the_sock, team_id the_team )
+	: sock( the_sock ),
+	  team( the_team ),
+	  address( NULL ),
+	  read_thread( -1 ),
+	  write_lock( "hey connection writes" ),
+	  lock( "hey connection" ),
+	  next_id( 1 ),
+	  dead( false )
+{
+	signature[0] = '\0';
+}
+
+HeyConnection::~HeyConnection()
+{
+	wire_shutdown( sock );
+	if( read_thread >= 0 ) {
+		status_t retval;
+		(void)wait_for_thread( read_thread, &retval );
+	}
+	wire_close( sock );
+
+	delete [] address;
+}
+
+// ----------------------------------------------------------------------
+status_t HeyConnection::Open( const char *where, HeyConnection **connection )
+{
+	*connection = NULL;
+
+	int sock;
+	status_t retval = wire_connect( where, &sock );
+	if( retval != B_OK ) return retval;
+
+	uint32 id;
+	BMessage hello;
+	retval = wire_read( sock, &id, &hello );
+	if( retval == B_OK && ( id != 0 || hello.what != HEY_WIRE_HELLO ) ) {
+		retval = B_BAD_VALUE;
+	}
+	if( retval != B_OK ) {
+		wire_close( sock );
+		return retval;
+	}
+
+	HeyConnection *conn;
+	try {
+		conn = new HeyConnection( sock, hello.FindInt32( "team" ) );
+		conn->address = new char[strlen( where ) + 1];
+		strcpy( conn->address, where );
+
+		const char *signature = hello.FindString( "signature" );
+		if( signature ) {
+			strncpy( conn->signature, signature, B_MIME_TYPE_LENGTH - 1 );
+			conn->signature[B_MIME_TYPE_LENGTH - 1] = '\0';
+		}
+	} catch ( bad_alloc &ex ) {
+		wire_close( sock );
+		return B_NO_MEMORY;
+	}
+
+	conn->read_thread = spawn_thread( reader, "hey connection",
+	                                  B_NORMAL_PRIORITY, conn );
+	if( conn->read_thread < B_OK ) {
+		retval = conn->read_thread;
+		conn->read_thread = -1;
+		delete conn;
+		return retval;
+	}
+	(void)resume_thread( conn->read_thread );
+
+	*connection = conn;
+	return B_OK;
+}
+
+team_id HeyConnection::Team( void ) const
+{
+	return team;
+}
+
+const char *HeyConnection::Signature( void ) const
+{
+	return signature;
+}
+
+const char *HeyConnection::Address( void ) const
+{
+	return address;
+}
+
+// ----------------------------------------------------------------------
+status_t HeyConnection::SendMessage( BMessage *request, BMessage *reply,
+                                     bigtime_t timeout )
+{
+	BMessage *got;
+	status_t retval = Exchange( &request, &got, 1, timeout, false );
+	if( got ) {
+		*reply = *got;
+		delete got;
+	}
+
+	return retval;
+}
+
+// ----------------------------------------------------------------------
+status_t HeyConnection::SendPipelined( BMessage **requests, BMessage **replies,
+                                       int32 count, bigtime_t timeout )
+{
+	return Exchange( requests, replies, count, timeout, true );
+}
+
+// ----------------------------------------------------------------------
+// Send everything, then wait for all of the replies.  These are recorded
+// (and counted) here, so the callers don't have to.
+status_t HeyConnection::Exchange( BMessage **requests, BMessage **replies,
+                                  int32 count, bigtime_t timeout,
+                                  bool counted )
+{
+	int32 idx;
+
+	for( idx = 0; idx < count; idx++ ) {
+		replies[idx] = NULL;
+	}
+	if( count < 1 ) return B_OK;
+
+	connection_call call;
+	call.count = count;
+	try {
+		call.waiters = new connection_waiter[count];
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+	for( idx = 0; idx < count; idx++ ) {
+		call.waiters[idx].reply = NULL;
+		call.waiters[idx].done = false;
+	}
+
+	call.sem = create_sem( 0, "hey connection replies" );
+	if( call.sem < B_OK ) {
+		delete [] call.waiters;
+		return call.sem;
+	}
+
+	lock.Lock();
+	if( dead ) {
+		lock.Unlock();
+		delete_sem( call.sem );
+		delete [] call.waiters;
+		return B_ERROR;
+	}
+	call.first = next_id;
+	next_id += count;
+	calls.AddItem( &call );
+	lock.Unlock();
+
+	// A write that fails still has to be counted if the reader has
+	// already released the semaphore for it (because the agent hung up).
+	int32 pending = 0;
+	write_lock.Lock();
+	for( idx = 0; idx < count; idx++ ) {
+		connection_waiter *waiter = &call.waiters[idx];
+		waiter->sent = system_time();
+		if( wire_write( sock, call.first + idx, *requests[idx] ) == B_OK ) {
+			pending++;
+		} else {
+			lock.Lock();
+			if( waiter->done ) {
+				pending++;
+			} else {
+				waiter->done = true;
+			}
+			lock.Unlock();
+		}
+	}
+	write_lock.Unlock();
+
+	status_t retval = B_OK;
+	if( pending > 0 ) {
+		if( timeout == B_INFINITE_TIMEOUT ) {
+			retval = acquire_sem_etc( call.sem, pending, 0, 0 );
+		} else {
+			retval = acquire_sem_etc( call.sem, pending, B_RELATIVE_TIMEOUT,
+			                          timeout );
+		}
+	}
+
+	// Once we're off the list the reader can't touch the call, so
+	// stragglers get dropped.
+	lock.Lock();
+	calls.RemoveItem( &call );
+	lock.Unlock();
+
+	delete_sem( call.sem );
+
+	// Requests that never got a reply waited until now.
+	bool missing = false;
+	bigtime_t now = system_time();
+	for( idx = 0; idx < count; idx++ ) {
+		connection_waiter *waiter = &call.waiters[idx];
+		replies[idx] = waiter->reply;
+		if( replies[idx] == NULL ) missing = true;
+
+		if( hey_recording ) {
+			record_exchange( team, *requests[idx], replies[idx],
+			                 waiter->sent, waiter->arrived );
+		}
+		if( counted ) {
+			stats_exchange( team, stats_command_for( requests[idx]->what ),
+			                requests[idx]->FlattenedSize(), replies[idx],
+			                retval,
+			                ( replies[idx] ? waiter->arrived : now ) -
+			                    waiter->sent );
+		}
+	}
+	delete [] call.waiters;
+
+	if( retval == B_TIMED_OUT || retval == B_WOULD_BLOCK ) return B_TIMED_OUT;
+	return missing ? B_ERROR : B_OK;
+}
+
+// ----------------------------------------------------------------------
+// Hand each reply to whoever's waiting for it, until the agent hangs up.
+int32 HeyConnection::reader( void *data )
+{
+	HeyConnection *conn = (HeyConnection *)data;
+
+	for( ;; ) {
+		BMessage *reply;
+		try {
+			reply = new BMessage;
+		} catch ( bad_alloc &ex ) {
+			break;
+		}
+
+		uint32 id;
+		if( wire_read( conn->sock, &id, reply ) != B_OK ) {
+			delete reply;
+			break;
+		}
+		bigtime_t arrived = system_time();
+
+		conn->lock.Lock();
+		for( int32 idx = 0; idx < conn->calls.CountItems(); idx++ ) {
+			connection_call *call = (connection_call *)conn->calls.ItemAt( idx );
+			uint32 offset = id - call->first;
+			if( offset < (uint32)call->count ) {
+				connection_waiter *waiter = &call->waiters[offset];
+				if( !waiter->done ) {
+					waiter->reply = reply;
+					waiter->arrived = arrived;
+					waiter->done = true;
+					reply = NULL;
+					(void)release_sem( call->sem );
+				}
+				break;
+			}
+		}
+		conn->lock.Unlock();
+
+		delete reply;		// nobody's waiting for it any more
+	}
+
+	conn->lock.Lock();
+	conn->dead = true;
+	for( int32 idx = 0; idx < conn->calls.CountItems(); idx++ ) {
+		connection_call *call = (connection_call *)conn->calls.ItemAt( idx );
+		for( int32 item = 0; item < call->count; item++ ) {
+			if( !call->waiters[item].done ) {
+				call->waiters[item].done = true;
+				(void)release_sem( call->sem );
+			}
+		}
+	}
+	conn->lock.Unlock();
+
+	return B_OK;
+}
+
+// ======================================================================
+// Module functions
+// ======================================================================
+
+// Agents started by Serve().
+struct served_agent {
+	ScriptingAgent *agent;
+	BMessenger standin;		// the stand-in we started for it, if any
+};
+
+static BList served;
+
+static PyObject *socket_error( const char *address, status_t retval )
+{
+	if( retval == B_NO_MEMORY ) {
+		return PyErr_NoMemory();
+	}
+
+	char buff[256];
+	sprintf( buff, "can't use %.128s: %.64s", address, strerror( retval ) );
+	PyErr_SetString( PyExc_IOError, buff );
+	return NULL;
+}
+
+static served_agent *find_served( const char *address )
+{
+	for( int32 idx = 0; idx < served.CountItems(); idx++ ) {
+		served_agent *item = (served_agent *)served.ItemAt( idx );
+		if( strcmp( item->agent->Address(), address ) == 0 ) {
+			return item;
+		}
+	}
+
+	return NULL;
+}
+
+// ----------------------------------------------------------------------
+// Connect( address ): a Hey object for the target of the agent at
+// address.
+PyObject *Connection_Connect( PyObject *self, PyObject *args )
+{
+	char *address;
+	if( !PyArg_ParseTuple( args, "s", &address ) ) {
+		return NULL;
+	}
+
+	HeyConnection *connection;
+	status_t retval;
+	Py_BEGIN_ALLOW_THREADS
+	retval = HeyConnection::Open( address, &connection );
+	Py_END_ALLOW_THREADS
+
+	if( retval != B_OK ) {
+		return socket_error( address, retval );
+	}
+
+	return (PyObject *)newHeyObjectFromConnection( connection );
+}
+
+// ----------------------------------------------------------------------
+// Serve( address, target = None ): answer requests for target that come
+// in on address.  target is a Hey object, or anything you could make one
+// from; without one, a StandIn() with the usual size is served.
+PyObject *Connection_Serve( PyObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { "address", "target", NULL };
+	char *address;
+	PyObject *target = Py_None;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "s|O", kwlist, &address,
+	                                  &target ) ) {
+		return NULL;
+	}
+
+	if( find_served( address ) ) {
+		PyErr_SetString( PyExc_ValueError, "already serving that address" );
+		return NULL;
+	}
+
+	BMessenger messenger;
+	BMessenger standin;
+	if( target == Py_None ) {
+		if( start_standin( standin_defaults, &standin ) != B_OK ) {
+			return PyErr_NoMemory();
+		}
+		messenger = standin;
+	} else {
+		HeyObject *hey;
+		if( HeyObject_Check( target ) ) {
+			Py_INCREF( target );
+			hey = (HeyObject *)target;
+		} else {
+			PyObject *hey_args = Py_BuildValue( "(O)", target );
+			hey = hey_args ? newHeyObject( hey_args ) : NULL;
+			Py_XDECREF( hey_args );
+			if( hey == NULL ) {
+				return NULL;
+			}
+		}
+
+		bool remote = ( hey->connection != NULL );
+		messenger = *hey->target;
+		Py_DECREF( hey );
+
+		if( remote ) {
+			PyErr_SetString( PyExc_ValueError,
+			                 "can't serve a target that's already on a socket" );
+			return NULL;
+		}
+	}
+
+	served_agent *item = NULL;
+	try {
+		item = new served_agent;
+		item->agent = new ScriptingAgent( messenger );
+	} catch ( bad_alloc &ex ) {
+		delete item;
+		if( standin.IsValid() ) {
+			(void)standin.SendMessage( B_QUIT_REQUESTED );
+		}
+		return PyErr_NoMemory();
+	}
+	item->standin = standin;
+
+	status_t retval = item->agent->Listen( address );
+	if( retval != B_OK ) {
+		delete item->agent;
+		delete item;
+		if( standin.IsValid() ) {
+			(void)standin.SendMessage( B_QUIT_REQUESTED );
+		}
+		return socket_error( address, retval );
+	}
+
+	served.AddItem( item );
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+// ----------------------------------------------------------------------
+// StopServing( address ): hang up on everybody connected to address, and
+// stop listening.
+PyObject *Connection_StopServing( PyObject *self, PyObject *args )
+{
+	char *address;
+	if( !PyArg_ParseTuple( args, "s", &address ) ) {
+		return NULL;
+	}
+
+	served_agent *item = find_served( address );
+	if( item == NULL ) {
+		PyErr_SetString( PyExc_ValueError, "not serving that address" );
+		return NULL;
+	}
+	served.RemoveItem( item );
+
+	// The agent waits for its threads, and those don't need us.
+	Py_BEGIN_ALLOW_THREADS
+	delete item->agent;
+	if( item->standin.IsValid() ) {
+		(void)item->standin.SendMessage( B_QUIT_REQUESTED );
+	}
+	Py_END_ALLOW_THREADS
+
+	delete item;
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
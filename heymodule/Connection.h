@@ -0,0 +1,93 @@
+// Connection
+//
+// A HeyConnection is used by heymodule to talk to a ScriptingAgent (see
+// Agent.h) over a socket instead of a port.  Hey objects from Connect()
+// have one, and everything they send goes over it; any number of
+// threads can have requests waiting at once, and the replies are matched
+// up with them as they come back.
+//
+// Sockets don't have send timeouts, so only the reply timeout counts.
+// Futures need a port to reply to, so the Async methods don't work over
+// a connection.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Connection_H
+#define PyHey_Connection_H
+
+#include "Python.h"
+
+#include <app/Message.h>
+#include <storage/Mime.h>
+#include <support/List.h>
+#include <support/Locker.h>
+#include <kernel/OS.h>
+
+class HeyConnection {
+public:
+	// Connect to the agent at address, and wait for it to say hello.
+	static status_t Open( const char *address, HeyConnection **connection );
+
+	// Hangs up; nobody can be waiting for replies by now.
+	~HeyConnection();
+
+	// The agent's target's team, and its signature ("" if the agent
+	// didn't say); the team is in the agent's machine, so don't ask the
+	// local roster about it.
+	team_id Team( void ) const;
+	const char *Signature( void ) const;
+
+	const char *Address( void ) const;
+
+	// Like BMessenger::SendMessage(); B_ERROR if the agent hung up.  This
+	// is only for send_and_wait(), which counts the request itself.
+	status_t SendMessage( BMessage *request, BMessage *reply,
+	                      bigtime_t timeout = B_INFINITE_TIMEOUT );
+
+	// Like send_pipelined(): replies[i] is the reply to requests[i] (yours
+	// to delete), or NULL; B_TIMED_OUT if any are missing because time
+	// ran out.  The requests are recorded and counted here.
+	status_t SendPipelined( BMessage **requests, BMessage **replies,
+	                        int32 count,
+	                        bigtime_t timeout = B_INFINITE_TIMEOUT );
+
+private:
+	HeyConnection( int sock, team_id team );
+
+	// SendPipelined(), counting the requests if counted is true.
+	status_t Exchange( BMessage **requests, BMessage **replies, int32 count,
+	                   bigtime_t timeout, bool counted );
+
+	static int32 reader( void *data );
+
+	int sock;
+	team_id team;
+	char signature[B_MIME_TYPE_LENGTH];
+	char *address;
+	thread_id read_thread;
+
+	BLocker write_lock;		// one frame at a time
+
+	BLocker lock;			// everything below
+	BList calls;			// connection_call *s waiting for replies
+	uint32 next_id;
+	bool dead;				// the agent hung up
+};
+
+// Module functions:
+//
+// Connect( address )
+// Serve( address, target = None )
+// StopServing( address )
+PyObject *Connection_Connect( PyObject *self, PyObject *args );
+PyObject *Connection_Serve( PyObject *self, PyObject *args, PyObject *kwds );
+PyObject *Connection_StopServing( PyObject *self, PyObject *args );
+
+#endif
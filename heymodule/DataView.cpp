@@ -0,0 +1,106 @@
+// DataView
+//
+// The DataView object is used by heymodule to let Python read a chunk of
+// reply data in place, through the buffer interface, instead of copying
+// it into a string.
+//
+// Python only ever sees a regular buffer object (the kind the buffer()
+// built-in makes); it slices, compares and str()s like you'd expect.  The
+// DataView underneath it keeps the Reply, and so the BMessage holding the
+// data, alive.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "DataView.h"
+
+// ======================================================================
+// DataView object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+PyObject *newDataView( PyObject *owner, const void *ptr, ssize_t size )
+{
+	DataViewObject *self;
+	self = PyObject_NEW( DataViewObject, &DataView_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	Py_INCREF( owner );
+	self->owner = owner;
+	self->ptr = ptr;
+	self->size = size;
+
+	PyObject *buffer = PyBuffer_FromObject( (PyObject *)self, 0,
+				Py_END_OF_BUFFER );
+	Py_DECREF( self );
+
+	return buffer;
+}
+
+// ----------------------------------------------------------------------
+// Delete a DataView object
+static void DataView_dealloc( DataViewObject *self )
+{
+	Py_DECREF( self->owner );
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Buffer interface; there's only ever one segment, and you can't write
+// to it.
+static int DataView_getreadbuffer( DataViewObject *self, int segment,
+                                   void **ptr )
+{
+	if( segment != 0 ) {
+		PyErr_SetString( PyExc_SystemError,
+				"accessing non-existent DataView segment" );
+		return -1;
+	}
+
+	*ptr = (void *)self->ptr;
+	return (int)self->size;
+}
+
+static int DataView_getsegcount( DataViewObject *self, int *lenp )
+{
+	if( lenp ) *lenp = (int)self->size;
+	return 1;
+}
+
+static PyBufferProcs DataView_as_buffer = {
+	(getreadbufferproc)DataView_getreadbuffer,	// bf_getreadbuffer
+	0,											// bf_getwritebuffer
+	(getsegcountproc)DataView_getsegcount,		// bf_getsegcount
+};
+
+PyTypeObject DataView_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"DataView",			// tp_name
+	sizeof(DataViewObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)DataView_dealloc, // tp_dealloc
+	0,			// tp_print
+	0,			// tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	0,			// tp_as_sequence
+	0,			// tp_as_mapping
+	0,			// tp_hash
+	0,			// tp_call
+	0,			// tp_str
+	0,			// tp_getattro
+	0,			// tp_setattro
+	&DataView_as_buffer,	// tp_as_buffer
+};
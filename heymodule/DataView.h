@@ -0,0 +1,43 @@
+// DataView
+//
+// The DataView object is used by heymodule to let Python read a chunk of
+// reply data in place, through the buffer interface, instead of copying
+// it into a string.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_DataView_H
+#define PyHey_DataView_H
+
+#include "Python.h"
+
+#include <sys/types.h>
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	PyObject *owner;	// whatever owns the data; we keep it alive
+	const void *ptr;
+	ssize_t size;
+} DataViewObject;
+
+// The object's type:
+extern PyTypeObject DataView_Type;
+
+// Macro for checking the type:
+#define DataViewObject_Check(v)	((v)->ob_type == &DataView_Type)
+
+// Methods you can use.
+//
+// Return a read-only Python buffer object for size bytes at ptr; ptr has
+// to stay put for as long as owner is alive.
+PyObject *newDataView( PyObject *owner, const void *ptr, ssize_t size );
+
+#endif
@@ -0,0 +1,348 @@
+// FanOut
+//
+// Fan-out is used by heymodule to expand "Title of Window *" (or
+// "Title of Window [0 to 3]") into one request per window, since targets
+// only understand ranges on the last specifier and don't know "*" at all.
+//
+// The specifier stack is expanded from the outside in.  Ranges just turn
+// into index specifiers; a "*" needs a Count first, and the Counts for
+// every request at that level go out back-to-back, like the final
+// requests do.  So "Title of View * of Window *" costs three round trips'
+// worth of waiting, not one per window and view.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "FanOut.h"
+#include "Reply.h"
+#include "Suites.h"
+#include "SpecifierParser.h"
+
+#include <support/List.h>
+#include <new>
+#include <stdio.h>
+
+// Nobody wants a million requests by accident.
+static const int32 max_fanout = 65536;
+
+static void free_requests( BList &requests );
+static bool send_all( HeyObject *hey, BList &requests, BMessage **replies,
+                      bigtime_t send_timeout, bigtime_t reply_timeout,
+                      const char *name );
+static bool expand_level( HeyObject *hey, BList &work, int32 level,
+                          int32 levels, bigtime_t send_timeout,
+                          bigtime_t reply_timeout );
+
+// ----------------------------------------------------------------------
+bool needs_fanout( const BMessage &request )
+{
+	int32 levels = count_message_items( request, "specifiers" );
+	for( int32 level = 0; level < levels; level++ ) {
+		BMessage spec;
+		if( request.FindMessage( "specifiers", level, &spec ) != B_OK ) {
+			continue;
+		}
+
+		if( spec.what == HEY_ALL_SPECIFIER ) return true;
+		if( level > 0 && spec.what == B_RANGE_SPECIFIER ) return true;
+	}
+
+	return false;
+}
+
+bool refuse_fanout( const BMessage &request )
+{
+	if( !needs_fanout( request ) ) return false;
+
+	PyErr_SetString( PyExc_ValueError,
+			"fan-out specifiers only work with the blocking methods" );
+	return true;
+}
+
+// ----------------------------------------------------------------------
+static void free_requests( BList &requests )
+{
+	for( int32 idx = 0; idx < requests.CountItems(); idx++ ) {
+		delete (BMessage *)requests.ItemAt( idx );
+	}
+	requests.MakeEmpty();
+}
+
+// ----------------------------------------------------------------------
+// Send everything in requests back-to-back; replies has to have room for
+// all of them.  Returns false (with an exception set, and replies
+// deleted) unless every reply came back.
+static bool send_all( HeyObject *hey, BList &requests, BMessage **replies,
+                      bigtime_t send_timeout, bigtime_t reply_timeout,
+                      const char *name )
+{
+	int32 count = requests.CountItems();
+	BMessage **msgs = (BMessage **)requests.Items();
+	status_t retval;
+
+	Py_BEGIN_ALLOW_THREADS
+	retval = hey_send_pipelined( hey, msgs, replies, count,
+	                             reply_timeout, send_timeout );
+	Py_END_ALLOW_THREADS
+
+	bool missing = false;
+	for( int32 idx = 0; idx < count; idx++ ) {
+		if( replies[idx] == NULL ) missing = true;
+	}
+	if( !missing ) return true;
+
+	for( int32 idx = 0; idx < count; idx++ ) {
+		delete replies[idx];
+		replies[idx] = NULL;
+	}
+
+	char buff[128];
+	if( retval == B_TIMED_OUT ) {
+		sprintf( buff, "timed out waiting for reply to %.64s", name );
+		PyErr_SetString( HeyTimeoutError, buff );
+	} else {
+		sprintf( buff, "error sending %.64s message", name );
+		PyErr_SetString( PyExc_RuntimeError, buff );
+	}
+
+	return false;
+}
+
+// ----------------------------------------------------------------------
+// Replace the "*" or range at level in every request in work with one
+// index specifier per item.
+static bool expand_level( HeyObject *hey, BList &work, int32 level,
+                          int32 levels, bigtime_t send_timeout,
+                          bigtime_t reply_timeout )
+{
+	int32 count = work.CountItems();
+	BMessage spec;
+	if( count == 0 ||
+		( (BMessage *)work.ItemAt( 0 ) )->FindMessage( "specifiers", level,
+		                                               &spec ) != B_OK ) {
+		return true;
+	}
+
+	// Targets can cope with a range on the last specifier themselves.
+	bool range = ( spec.what == B_RANGE_SPECIFIER && level > 0 );
+	if( !range && spec.what != HEY_ALL_SPECIFIER ) {
+		return true;
+	}
+
+	const char *property = spec.FindString( "property" );
+	if( property == NULL ) {
+		PyErr_SetString( PyExc_RuntimeError, "specifier has no property" );
+		return false;
+	}
+
+	// How many items does each request get?
+	int32 *firsts;
+	try {
+		firsts = new int32[count * 2];
+	} catch ( bad_alloc &ex ) {
+		(void)PyErr_NoMemory();
+		return false;
+	}
+	int32 *runs = firsts + count;
+
+	bool ok = true;
+	if( range ) {
+		int32 first = spec.FindInt32( "index" );
+		int32 run = spec.FindInt32( "range" );
+		for( int32 idx = 0; idx < count; idx++ ) {
+			firsts[idx] = first;
+			runs[idx] = run;
+		}
+	} else {
+		// Count them, for every request at once.
+		BList counts;
+		for( int32 idx = 0; ok && idx < count; idx++ ) {
+			BMessage *from = (BMessage *)work.ItemAt( idx );
+			BMessage *msg = NULL;
+			try {
+				msg = new BMessage( B_COUNT_PROPERTIES );
+			} catch ( bad_alloc &ex ) {
+				(void)PyErr_NoMemory();
+				ok = false;
+				break;
+			}
+			counts.AddItem( msg );
+
+			msg->AddSpecifier( property );
+			for( int32 outer = level + 1; outer < levels; outer++ ) {
+				BMessage of;
+				if( from->FindMessage( "specifiers", outer, &of ) == B_OK ) {
+					msg->AddSpecifier( &of );
+				}
+			}
+		}
+
+		BMessage **replies = NULL;
+		if( ok ) {
+			try {
+				replies = new BMessage *[count];
+			} catch ( bad_alloc &ex ) {
+				(void)PyErr_NoMemory();
+				ok = false;
+			}
+		}
+
+		if( ok ) {
+			ok = send_all( hey, counts, replies, send_timeout, reply_timeout,
+			               "Count" );
+		}
+
+		for( int32 idx = 0; ok && idx < count; idx++ ) {
+			firsts[idx] = 0;
+			if( replies[idx]->what != B_REPLY ) {
+				(void)explain_reply( *replies[idx] );	// sets the exception
+				ok = false;
+			} else if( replies[idx]->FindInt32( "result", &runs[idx] ) != B_OK ) {
+				PyErr_SetString( PyExc_RuntimeError,
+				                 "target didn't return a count" );
+				ok = false;
+			}
+		}
+
+		if( replies ) {
+			for( int32 idx = 0; idx < count; idx++ ) {
+				delete replies[idx];
+			}
+			delete [] replies;
+		}
+		free_requests( counts );
+	}
+
+	int32 total = 0;
+	for( int32 idx = 0; ok && idx < count; idx++ ) {
+		if( runs[idx] < 0 ) runs[idx] = 0;
+		total += runs[idx];
+		if( total > max_fanout ) {
+			PyErr_SetString( PyExc_ValueError, "too many requests to fan out" );
+			ok = false;
+		}
+	}
+
+	// Now make the new requests.
+	BList expanded;
+	for( int32 idx = 0; ok && idx < count; idx++ ) {
+		BMessage *from = (BMessage *)work.ItemAt( idx );
+		for( int32 item = 0; item < runs[idx]; item++ ) {
+			BMessage index( B_INDEX_SPECIFIER );
+			index.AddString( "property", property );
+			index.AddInt32( "index", firsts[idx] + item );
+
+			BMessage *msg = NULL;
+			try {
+				msg = new BMessage( *from );
+			} catch ( bad_alloc &ex ) {
+				(void)PyErr_NoMemory();
+				ok = false;
+				break;
+			}
+			expanded.AddItem( msg );
+
+			if( msg->ReplaceMessage( "specifiers", level, &index ) != B_OK ) {
+				PyErr_SetString( PyExc_RuntimeError,
+				                 "unable to expand specifier" );
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	delete [] firsts;
+
+	if( !ok ) {
+		free_requests( expanded );
+		return false;
+	}
+
+	free_requests( work );
+	work.AddList( &expanded );
+	return true;
+}
+
+// ----------------------------------------------------------------------
+PyObject *send_fanout( HeyObject *hey, const BMessage &request,
+                       const char *name, bigtime_t send_timeout,
+                       bigtime_t reply_timeout, int validate, int lazy,
+                       int packed )
+{
+	BList work;
+	try {
+		work.AddItem( new BMessage( request ) );
+	} catch ( bad_alloc &ex ) {
+		return PyErr_NoMemory();
+	}
+
+	// From the outside (the last specifier) in.
+	int32 levels = count_message_items( request, "specifiers" );
+	for( int32 level = levels - 1; level >= 0; level-- ) {
+		if( !expand_level( hey, work, level, levels, send_timeout,
+		                   reply_timeout ) ) {
+			free_requests( work );
+			return NULL;
+		}
+	}
+
+	int32 count = work.CountItems();
+	for( int32 idx = 0; idx < count; idx++ ) {
+		if( !validate_request( hey, (BMessage *)work.ItemAt( idx ), validate,
+		                       send_timeout, reply_timeout ) ) {
+			free_requests( work );
+			return NULL;
+		}
+	}
+
+	PyObject *results = PyList_New( count );
+	BMessage **replies = NULL;
+	if( results && count > 0 ) {
+		try {
+			replies = new BMessage *[count];
+		} catch ( bad_alloc &ex ) {
+			Py_DECREF( results );
+			results = PyErr_NoMemory();
+		}
+	}
+
+	if( replies && !send_all( hey, work, replies, send_timeout,
+	                          reply_timeout, name ) ) {
+		Py_DECREF( results );
+		results = NULL;
+		delete [] replies;
+		replies = NULL;
+	}
+	free_requests( work );
+
+	// Every reply gets what it would have got on its own; the first
+	// error is the one you see.
+	for( int32 idx = 0; replies && idx < count; idx++ ) {
+		PyObject *obj = NULL;
+		if( results ) {
+			if( lazy ) {
+				obj = lazy_reply( replies[idx], packed );
+				replies[idx] = NULL;
+			} else {
+				obj = explain_reply( *replies[idx], packed );
+			}
+
+			if( obj == NULL ) {
+				Py_DECREF( results );
+				results = NULL;
+			} else {
+				(void)PyList_SetItem( results, idx, obj );
+			}
+		}
+		delete replies[idx];
+	}
+	delete [] replies;
+
+	return results;
+}
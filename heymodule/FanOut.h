@@ -0,0 +1,44 @@
+// FanOut
+//
+// Fan-out is used by heymodule to expand "Title of Window *" (or
+// "Title of Window [0 to 3]") into one request per window, since targets
+// only understand ranges on the last specifier and don't know "*" at all.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_FanOut_H
+#define PyHey_FanOut_H
+
+#include "Python.h"
+
+#include "Hey.h"
+
+#include <app/Message.h>
+#include <kernel/OS.h>
+
+// Does request have a "*" anywhere, or a range anywhere but the last
+// specifier?
+bool needs_fanout( const BMessage &request );
+
+// For the methods that send requests as they are: if request
+// needs_fanout(), raise ValueError and return true.
+bool refuse_fanout( const BMessage &request );
+
+// Expand request into one request for every item the "*"s and ranges
+// cover (asking the target how many there are for each "*"), check them
+// against the suites if validate says to, send them all back-to-back and
+// return a list of what each one would have returned on its own.  name is
+// the command, for error messages.
+PyObject *send_fanout( HeyObject *hey, const BMessage &request,
+                       const char *name, bigtime_t send_timeout,
+                       bigtime_t reply_timeout, int validate, int lazy,
+                       int packed );
+
+#endif
@@ -0,0 +1,319 @@
+// Future
+//
+// The Future object is used by heymodule to hold on to a scripting
+// request that's been sent but hasn't been answered yet, so Python can
+// get on with something else (like talking to other applications) while
+// the target thinks about it.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Future.h"
+#include "Hey.h"
+#include "Reply.h"
+#include "Recorder.h"
+#include "Stats.h"
+#include "Wire.h"
+
+static bool collect_reply( FutureObject *self );
+static void forget_handler( FutureObject *self );
+
+// ======================================================================
+// Future object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Send the request and create a Future for its reply.
+FutureObject *newFutureObject( const BMessenger &target, BMessage *request,
+                               const char *name, bigtime_t send_timeout,
+                               bigtime_t reply_timeout, int lazy )
+{
+	FutureObject *self;
+	self = PyObject_NEW( FutureObject, &Future_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	self->handler = NULL;
+	self->done = -1;
+	self->notify[0] = -1;
+	self->notify[1] = -1;
+	self->reply = NULL;
+	self->result = NULL;
+	self->timeout = reply_timeout;
+	self->lazy = lazy;
+	self->recorded = NULL;
+	self->team = -1;
+	self->sent = 0;
+	self->command = -1;
+	self->size = 0;
+
+	BLooper *looper = reply_looper();
+	self->done = create_sem( 0, "hey future" );
+	if( looper == NULL || self->done < B_OK || wire_pair( self->notify ) != B_OK ) {
+		Py_DECREF( self );
+		PyErr_SetString( PyExc_RuntimeError,
+				"unable to create reply handler" );
+		return NULL;
+	}
+
+	try {
+		self->handler = new ReplyHandler( self->done, self->notify[1] );
+	} catch ( bad_alloc &ex ) {
+		Py_DECREF( self );
+		return (FutureObject *)PyErr_NoMemory();
+	}
+
+	if( !looper->Lock() ) {
+		delete self->handler;
+		self->handler = NULL;
+		Py_DECREF( self );
+		PyErr_SetString( PyExc_RuntimeError,
+				"unable to create reply handler" );
+		return NULL;
+	}
+	looper->AddHandler( self->handler );
+	looper->Unlock();
+
+	// The request is the caller's, so keep a copy for the recorder; it's
+	// recorded (and counted) once the handler's forgotten.
+	if( hey_recording ) {
+		try {
+			self->recorded = new BMessage( *request );
+		} catch ( bad_alloc &ex ) {
+			self->recorded = NULL;
+		}
+	}
+	self->team = target.Team();
+	self->size = request->FlattenedSize();
+	self->sent = system_time();
+
+	status_t retval = target.SendMessage( request, self->handler, send_timeout );
+	if( retval != B_OK ) {
+		stats_exchange( self->team, stats_command( name ), self->size, NULL,
+		                retval, system_time() - self->sent );
+
+		char buff[64];
+		if( retval == B_TIMED_OUT || retval == B_WOULD_BLOCK ) {
+			sprintf( buff, "timed out sending %.32s message", name );
+			PyErr_SetString( HeyTimeoutError, buff );
+		} else {
+			sprintf( buff, "error sending %.32s message", name );
+			PyErr_SetString( PyExc_RuntimeError, buff );
+		}
+
+		delete self->recorded;
+		self->recorded = NULL;
+		Py_DECREF( self );
+		return NULL;
+	}
+	self->command = stats_command( name );
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Delete a Future object
+static void Future_dealloc( FutureObject *self )
+{
+	forget_handler( self );
+
+	if( self->notify[0] >= 0 ) wire_close( self->notify[0] );
+	if( self->notify[1] >= 0 ) wire_close( self->notify[1] );
+	if( self->done >= B_OK ) delete_sem( self->done );
+
+	delete self->reply;
+	Py_XDECREF( self->result );
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Pull the handler out of the reply looper; if the reply turns up after
+// this, the looper just drops it.
+static void forget_handler( FutureObject *self )
+{
+	if( self->handler == NULL ) return;
+
+	BLooper *looper = reply_looper();
+	if( looper->Lock() ) {
+		if( self->reply == NULL ) {
+			self->reply = self->handler->DetachReply();
+		}
+		looper->RemoveHandler( self->handler );
+		looper->Unlock();
+	}
+
+	if( self->recorded ) {
+		record_exchange( self->team, *self->recorded, self->reply,
+		                 self->sent, self->handler->Arrived() );
+		delete self->recorded;
+		self->recorded = NULL;
+	}
+
+	// A reply that hasn't turned up by now never will, as far as we know.
+	if( self->command >= 0 ) {
+		bigtime_t arrived = self->reply ? self->handler->Arrived()
+		                                : system_time();
+		stats_exchange( self->team, self->command, self->size, self->reply,
+		                B_TIMED_OUT, arrived - self->sent );
+		self->command = -1;
+	}
+
+	delete self->handler;
+	self->handler = NULL;
+}
+
+// ----------------------------------------------------------------------
+// If the reply has arrived, take it from the handler; returns true if
+// we've got it.
+static bool collect_reply( FutureObject *self )
+{
+	if( self->reply != NULL || self->result != NULL ) return true;
+	if( self->handler == NULL ) return false;
+
+	BLooper *looper = reply_looper();
+	if( !looper->Lock() ) return false;
+
+	bool arrived = self->handler->HasReply();
+	looper->Unlock();
+
+	if( arrived ) {
+		forget_handler( self );
+	}
+
+	return self->reply != NULL;
+}
+
+// ----------------------------------------------------------------------
+// Has the reply arrived yet?  Never blocks.
+static PyObject *Future_Done( FutureObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return PyInt_FromLong( collect_reply( self ) ? 1 : 0 );
+}
+
+// ----------------------------------------------------------------------
+// Wait for the reply and return what the blocking method would have.
+//
+// Call with an optional timeout in seconds; without one, this waits as
+// long as the Hey object's reply timeout.  If the target didn't like the
+// request, you get the same exception the blocking method would have
+// raised; if it doesn't answer in time, you get a TimeoutError.
+static PyObject *Future_Result( FutureObject *self, PyObject *args )
+{
+	double seconds = -1.0;
+	if( !PyArg_ParseTuple( args, "|d", &seconds ) ) {
+		return NULL;
+	}
+
+	if( self->result ) {
+		Py_INCREF( self->result );
+		return self->result;
+	}
+
+	if( !collect_reply( self ) ) {
+		if( self->handler == NULL ) {
+			PyErr_SetString( PyExc_RuntimeError, "no reply" );
+			return NULL;
+		}
+
+		bigtime_t timeout = self->timeout;
+		if( seconds >= 0.0 ) {
+			timeout = (bigtime_t)( seconds * 1000000.0 );
+		}
+
+		status_t retval;
+		Py_BEGIN_ALLOW_THREADS
+		if( timeout == B_INFINITE_TIMEOUT ) {
+			retval = acquire_sem( self->done );
+		} else {
+			retval = acquire_sem_etc( self->done, 1, B_RELATIVE_TIMEOUT,
+						timeout );
+		}
+		Py_END_ALLOW_THREADS
+
+		// Let anyone else waiting on this Future have a look too.
+		if( retval == B_OK ) (void)release_sem( self->done );
+
+		if( retval != B_OK || !collect_reply( self ) ) {
+			PyErr_SetString( HeyTimeoutError,
+				        "timed out waiting for reply" );
+			return NULL;
+		}
+
+		if( self->result ) {
+			Py_INCREF( self->result );
+			return self->result;
+		}
+	}
+
+	PyObject *obj;
+	if( self->lazy && self->reply->what == B_REPLY ) {
+		// The Reply object takes the message over.
+		obj = (PyObject *)newReplyObject( self->reply );
+		self->reply = NULL;
+	} else {
+		obj = explain_reply( *self->reply );
+	}
+	if( obj == NULL ) {
+		return NULL;
+	}
+
+	self->result = obj;
+	Py_INCREF( self->result );
+	return self->result;
+}
+
+// ----------------------------------------------------------------------
+// The socket that becomes readable once the reply is in; hand the Future
+// to select.select() with everything else you're waiting on.
+static PyObject *Future_fileno( FutureObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return PyInt_FromLong( self->notify[0] );
+}
+
+// ----------------------------------------------------------------------
+// Method table and whatnot for the Future object.
+static PyMethodDef FutureObject_methods[] = {
+	{ "Done",	(PyCFunction)Future_Done,	1,	"Return true if the reply has arrived." },
+	{ "Result",	(PyCFunction)Future_Result,	1,	"Wait for the reply and return it." },
+	{ "fileno",	(PyCFunction)Future_fileno,	1,	"Return a file descriptor that's readable once the reply has arrived." },
+	{ NULL,		NULL }		// sentinel
+};
+
+static PyObject *Future_getattr( FutureObject *self, char *name )
+{
+	return Py_FindMethod( FutureObject_methods, (PyObject *)self, name );
+}
+
+PyTypeObject Future_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"Future",			// tp_name
+	sizeof(FutureObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)Future_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)Future_getattr, // tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	0,			// tp_as_sequence
+	0,			// tp_as_mapping
+	0,			// tp_hash
+};
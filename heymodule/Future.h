@@ -0,0 +1,60 @@
+// Future
+//
+// The Future object is used by heymodule to hold on to a scripting
+// request that's been sent but hasn't been answered yet.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Future_H
+#define PyHey_Future_H
+
+#include "Python.h"
+
+#include "ReplyHandler.h"
+
+#include <app/Message.h>
+#include <app/Messenger.h>
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	ReplyHandler *handler;	// waiting for the reply; NULL once we've got it
+	sem_id done;			// released when the reply arrives
+	int notify[2];			// sockets; notify[0] is readable when the reply arrives
+	BMessage *reply;		// the reply, once it's been collected
+	PyObject *result;		// explain_reply()'s answer, once we've asked
+	bigtime_t timeout;		// how long Result() waits by default
+	int lazy;				// Result() gives back a Reply object
+	BMessage *recorded;		// copy of the request, if we're recording
+	team_id team;			// the target's team, for the recorder and stats
+	bigtime_t sent;			// when the request went out, ditto
+	int command;			// what stats counts it as; -1 once it's counted
+	ssize_t size;			// the request's flattened size, for stats
+} FutureObject;
+
+// The object's type:
+extern PyTypeObject Future_Type;
+
+// Macro for checking the type:
+#define FutureObject_Check(v)	((v)->ob_type == &Future_Type)
+
+// Methods you can use.
+//
+// Sends request to target and returns a Future for its reply; the request
+// is still yours.  name is used in the error message if the send fails,
+// reply_timeout is how long Result() will wait if you don't tell it, and
+// if lazy is set, Result() returns a Reply object.
+FutureObject *newFutureObject( const BMessenger &target, BMessage *request,
+                               const char *name,
+                               bigtime_t send_timeout = B_INFINITE_TIMEOUT,
+                               bigtime_t reply_timeout = B_INFINITE_TIMEOUT,
+                               int lazy = 0 );
+
+#endif
@@ -14,6 +14,20 @@
 
 #include "Hey.h"
 #include "Specifier.h"
+#include "Batch.h"
+#include "Connection.h"
+#include "Future.h"
+#include "TeamIndex.h"
+#include "Reply.h"
+#include "Iterator.h"
+#include "Suites.h"
+#include "Marshal.h"
+#include "FanOut.h"
+#include "Proxy.h"
+#include "MessageWalker.h"
+#include "Recorder.h"
+#include "ReplyHandler.h"
+#include "Stats.h"
 
 #include <app/Messenger.h>
 #include <app/Message.h>
@@ -24,24 +38,23 @@
 #include <interface/GraphicsDefs.h>
 #include <string.h>
 
+// ----------------------------------------------------------------------
+// The timeouts new Hey objects start with; see SetDefaultTimeouts().
+static bigtime_t default_send_timeout = B_INFINITE_TIMEOUT;
+static bigtime_t default_reply_timeout = B_INFINITE_TIMEOUT;
+
 // ----------------------------------------------------------------------
 // Free nose jobs for everyone!
 static PyObject *IOError_file( char *error, char *path, status_t val = B_ERROR );
 static PyObject *Launch_error( char *signature, status_t val = B_ERROR );
 static PyObject *UnknownObj_error( type_code type, void *ptr, ssize_t size );
 
-static PyObject *msg_to_dict( const BMessage &msg );
 static PyObject *build_command_string( uint32 cmd );
 static PyObject *build_specifier_string( uint32 spec );
 static PyObject *build_property_tuple( const property_info& prop );
-static PyObject *build_property_info_dict( const BPropertyInfo& pi );
 static PyObject *build_suite_dict( const BMessage& msg );
-static PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size );
-static PyObject *get_message_data( const BMessage& msg, const char* name, int32 index );
-static PyObject *build_message_list( const BMessage& msg, const char* name );
-static int32 count_message_items( const BMessage& msg, const char* name );
-static PyObject *explain_reply( const BMessage &reply );
-static SpecifierObject *parse_specifier( PyObject* args );
+static PyObject *build_message_list( const BMessage& msg, const char* name,
+                                     int packed = PACK_AUTO );
 
 // ----------------------------------------------------------------------
 // Error handlers for common situations.
@@ -121,14 +134,80 @@ static PyObject *UnknownObj_error( type_code type, void *ptr, ssize_t size )
 	return NULL;
 }
 
+// ----------------------------------------------------------------------
+// Field names we see in nearly every reply; their dictionary keys are
+// made (and interned) once, instead of every time.
+static const char *common_field_names[] = {
+	"result", "error", "message", "suites", "messages", "specifiers",
+	NULL
+};
+static PyObject *common_field_keys[] = {
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static PyObject *field_key( const char *name )
+{
+	for( int idx = 0; common_field_names[idx] != NULL; idx++ ) {
+		if( strcmp( name, common_field_names[idx] ) == 0 ) {
+			if( common_field_keys[idx] == NULL ) {
+				common_field_keys[idx] =
+					PyString_InternFromString( (char *)name );
+				if( common_field_keys[idx] == NULL ) return NULL;
+			}
+
+			Py_INCREF( common_field_keys[idx] );
+			return common_field_keys[idx];
+		}
+	}
+
+	return PyString_FromString( (char *)name );
+}
+
+// ----------------------------------------------------------------------
+// Convert the walker's current field into a list, or a PackedArray if
+// it's a big field of numbers (see want_packed()).
+static PyObject *field_to_python( const BMessage &msg, MessageWalker &walker,
+                                  int packed )
+{
+	int32 count = walker.Count();
+	if( want_packed( walker.Type(), count, packed ) ) {
+		return newPackedArray( msg, walker.Name(), walker.Type(), count,
+		                       NULL );
+	}
+
+	PyObject *things = PyList_New( count );
+	if( things == NULL ) return PyErr_NoMemory();
+
+	for( int32 idx = 0; idx < count; idx++ ) {
+		const void *ptr;
+		ssize_t size;
+		if( walker.ItemAt( idx, &ptr, &size ) != B_OK ) {
+			Py_DECREF( things );
+			PyErr_SetString( PyExc_RuntimeError, "error getting message data" );
+			return NULL;
+		}
+
+		PyObject *thing = obj_to_python( walker.Type(), ptr, size );
+		if( thing == NULL ) {
+			Py_DECREF( things );
+			return NULL;
+		}
+		(void)PyList_SetItem( things, idx, thing );
+	}
+
+	return things;
+}
+
 // ----------------------------------------------------------------------
 // ODS 22-Jul-1999
 // Convert a BMessage's contents into a dictionary, indexed by the name;
 // every data comes as a list to handle multiple instances of that name.
-static PyObject *msg_to_dict( const BMessage &msg )
+// The fields are walked once, in order, so this stays linear in the size
+// of the message.
+PyObject *msg_to_dict( const BMessage &msg )
 {
-	int count = msg.CountNames( B_ANY_TYPE );
-	if( count == 0 ) {
+	MessageWalker walker( msg );
+	if( !walker.NextField() ) {
 		Py_INCREF( Py_None );
 		return Py_None;
 	}
@@ -136,24 +215,22 @@ static PyObject *msg_to_dict( const BMessage &msg )
 	PyObject *dict = PyDict_New();
 	if( dict == NULL ) return PyErr_NoMemory();
 
-	// ODS 22-Jul-1999: "name" should be treated as const char.
-	// An unfortunate oversight in the Be API allows you to get away
-	// with this.
-	char *name;
-	uint32 type;
-	for( int idx = 0; idx < count; idx++ ) {
-		msg.GetInfo( B_ANY_TYPE, idx, &name, &type );
-		PyObject *list = build_message_list(msg, name);
-		PyObject *key = PyString_FromString( name );
-
-		PyDict_SetItem( dict, key, list );
-		
+	do {
+		PyObject *key = field_key( walker.Name() );
+		PyObject *list = key ? field_to_python( msg, walker, PACK_AUTO ) : NULL;
+		if( list == NULL || PyDict_SetItem( dict, key, list ) != 0 ) {
+			Py_XDECREF( key );
+			Py_XDECREF( list );
+			Py_DECREF( dict );
+			return NULL;
+		}
+
 		// ODS 22-Jul-1999: Dictionaries obtain their own
 		// references to stored objects, so we should
 		// release our own.
-		Py_XDECREF(key);
-		Py_XDECREF(list);
-	}
+		Py_DECREF( key );
+		Py_DECREF( list );
+	} while( walker.NextField() );
 
 	return dict;
 }
@@ -265,7 +342,7 @@ static PyObject* build_property_tuple( const property_info& prop )
 // information for a scripting suite. Each entry in the dictionary is
 // keyed by property name, and contains a Python list of all property
 // info structs by that name.
-static PyObject* build_property_info_dict( const BPropertyInfo& pi )
+PyObject* build_property_info_dict( const BPropertyInfo& pi )
 {
 	PyObject* dict = PyDict_New();
 	if (! dict) return PyErr_NoMemory();
@@ -304,16 +381,25 @@ static PyObject* build_suite_dict( const BMessage& msg )
 	PyObject* dict = PyDict_New();
 	if (! dict) return PyErr_NoMemory();
 	
-	int32 numSuites = count_message_items(msg, "suites");
+	// Walk the two fields side by side instead of looking them up by name
+	// for every suite.
+	MessageWalker suites(msg);
+	MessageWalker messages(msg);
+	(void)suites.FindField("suites");
+	(void)messages.FindField("messages");
+
+	int32 numSuites = suites.Count();
 	for (int32 i=0; i<numSuites; i++) {
-		const char* suiteName = msg.FindString("suites", i);
-		PyObject* key = PyString_FromString(suiteName);
-		
-		const void* propData;
+		const void* suiteName;
 		ssize_t size;
-		msg.FindData("messages", B_PROPERTY_INFO_TYPE, i, &propData, &size);
+		if (suites.ItemAt(i, &suiteName, &size) != B_OK) continue;
+		PyObject* key = PyString_FromString((char *)suiteName);
+		
+		const void* propData = NULL;
+		size = 0;
+		(void)messages.ItemAt(i, &propData, &size);
 		BPropertyInfo pi;
-		pi.Unflatten(B_PROPERTY_INFO_TYPE, propData, size);
+		if (propData) pi.Unflatten(B_PROPERTY_INFO_TYPE, propData, size);
 		PyObject* value = build_property_info_dict(pi);	
 		PyDict_SetItem(dict, key, value);
 		// dictionary creates its own references;
@@ -326,7 +412,7 @@ static PyObject* build_suite_dict( const BMessage& msg )
 
 // ----------------------------------------------------------------------
 // Convert some data from a BMessage into something useful for Python.
-static PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size )
+PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size )
 {
 	PyObject *obj;
 
@@ -489,8 +575,14 @@ static PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size )
 
 	case B_MESSAGE_TYPE:
 		{
-			const BMessage* msg = static_cast<const BMessage*>(ptr);
-			return msg_to_dict( *msg );
+			// Nested messages are stored flattened.
+			BMessage msg;
+			if( msg.Unflatten( static_cast<const char *>(ptr) ) != B_OK ) {
+				PyErr_SetString( PyExc_RuntimeError,
+				                 "error getting message data" );
+				return NULL;
+			}
+			return msg_to_dict( msg );
 		}
 		
 		// You won't get here.
@@ -498,28 +590,9 @@ static PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size )
 
 	case B_MESSENGER_TYPE:
 		// ODS 21-Jul-1999: Wrap a 'hey' object around this messenger.
-		{
-			const BMessenger* m = static_cast<const BMessenger*>(ptr);
-			HeyObject* self = PyObject_NEW(HeyObject, &Hey_Type);
-			if (self) {
-				self->target = new BMessenger(*m);
-			}
-			if( !self->target->IsValid() ) {
-				delete self->target;
+		return (PyObject *)newHeyObjectFromMessenger(
+			*static_cast<const BMessenger *>( ptr ) );
 
-				PyErr_SetString( PyExc_RuntimeError,
-			        "unable to create messenger" );
-
-				// ODS 22-Jul-1999: is this the correct way to clean up self?
-				Py_DECREF(self);
-				self = NULL;
-			}
-			return (PyObject*)self;
-		}
-		
-		// You won't get here.
-		break;
-		
 	default:
 		{
 			// Unknown object; return a tuple:
@@ -549,51 +622,25 @@ static PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size )
 	return Py_None;
 }
 
-// ----------------------------------------------------------------------
-// Convert data in a message field to a Python object.
-static PyObject* get_message_data( const BMessage& msg, const char* name, int32 index )
-{
-	status_t retval;
-	const void* ptr;
-	ssize_t size;
-	type_code type = 0;
-
-	retval = msg.GetInfo( name, &type );
-	if( retval != B_OK ) {
-		// If there's no reply, we return None.
-		Py_INCREF( Py_None );
-		return Py_None;
-	}
-			
-	retval = msg.FindData( name, type, index, &ptr, &size );
-	if( retval != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError, "error getting message data" );
-		return NULL;
-	}
-
-	PyObject *thing = obj_to_python( type, ptr, size );
-	return thing;
-}
-
 // ----------------------------------------------------------------------
 // ODS 22-Jul-1999
-// Returns a Python list of the message field's data members.
-static PyObject* build_message_list( const BMessage& msg, const char* name )
+// Returns a Python list of the message field's data members.  Big fields
+// of numbers come back as a PackedArray instead (see want_packed()).
+static PyObject* build_message_list( const BMessage& msg, const char* name,
+                                     int packed )
 {
-	int32 count = count_message_items(msg, name);
-	PyObject* things = PyList_New(count);
-	if( things == NULL ) return PyErr_NoMemory();
-	for (int32 i=0; i<count; i++) {
-		PyObject* thing = get_message_data(msg, name, i);
-		(void)PyList_SetItem(things, i, thing);
+	MessageWalker walker( msg );
+	if( !walker.FindField( name ) ) {
+		return PyList_New( 0 );
 	}
-	return things;
+
+	return field_to_python( msg, walker, packed );
 }
 
 // ----------------------------------------------------------------------
 // ODS 22-Jul-1999
 // This tells you how many items are in a particular message field.
-static int32 count_message_items( const BMessage& msg, const char* name )
+int32 count_message_items( const BMessage& msg, const char* name )
 {
 	int32 count;
 	type_code type;
@@ -603,7 +650,7 @@ static int32 count_message_items( const BMessage& msg, const char* name )
 
 // ----------------------------------------------------------------------
 // Explain the reply message in terms useful to a Python programmer.
-static PyObject *explain_reply( const BMessage &reply )
+PyObject *explain_reply( const BMessage &reply, int packed )
 {
 	switch( reply.what ) {
 	case B_MESSAGE_NOT_UNDERSTOOD:
@@ -660,7 +707,7 @@ static PyObject *explain_reply( const BMessage &reply )
 			return build_suite_dict(reply);
 		} else {
 			// A regular reply. Build a Python list out of the results.
-			return build_message_list(reply, "result");
+			return build_message_list(reply, "result", packed);
 		}
 		break;
 
@@ -686,6 +733,172 @@ static PyObject *explain_reply( const BMessage &reply )
 // Hey object
 // ======================================================================
 
+// ----------------------------------------------------------------------
+// Timeouts.
+//
+// Every Hey object has a delivery timeout (how long we'll wait for the
+// target to take a request) and a reply timeout (how long we'll wait for
+// it to answer); new objects get these defaults.  Python sees them as
+// seconds, or None for "forever".
+PyObject *HeyTimeoutError = NULL;
+
+// Raised by validate_request(); see Suites.cpp.
+PyObject *HeyUnsupportedError = NULL;
+
+static bool timeout_from_python( PyObject *obj, bigtime_t *timeout )
+{
+	if( obj == Py_None ) {
+		*timeout = B_INFINITE_TIMEOUT;
+		return true;
+	}
+
+	double seconds = PyFloat_AsDouble( obj );
+	if( PyErr_Occurred() ) {
+		PyErr_SetString( PyExc_TypeError,
+				"timeouts must be a number of seconds or None" );
+		return false;
+	}
+	if( seconds < 0.0 ) {
+		PyErr_SetString( PyExc_ValueError, "timeouts must not be negative" );
+		return false;
+	}
+
+	*timeout = (bigtime_t)( seconds * 1000000.0 );
+	return true;
+}
+
+static PyObject *timeout_to_python( bigtime_t timeout )
+{
+	if( timeout == B_INFINITE_TIMEOUT ) {
+		Py_INCREF( Py_None );
+		return Py_None;
+	}
+
+	return PyFloat_FromDouble( (double)timeout / 1000000.0 );
+}
+
+static PyObject *timeouts_to_python( bigtime_t reply_timeout,
+                                     bigtime_t send_timeout )
+{
+	PyObject *tuple = PyTuple_New( 2 );
+	if( tuple == NULL ) return NULL;
+
+	PyObject *reply_obj = timeout_to_python( reply_timeout );
+	PyObject *send_obj = timeout_to_python( send_timeout );
+	if( reply_obj == NULL || send_obj == NULL ) {
+		Py_XDECREF( reply_obj );
+		Py_XDECREF( send_obj );
+		Py_DECREF( tuple );
+		return NULL;
+	}
+
+	(void)PyTuple_SetItem( tuple, 0, reply_obj );
+	(void)PyTuple_SetItem( tuple, 1, send_obj );
+	return tuple;
+}
+
+// Pick up ( timeout, send_timeout ) from SetTimeouts()-style arguments;
+// anything that isn't given is left alone.
+static bool parse_timeouts( PyObject *args, PyObject *kwds,
+                            bigtime_t *reply_timeout, bigtime_t *send_timeout )
+{
+	static char *kwlist[] = { "timeout", "send_timeout", NULL };
+	PyObject *reply_obj = NULL;
+	PyObject *send_obj = NULL;
+
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|OO", kwlist,
+				&reply_obj, &send_obj ) ) {
+		return false;
+	}
+
+	bigtime_t new_reply = *reply_timeout;
+	bigtime_t new_send = *send_timeout;
+	if( reply_obj && !timeout_from_python( reply_obj, &new_reply ) ) {
+		return false;
+	}
+	if( send_obj && !timeout_from_python( send_obj, &new_send ) ) {
+		return false;
+	}
+
+	*reply_timeout = new_reply;
+	*send_timeout = new_send;
+	return true;
+}
+
+// What a single call can change with keyword arguments:
+//
+//     x.Get( "Title of Window 0", timeout = 2.0, send_timeout = 0.5 )
+//     x.Get( "Text of View 0 of Window 0", lazy = 1 )
+//     x.Get( "Frame of Window 0", validate = 2 )
+struct call_options {
+	bigtime_t reply_timeout;
+	bigtime_t send_timeout;
+	int lazy;
+	int validate;
+	int packed;
+};
+
+static bool parse_call_options( PyObject *kwds, call_options *opts )
+{
+	if( kwds == NULL ) return true;
+
+	int pos = 0;
+	PyObject *key;
+	PyObject *value;
+	while( PyDict_Next( kwds, &pos, &key, &value ) ) {
+		char *name = PyString_AsString( key );
+		if( name == NULL ) return false;
+
+		if( strcmp( name, "timeout" ) == 0 ) {
+			if( !timeout_from_python( value, &opts->reply_timeout ) ) return false;
+		} else if( strcmp( name, "send_timeout" ) == 0 ) {
+			if( !timeout_from_python( value, &opts->send_timeout ) ) return false;
+		} else if( strcmp( name, "lazy" ) == 0 ) {
+			opts->lazy = PyObject_IsTrue( value );
+		} else if( strcmp( name, "validate" ) == 0 ) {
+			if( !PyInt_Check( value ) ) {
+				PyErr_SetString( PyExc_TypeError, "validate must be 0, 1 or 2" );
+				return false;
+			}
+			opts->validate = (int)PyInt_AsLong( value );
+		} else if( strcmp( name, "packed" ) == 0 ) {
+			if( value == Py_None ) {
+				opts->packed = PACK_AUTO;
+			} else {
+				opts->packed = PyObject_IsTrue( value ) ? PACK_ALWAYS
+				                                        : PACK_NEVER;
+			}
+		} else {
+			char buff[128];
+			sprintf( buff, "unexpected keyword argument '%.64s'", name );
+			PyErr_SetString( PyExc_TypeError, buff );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+PyObject *Hey_SetDefaultTimeouts( PyObject *self, PyObject *args, PyObject *kwds )
+{
+	if( !parse_timeouts( args, kwds, &default_reply_timeout,
+				&default_send_timeout ) ) {
+		return NULL;
+	}
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+PyObject *Hey_DefaultTimeouts( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return timeouts_to_python( default_reply_timeout, default_send_timeout );
+}
+
 // ----------------------------------------------------------------------
 // Create a new Hey object.
 //
@@ -702,6 +915,12 @@ HeyObject *newHeyObject( PyObject *arg )
 	}
 	
 	self->target = NULL;
+	self->connection = NULL;
+	self->send_timeout = default_send_timeout;
+	self->reply_timeout = default_reply_timeout;
+	self->lazy_replies = 0;
+	self->validation = VALIDATE_OFF;
+	self->proxies = NULL;
 
 	char *target_name = NULL;
 	if( !PyArg_ParseTuple( arg, "s", &target_name ) ) {
@@ -709,35 +928,12 @@ HeyObject *newHeyObject( PyObject *arg )
 		return NULL;
 	}
 
-	// All this necessary to match names as well as signatures. Urk.
-	BList team_list;
-	team_id the_team_id;
+	// Look for a running team with this signature or thread name.
 	app_info the_app_info;
-	thread_info the_thread_info;
-	int32 cookie;
-
-	// First, attempt to find it by matching thread names.
-	be_roster->GetAppList( &team_list );
-	for( int32 i = 0; i < team_list.CountItems(); i++ ) {
-		the_team_id = (team_id)team_list.ItemAt( i );
-		(void)be_roster->GetRunningAppInfo( the_team_id, &the_app_info );
-		
+	team_id the_team_id = find_team( target_name );
+	if( the_team_id >= 0 ) {
 		try {
-			if( strcmp( the_app_info.signature, target_name ) == 0 ) {
-				// Matched the app's signature.
-				self->target = new BMessenger( the_app_info.signature );
-				break;
-			} else {
-				// Try to match the name of one of the app's threads.
-				cookie = 0L;
-				if( get_next_thread_info( the_team_id, &cookie, &the_thread_info ) == B_OK ) {
-					if( strcmp( the_thread_info.name, target_name ) == 0 ) {
-						// Matched the thread's name.
-						self->target = new BMessenger( NULL, the_team_id );
-						break;
-					}
-				}
-			}
+			self->target = new BMessenger( NULL, the_team_id );
 		} catch ( bad_alloc& ex ) {
 			// TODO: we leak self here...
 			return (HeyObject *)PyErr_NoMemory();
@@ -781,19 +977,213 @@ HeyObject *newHeyObject( PyObject *arg )
 	return self;
 }
 
+// ----------------------------------------------------------------------
+// Create a Hey object for a target you've already got a messenger for.
+HeyObject *newHeyObjectFromMessenger( const BMessenger &messenger )
+{
+	if( !messenger.IsValid() ) {
+		PyErr_SetString( PyExc_RuntimeError, "unable to create messenger" );
+		return NULL;
+	}
+
+	HeyObject *self;
+	self = PyObject_NEW( HeyObject, &Hey_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	self->connection = NULL;
+	self->send_timeout = default_send_timeout;
+	self->reply_timeout = default_reply_timeout;
+	self->lazy_replies = 0;
+	self->validation = VALIDATE_OFF;
+	self->proxies = NULL;
+
+	try {
+		self->target = new BMessenger( messenger );
+	} catch ( bad_alloc& ex ) {
+		self->target = NULL;
+		Py_DECREF( self );
+		return (HeyObject *)PyErr_NoMemory();
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Create a Hey object that talks to its target over a socket.
+HeyObject *newHeyObjectFromConnection( HeyConnection *connection )
+{
+	HeyObject *self;
+	self = PyObject_NEW( HeyObject, &Hey_Type );
+	if( self == NULL ) {
+		delete connection;
+		return NULL;
+	}
+
+	self->connection = connection;
+	self->send_timeout = default_send_timeout;
+	self->reply_timeout = default_reply_timeout;
+	self->lazy_replies = 0;
+	self->validation = VALIDATE_OFF;
+	self->proxies = NULL;
+
+	try {
+		self->target = new BMessenger();
+	} catch ( bad_alloc& ex ) {
+		self->target = NULL;
+		Py_DECREF( self );
+		return (HeyObject *)PyErr_NoMemory();
+	}
+
+	return self;
+}
+
 // ----------------------------------------------------------------------
 // Delete a Hey object
 static void Hey_dealloc( HeyObject *self )
 {
 	delete self->target;
+	delete self->connection;
+	Py_XDECREF( self->proxies );
 	PyMem_DEL( self );
 }
 
+// ----------------------------------------------------------------------
+// Send a request to the target and wait for its reply, without the
+// interpreter lock.
+bool send_and_wait( HeyObject *self, BMessage *request, BMessage *reply,
+                    bigtime_t send_timeout, bigtime_t reply_timeout,
+                    const char *name )
+{
+	status_t retval;
+	bigtime_t sent;
+	bigtime_t arrived;
+
+	Py_BEGIN_ALLOW_THREADS
+	sent = system_time();
+	if( self->connection ) {
+		// The connection does its own recording.
+		retval = self->connection->SendMessage( request, reply,
+		                                        reply_timeout );
+		arrived = system_time();
+	} else {
+		retval = self->target->SendMessage( request, reply,
+		                                    send_timeout, reply_timeout );
+		arrived = system_time();
+		if( hey_recording ) {
+			record_exchange( self->target->Team(), *request,
+			                 retval == B_OK ? reply : NULL, sent, arrived );
+		}
+	}
+	stats_exchange( hey_team( self ), stats_command( name ),
+	                request->FlattenedSize(), retval == B_OK ? reply : NULL,
+	                retval, arrived - sent );
+	Py_END_ALLOW_THREADS
+
+	if( retval != B_OK ) {
+		char buff[64];
+		bool timed_out = ( retval == B_TIMED_OUT || retval == B_WOULD_BLOCK );
+		sprintf( buff, "%s sending %.32s%smessage",
+				timed_out ? "timed out" : "error",
+				name ? name : "", name ? " " : "" );
+		PyErr_SetString( timed_out ? HeyTimeoutError : PyExc_RuntimeError,
+				buff );
+
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+team_id hey_team( HeyObject *self )
+{
+	return self->connection ? self->connection->Team() : self->target->Team();
+}
+
+status_t hey_send_pipelined( HeyObject *self, BMessage **requests,
+                             BMessage **replies, int32 count,
+                             bigtime_t timeout, bigtime_t send_timeout )
+{
+	if( self->connection ) {
+		return self->connection->SendPipelined( requests, replies, count,
+		                                        timeout );
+	}
+
+	return send_pipelined( *self->target, requests, replies, count, timeout,
+	                       send_timeout );
+}
+
+// ----------------------------------------------------------------------
+// Send a request to the target and wait for its reply.
+//
+// The interpreter lock is released while we wait, so other Python threads
+// can get on with things (like scripting some other application).  That's
+// why the methods below build a fresh request for every call with
+// new_request() instead of scribbling on the Specifier's message.
+//
+// kwds holds the caller's keyword arguments, if any; see
+// parse_call_options().
+PyObject *send_request( HeyObject *self, BMessage *request,
+                        const char *name, PyObject *kwds )
+{
+	call_options opts;
+	opts.reply_timeout = self->reply_timeout;
+	opts.send_timeout = self->send_timeout;
+	opts.lazy = self->lazy_replies;
+	opts.validate = self->validation;
+	opts.packed = PACK_AUTO;
+	if( !parse_call_options( kwds, &opts ) ) {
+		return NULL;
+	}
+
+	// "Title of Window *" turns into a request per window; send_fanout()
+	// sends them with send_pipelined(), which counts each one.
+	if( needs_fanout( *request ) ) {
+		return send_fanout( self, *request, name ? name : "scripting",
+		                    opts.send_timeout, opts.reply_timeout,
+		                    opts.validate, opts.lazy, opts.packed );
+	}
+
+	if( !validate_request( self, request, opts.validate, opts.send_timeout,
+	                       opts.reply_timeout ) ) {
+		return NULL;
+	}
+
+	BMessage *the_reply;
+	try {
+		the_reply = new BMessage;
+	} catch ( bad_alloc &ex ) {
+		return PyErr_NoMemory();
+	}
+
+	if( !send_and_wait( self, request, the_reply, opts.send_timeout,
+	                    opts.reply_timeout, name ) ) {
+		delete the_reply;
+		return NULL;
+	}
+
+	if( opts.lazy ) {
+		// The reply gets converted later (if at all), so there's no
+		// conversion time to count.
+		return lazy_reply( the_reply, opts.packed );
+	}
+
+	bigtime_t start = system_time();
+	PyObject *obj = explain_reply( *the_reply, opts.packed );
+	stats_convert( hey_team( self ), stats_command( name ),
+	               system_time() - start );
+	delete the_reply;
+
+	return obj;
+}
+
 // ----------------------------------------------------------------------
 // "quit" message
 //
 // TODO: seems to fail to quit the app now and then...
-static PyObject *Hey_Quit( HeyObject *self, PyObject *args )
+static PyObject *Hey_Quit( HeyObject *self, PyObject *args, PyObject *kwds )
 {
 	// See if we got a specifier argument.
 	SpecifierObject *spec = NULL;
@@ -803,37 +1193,23 @@ static PyObject *Hey_Quit( HeyObject *self, PyObject *args )
 		return NULL;
 	}
 
-	BMessage the_reply;
-
-	if( spec ) {
-		// TODO: this doesn't seem to work...
-		spec->msg->what = B_QUIT_REQUESTED;
-
-		if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-			PyErr_SetString( PyExc_RuntimeError,
-				        "error sending Quit message" );
-
-			return NULL;
-		}
-	} else {
-		BMessage the_msg( B_QUIT_REQUESTED );
-
-		if( self->target->SendMessage( &the_msg, &the_reply ) != B_OK ) {
-			PyErr_SetString( PyExc_RuntimeError,
-				        "error sending Quit message" );
-
-			return NULL;
-		}
+	// TODO: with a specifier, this doesn't seem to work...
+	BMessage *msg = new_request( spec, B_QUIT_REQUESTED );
+	if( msg == NULL ) {
+		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	PyObject *obj = send_request( self, msg, "Quit", kwds );
+	delete msg;
+
+	return obj;
 }
 
 // ----------------------------------------------------------------------
 // "save" message
 //
 // TODO: needs to make use of the specifier
-static PyObject *Hey_Save( HeyObject *self, PyObject *args )
+static PyObject *Hey_Save( HeyObject *self, PyObject *args, PyObject *kwds )
 {
 	// See if we got a specifier argument.
 	SpecifierObject *spec = NULL;
@@ -843,29 +1219,15 @@ static PyObject *Hey_Save( HeyObject *self, PyObject *args )
 		return NULL;
 	}
 
-	BMessage the_reply;
-
-	if( spec ) {
-		spec->msg->what = B_SAVE_REQUESTED;
-
-		if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-			PyErr_SetString( PyExc_RuntimeError,
-				        "error sending Save message" );
-
-			return NULL;
-		}
-	} else {
-		BMessage the_msg( B_SAVE_REQUESTED );
-
-		if( self->target->SendMessage( &the_msg, &the_reply ) != B_OK ) {
-			PyErr_SetString( PyExc_RuntimeError,
-				        "error sending Save message" );
-
-			return NULL;
-		}
+	BMessage *msg = new_request( spec, B_SAVE_REQUESTED );
+	if( msg == NULL ) {
+		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	PyObject *obj = send_request( self, msg, "Save", kwds );
+	delete msg;
+
+	return obj;
 }
 
 // ----------------------------------------------------------------------
@@ -874,7 +1236,7 @@ static PyObject *Hey_Save( HeyObject *self, PyObject *args )
 // Call with a string path.
 //
 // TODO: allow entry_ref tuples
-static PyObject *Hey_Load( HeyObject *self, PyObject *args )
+static PyObject *Hey_Load( HeyObject *self, PyObject *args, PyObject *kwds )
 {
 	// Should have an argument, the filename to load.
 	char *filename;
@@ -895,53 +1257,12 @@ static PyObject *Hey_Load( HeyObject *self, PyObject *args )
 	}
 
 	BMessage the_msg( B_REFS_RECEIVED );
-	BMessage the_reply;
 
 	// RefsReceived() wants "refs", scripting apparently wants "data".
 	the_msg.AddRef( "refs", &fileref );
 	the_msg.AddRef( "data", &fileref );
 	
-	if( self->target->SendMessage( &the_msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Load message" );
-
-		return NULL;
-	}
-
-	return explain_reply( the_reply );
-}
-
-// ----------------------------------------------------------------------
-// ODS 22-Jul-1999
-// Create a specifier object from arguments.
-// This differs from standard specifier creation in that, if a specifier
-// object is passed in, that specifier object is simply incremented and
-// returned. Otherwise, a new specifier object is created and returned.
-// In either case, this function increments the specifier's reference
-// count, so when you're done with the specifier object, decrement it.
-static SpecifierObject* parse_specifier(PyObject* args)
-{
-	// Get the specifier first.	
-	PyObject* obj;
-	if (! PyArg_ParseTuple( args, "O", &obj ) )
-		return NULL;
-	
-	SpecifierObject *spec = NULL;
-	// Mmm, crufty C casts! Gotta love that object-oriented C...
-	PyTypeObject* type = reinterpret_cast<PyTypeObject*>(PyObject_Type( obj ));
-	if (type == &Specifier_Type) {
-		// we were passed in a specifier directly
-		// recast and increment count to balance
-		// the decrement later on
-		spec = reinterpret_cast<SpecifierObject*>(obj);
-		Py_INCREF(spec);
-	} else {
-		// we were passed in something else;
-		// see if we can make a specifier out of it!
-		spec = newSpecifierObject(args);
-	}
-	
-	return spec;
+	return send_request( self, &the_msg, "Load", kwds );
 }
 
 // ----------------------------------------------------------------------
@@ -949,7 +1270,7 @@ static SpecifierObject* parse_specifier(PyObject* args)
 //
 // Call with a Specifier object or with something that can be converted
 // to a Specifier object.
-static PyObject *Hey_Get( HeyObject *self, PyObject *args )
+static PyObject *Hey_Get( HeyObject *self, PyObject *args, PyObject *kwds )
 {
 	SpecifierObject* spec = parse_specifier(args);
 		
@@ -958,17 +1279,11 @@ static PyObject *Hey_Get( HeyObject *self, PyObject *args )
 		return NULL;
 	}
 		
-	spec->msg->what = B_GET_PROPERTY;
-	BMessage the_reply;
-
-	PyObject* obj;
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Get message" );
-
-		obj = NULL;
-	} else {
-		obj = explain_reply( the_reply );
+	BMessage *msg = new_request( spec, B_GET_PROPERTY );
+	PyObject* obj = NULL;
+	if( msg ) {
+		obj = send_request( self, msg, "Get", kwds );
+		delete msg;
 	}
 	
 	// ODS 21-Jul-1999
@@ -981,524 +1296,563 @@ static PyObject *Hey_Get( HeyObject *self, PyObject *args )
 
 // ----------------------------------------------------------------------
 // "set" messages
-static PyObject *Hey_SetString( HeyObject *self, PyObject *args )
+//
+// The arguments are a Specifier and the value, and they're parsed in one
+// place so Batch (which queues the same requests) takes exactly the same
+// ones.
+BMessage *new_set_request( PyObject *args, int kind )
 {
-	// Make sure we got a specifier argument and something else.
 	SpecifierObject *spec;
 	char *str;
-	if( !PyArg_ParseTuple( args, "O!s", &Specifier_Type, &spec, &str ) ) {
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a string" );
-		return NULL;
-	}
-
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddString( "data", str );
+	int num;
+	double dbl;
+	rgb_color colour;
+	BRect rect;
+	BPoint point;
+	entry_ref file_ref;
+	bool ok;
 
-	BMessage the_reply;
+	switch( kind ) {
+	case SET_STRING:
+	case SET_PATH:
+		ok = PyArg_ParseTuple( args, "O!s", &Specifier_Type, &spec, &str );
+		break;
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+	case SET_COLOR:
+		// ( spec, ( r, g, b[, a] ) ) or ( spec, r, g, b[, a] )
+		colour.alpha = 255;
+		ok = PyArg_ParseTuple( args, "O!(bbbb)", &Specifier_Type, &spec,
+				&colour.red, &colour.green, &colour.blue, &colour.alpha );
+		if( !ok ) {
+			PyErr_Clear();
+			ok = PyArg_ParseTuple( args, "O!(bbb)", &Specifier_Type, &spec,
+					&colour.red, &colour.green, &colour.blue );
+		}
+		if( !ok ) {
+			PyErr_Clear();
+			ok = PyArg_ParseTuple( args, "O!bbb|b", &Specifier_Type, &spec,
+					&colour.red, &colour.green, &colour.blue, &colour.alpha );
+		}
+		break;
 
-		return NULL;
-	}
+	case SET_RECT:
+		// ( spec, ( l, t, r, b ) ) or ( spec, l, t, r, b )
+		ok = PyArg_ParseTuple( args, "O!(ffff)", &Specifier_Type, &spec,
+				&rect.left, &rect.top, &rect.right, &rect.bottom );
+		if( !ok ) {
+			PyErr_Clear();
+			ok = PyArg_ParseTuple( args, "O!ffff", &Specifier_Type, &spec,
+					&rect.left, &rect.top, &rect.right, &rect.bottom );
+		}
+		break;
 
-	return explain_reply( the_reply );
-}
+	case SET_POINT:
+		// ( spec, ( x, y ) ) or ( spec, x, y )
+		ok = PyArg_ParseTuple( args, "O!(ff)", &Specifier_Type, &spec,
+				&point.x, &point.y );
+		if( !ok ) {
+			PyErr_Clear();
+			ok = PyArg_ParseTuple( args, "O!ff", &Specifier_Type, &spec,
+					&point.x, &point.y );
+		}
+		break;
 
-static PyObject *Hey_SetPath( HeyObject *self, PyObject *args )
-{
-	// Make sure we got a specifier argument and something else.
-	SpecifierObject *spec;
-	char *str;
-	if( !PyArg_ParseTuple( args, "O!s", &Specifier_Type, &spec, &str ) ) {
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a string" );
-		return NULL;
-	}
+	case SET_BOOL:
+		// A number, or a string like "true" or "false".
+		ok = PyArg_ParseTuple( args, "O!i", &Specifier_Type, &spec, &num );
+		if( !ok ) {
+			PyErr_Clear();
+			ok = PyArg_ParseTuple( args, "O!s", &Specifier_Type, &spec, &str );
+			if( ok ) {
+				// Hmm, I wonder if "yes"/"no" are covered in C locale settings...
+				num = ( strcasecmp( str, "true" ) == 0 ||
+				        strcasecmp( str, "yes" )  == 0 ||
+				        strcasecmp( str, "oui" )  == 0 ||
+				        strcasecmp( str, "da" )   == 0 ||
+				        strcasecmp( str, "hai" )  == 0 );
+			}
+		}
+		break;
 
-	entry_ref file_ref;
-	status_t retval = get_ref_for_path( str, &file_ref );
-	if( retval != B_OK ) {
-		return IOError_file( "can't get ref for path", str, retval );
-	}
+	case SET_FLOAT:
+	case SET_DOUBLE:
+		ok = PyArg_ParseTuple( args, "O!d", &Specifier_Type, &spec, &dbl );
+		break;
 
-	BEntry entry;
-	retval = entry.SetTo( &file_ref );
-	if( retval != B_OK ) {
-		return IOError_file( "can't make Entry for ref", str, retval );
+	default:
+		ok = PyArg_ParseTuple( args, "O!i", &Specifier_Type, &spec, &num );
+		break;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddRef( "data", &file_ref );
+	if( !ok ) {
+		const char *what;
+		switch( kind ) {
+		case SET_STRING:
+		case SET_PATH:	what = "a string"; break;
+		case SET_COLOR:	what = "a color"; break;
+		case SET_RECT:	what = "a rectangle"; break;
+		case SET_POINT:	what = "a point"; break;
+		default:		what = "a number"; break;
+		}
 
-	if( spec->msg->HasData( "refs", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "refs" );
+		char buff[64];
+		sprintf( buff, "invalid arguments; expected a Specifier and %s", what );
+		PyErr_SetString( PyExc_TypeError, buff );
+		return NULL;
 	}
-	spec->msg->AddRef( "refs", &file_ref );	// for RefsReceived()
 
-	BMessage the_reply;
+	if( kind == SET_PATH ) {
+		status_t retval = get_ref_for_path( str, &file_ref );
+		if( retval != B_OK ) {
+			return (BMessage *)IOError_file( "can't get ref for path", str,
+			                                 retval );
+		}
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+		BEntry entry;
+		retval = entry.SetTo( &file_ref );
+		if( retval != B_OK ) {
+			return (BMessage *)IOError_file( "can't make Entry for ref", str,
+			                                 retval );
+		}
+	}
 
+	BMessage *msg = new_request( spec, B_SET_PROPERTY );
+	if( msg == NULL ) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	switch( kind ) {
+	case SET_STRING:	msg->AddString( "data", str ); break;
+	case SET_PATH:
+		msg->AddRef( "data", &file_ref );
+		msg->AddRef( "refs", &file_ref );	// for RefsReceived()
+		break;
+	case SET_COLOR:
+		msg->AddData( "data", B_RGB_COLOR_TYPE, &colour, sizeof( rgb_color ) );
+		break;
+	case SET_RECT:		msg->AddRect( "data", rect ); break;
+	case SET_POINT:		msg->AddPoint( "data", point ); break;
+	case SET_INT8:		msg->AddInt8( "data", (int8)num ); break;
+	case SET_INT16:		msg->AddInt16( "data", (int16)num ); break;
+	case SET_INT32:		msg->AddInt32( "data", (int32)num ); break;
+	case SET_FLOAT:		msg->AddFloat( "data", (float)dbl ); break;
+	case SET_DOUBLE:	msg->AddDouble( "data", dbl ); break;
+	case SET_BOOL:		msg->AddBool( "data", num ? true : false ); break;
+	}
+
+	return msg;
 }
 
-static PyObject *Hey_SetColor( HeyObject *self, PyObject *args )
+static PyObject *Hey_set( HeyObject *self, PyObject *args, PyObject *kwds,
+                          int kind )
 {
-	// Make sure we got a specifier argument and at least rgb.
-	SpecifierObject *spec;
-	rgb_color colour;
-	colour.alpha = 255;
-	if( PyArg_ParseTuple( args, "O!(bbbb)", &Specifier_Type, &spec,
-				&colour.red, &colour.green, &colour.blue, &colour.alpha ) ) {
-		// That's good.
-		;
-	} else if( PyArg_ParseTuple( args, "O!(bbb)", &Specifier_Type, &spec,
-				&colour.red, &colour.green, &colour.blue ) ) {
-		// That's good.  Ignore the error from the first PyArg_ParseTuple().
-		PyErr_Clear();
-	} else if( !PyArg_ParseTuple( args, "O!bbb|b", &Specifier_Type, &spec,
-				&colour.red, &colour.green, &colour.blue, &colour.alpha ) ) {
-		// That's good.  Ignore the error from the first PyArg_ParseTuple()s.
-		PyErr_Clear();
-	} else {
-		// That's bad.
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a color" );
+	BMessage *msg = new_set_request( args, kind );
+	if( msg == NULL ) {
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddData( "data", B_RGB_COLOR_TYPE, &colour, sizeof( rgb_color ) );
+	PyObject *obj = send_request( self, msg, "Set", kwds );
+	delete msg;
 
-	BMessage the_reply;
+	return obj;
+}
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+static PyObject *Hey_SetString( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_STRING );
+}
 
-		return NULL;
-	}
+static PyObject *Hey_SetPath( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_PATH );
+}
 
-	return explain_reply( the_reply );
+static PyObject *Hey_SetColor( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_COLOR );
 }
 
-static PyObject *Hey_SetColour( HeyObject *self, PyObject *args )
+static PyObject *Hey_SetColour( HeyObject *self, PyObject *args, PyObject *kwds )
 {
 	// For those of us who can spell correctly...
-	return Hey_SetColor( self, args );
+	return Hey_SetColor( self, args, kwds );
 }
 
-static PyObject *Hey_SetRect( HeyObject *self, PyObject *args )
+static PyObject *Hey_SetRect( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and a BRect.
-	SpecifierObject *spec;
-	BRect rect;
-	if( !PyArg_ParseTuple( args, "O!(ffff)", &Specifier_Type, &spec,
-				&rect.left, &rect.top, &rect.right, &rect.bottom ) ) {
-		// Try to look for ( spec, float, float, float, float ).
-		PyErr_Clear();
-
-		if( !PyArg_ParseTuple( args, "O!ffff", &Specifier_Type, &spec,
-				&rect.left, &rect.top, &rect.right, &rect.bottom ) ) {
-			// That's bad.
-			PyErr_SetString( PyExc_TypeError,
-					"invalid arguments; expected a Specifier and a rectangle" );
-			return NULL;
-		}
-	}
-
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddRect( "data", rect );
-
-	BMessage the_reply;
+	return Hey_set( self, args, kwds, SET_RECT );
+}
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+static PyObject *Hey_SetPoint( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_POINT );
+}
 
-		return NULL;
-	}
+static PyObject *Hey_SetInt( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_INT32 );
+}
 
-	return explain_reply( the_reply );
+static PyObject *Hey_SetInt8( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_INT8 );
 }
 
-static PyObject *Hey_SetPoint( HeyObject *self, PyObject *args )
+static PyObject *Hey_SetInt16( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and a BPoint.
-	SpecifierObject *spec;
-	BPoint point;
-	if( !PyArg_ParseTuple( args, "O!(ff)", &Specifier_Type, &spec,
-				&point.x, &point.y ) ) {
-		// Try to look for ( spec, float, float ).
-		PyErr_Clear();
+	return Hey_set( self, args, kwds, SET_INT16 );
+}
 
-		if( !PyArg_ParseTuple( args, "O!ff", &Specifier_Type, &spec,
-				&point.x, &point.y ) ) {
-			// That's bad.
-			PyErr_SetString( PyExc_TypeError,
-					"invalid arguments; expected a Specifier and a point" );
-			return NULL;
-		}
-	}
+static PyObject *Hey_SetInt32( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_INT32 );
+}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddPoint( "data", point );
+static PyObject *Hey_SetFloat( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_FLOAT );
+}
 
-	BMessage the_reply;
+static PyObject *Hey_SetDouble( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_DOUBLE );
+}
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+static PyObject *Hey_SetBool( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	return Hey_set( self, args, kwds, SET_BOOL );
+}
 
+// ----------------------------------------------------------------------
+// "create" message
+static PyObject *Hey_Create( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	// Make sure we got a specifier argument.
+	SpecifierObject *spec = parse_specifier(args);
+	if( ! spec) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	BMessage *msg = new_request( spec, B_CREATE_PROPERTY );
+	PyObject* obj = NULL;
+	if( msg ) {
+		obj = send_request( self, msg, "Create", kwds );
+		delete msg;
+	}
+	
+	Py_DECREF(spec);
+	return obj;
 }
 
-static PyObject *Hey_SetInt( HeyObject *self, PyObject *args )
+// ----------------------------------------------------------------------
+// "delete" message
+static PyObject *Hey_Delete( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and an int.
-	SpecifierObject *spec;
-	int num;
-	if( !PyArg_ParseTuple( args, "O!i", &Specifier_Type, &spec, &num ) ) {
-		// That's bad.
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+	// Make sure we got a specifier argument.
+	SpecifierObject *spec = parse_specifier(args);
+	if( ! spec) {
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
+	BMessage *msg = new_request( spec, B_DELETE_PROPERTY );
+	PyObject* obj = NULL;
+	if( msg ) {
+		obj = send_request( self, msg, "Delete", kwds );
+		delete msg;
 	}
-	spec->msg->AddInt32( "data", num );
-
-	BMessage the_reply;
-
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+	
+	Py_DECREF(spec);
+	return obj;
+}
 
+// ----------------------------------------------------------------------
+// "count" message
+//
+// call with a Specifier object
+static PyObject *Hey_Count( HeyObject *self, PyObject *args, PyObject *kwds )
+{
+	// Make sure we got a specifier argument.
+	SpecifierObject *spec = parse_specifier(args);
+	if( ! spec) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	BMessage *msg = new_request( spec, B_COUNT_PROPERTIES );
+	PyObject* obj = NULL;
+	if( msg ) {
+		obj = send_request( self, msg, "Count", kwds );
+		delete msg;
+	}
+	
+	Py_DECREF(spec);
+	return obj;
 }
 
-static PyObject *Hey_SetInt8( HeyObject *self, PyObject *args )
+// ----------------------------------------------------------------------
+// "getsuites" message
+static PyObject *Hey_GetSuites( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and an int.
-	SpecifierObject *spec;
-	int8 num;
-	if( !PyArg_ParseTuple( args, "O!b", &Specifier_Type, &spec, &num ) ) {
-		// That's bad.
+	// Make sure we got a specifier argument.
+	SpecifierObject *spec = NULL;
+	if( !PyArg_ParseTuple( args, "|O!", &Specifier_Type, &spec ) ) {
 		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+				"invalid arguments; expected a Specifier" );
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
+	call_options opts;
+	opts.reply_timeout = self->reply_timeout;
+	opts.send_timeout = self->send_timeout;
+	opts.lazy = self->lazy_replies;
+	opts.validate = self->validation;
+	opts.packed = PACK_AUTO;
+	if( !parse_call_options( kwds, &opts ) ) {
+		return NULL;
 	}
-	spec->msg->AddInt8( "data", num );
-
-	BMessage the_reply;
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+	// Suites hardly ever change, so they come from the suite cache unless
+	// you want the whole reply.
+	if( !opts.lazy ) {
+		return get_suites( self, spec ? spec->msg : NULL,
+		                   opts.send_timeout, opts.reply_timeout );
+	}
 
+	BMessage *msg = new_request( spec, B_GET_SUPPORTED_SUITES );
+	if( msg == NULL ) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	PyObject *obj = send_request( self, msg, "GetSuites", kwds );
+	delete msg;
+
+	return obj;
 }
 
-static PyObject *Hey_SetInt16( HeyObject *self, PyObject *args )
+// ----------------------------------------------------------------------
+// Which suite (if any) says the handler at "of" can take command with a
+// form specifier for property?
+//
+// Supports( "Title", "Get", "Direct", of = "Window 0" )
+//
+// This uses the suite cache, so it's usually free.
+static PyObject *Hey_Supports( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and an int.
-	SpecifierObject *spec;
-	int16 num;
-	if( !PyArg_ParseTuple( args, "O!h", &Specifier_Type, &spec, &num ) ) {
-		// That's bad.
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+	static char *kwlist[] = { "property", "command", "form", "of", NULL };
+	char *property;
+	PyObject *command_obj = NULL;
+	PyObject *form_obj = NULL;
+	PyObject *of = NULL;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "s|OOO", kwlist,
+	                                  &property, &command_obj, &form_obj, &of ) ) {
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
+	uint32 command = B_GET_PROPERTY;
+	uint32 form = B_DIRECT_SPECIFIER;
+	if( command_obj && !command_from_python( command_obj, &command ) ) {
+		return NULL;
 	}
-	spec->msg->AddInt16( "data", num );
-
-	BMessage the_reply;
-
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
-
+	if( form_obj && !form_from_python( form_obj, &form ) ) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	SpecifierObject *spec = NULL;
+	if( of != NULL && of != Py_None ) {
+		PyObject *spec_args = Py_BuildValue( "(O)", of );
+		if( spec_args == NULL ) {
+			return NULL;
+		}
+		spec = parse_specifier( spec_args );
+		Py_DECREF( spec_args );
+		if( spec == NULL ) {
+			return NULL;
+		}
+	}
+
+	PyObject *suite = find_support( self, spec ? spec->msg : NULL, property,
+	                                command, form, self->send_timeout,
+	                                self->reply_timeout );
+	Py_XDECREF( spec );
+
+	return suite;
 }
 
-static PyObject *Hey_SetInt32( HeyObject *self, PyObject *args )
+// ----------------------------------------------------------------------
+// send a specific message; can be string of 4 chars, or an int
+//
+// Send( what, fields ) packs a dictionary (or a sequence of
+// ( name, value ) pairs) into the message too; see Marshal.cpp for how
+// the types are picked.
+static PyObject *Hey_Send( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and an int.
-	SpecifierObject *spec;
-	int32 num;
-	if( !PyArg_ParseTuple( args, "O!i", &Specifier_Type, &spec, &num ) ) {
-		// That's bad.
+	// Make sure we got a "what".
+	PyObject *what_obj;
+	PyObject *fields = NULL;
+	if( !PyArg_ParseTuple( args, "O|O", &what_obj, &fields ) ) {
+		PyErr_Clear();
 		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+				"invalid arguments; expected a message 'what'" );
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
+	uint32 what;
+	if( !what_from_python( what_obj, &what ) ) {
+		return NULL;
 	}
-	spec->msg->AddInt32( "data", num );
-
-	BMessage the_reply;
-
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
 
+	BMessage msg( what );
+	if( fields && fields != Py_None && !marshal_fields( fields, &msg ) ) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	return send_request( self, &msg, NULL, kwds );
 }
 
-static PyObject *Hey_SetFloat( HeyObject *self, PyObject *args )
+// ----------------------------------------------------------------------
+// Timeouts for this object's requests, in seconds (None means wait
+// forever).  SetTimeouts( timeout, send_timeout ) changes either one.
+static PyObject *Hey_SetTimeouts( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a specifier argument and an int.
-	SpecifierObject *spec;
-	float num;
-	if( !PyArg_ParseTuple( args, "O!f", &Specifier_Type, &spec, &num ) ) {
-		// That's bad.
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+	if( !parse_timeouts( args, kwds, &self->reply_timeout, &self->send_timeout ) ) {
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddFloat( "data", num );
-
-	BMessage the_reply;
-
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+	Py_INCREF( Py_None );
+	return Py_None;
+}
 
+static PyObject *Hey_Timeouts( HeyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	return timeouts_to_python( self->reply_timeout, self->send_timeout );
 }
 
-static PyObject *Hey_SetDouble( HeyObject *self, PyObject *args )
+// ----------------------------------------------------------------------
+// SetLazyReplies( 1 ) makes this object's methods return Reply objects,
+// which convert the reply's fields as you look at them.
+static PyObject *Hey_SetLazyReplies( HeyObject *self, PyObject *args )
 {
-	// Make sure we got a specifier argument and an int.
-	SpecifierObject *spec;
-	double num;
-	if( !PyArg_ParseTuple( args, "O!d", &Specifier_Type, &spec, &num ) ) {
-		// That's bad.
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+	int lazy;
+	if( !PyArg_ParseTuple( args, "i", &lazy ) ) {
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddDouble( "data", num );
-
-	BMessage the_reply;
+	self->lazy_replies = lazy ? 1 : 0;
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
+	Py_INCREF( Py_None );
+	return Py_None;
+}
 
+// ----------------------------------------------------------------------
+// SetValidation( mode ) makes this object check requests against the
+// target's suites before sending them: 0 doesn't, 1 turns down properties
+// the suites don't mention, 2 wants an exact match and won't send what it
+// can't check.  See validate_request().
+static PyObject *Hey_SetValidation( HeyObject *self, PyObject *args )
+{
+	int mode;
+	if( !PyArg_ParseTuple( args, "i", &mode ) ) {
+		return NULL;
+	}
+	if( mode < VALIDATE_OFF || mode > VALIDATE_STRICT ) {
+		PyErr_SetString( PyExc_ValueError, "validation mode must be 0, 1 or 2" );
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	self->validation = mode;
+
+	Py_INCREF( Py_None );
+	return Py_None;
 }
 
-static PyObject *Hey_SetBool( HeyObject *self, PyObject *args )
+static PyObject *Hey_Validation( HeyObject *self, PyObject *args )
 {
-	// Make sure we got a specifier argument and an bool.
-	SpecifierObject *spec;
-	bool val;
-	int num;
-	char *str;
-
-	if( PyArg_ParseTuple( args, "O!i", &Specifier_Type, &spec, &num ) ) {
-		if( num ) {
-			val = true;
-		} else {
-			val = false;
-		}
-	} else if( PyArg_ParseTuple( args, "O!s", &Specifier_Type, &spec, &str ) ) {
-		PyErr_Clear();
-
-		// Hmm, I wonder if "yes"/"no" are covered in C locale settings...
-		if( strcasecmp( str, "true" ) == 0 || 
-			strcasecmp( str, "yes" )  == 0 ||
-			strcasecmp( str, "oui" )  == 0 ||
-			strcasecmp( str, "da" )   == 0 ||
-			strcasecmp( str, "hai" )  == 0 ) {
-			val = true;
-		} else {
-			val = false;
-		}
-	} else {
-		// That's bad.
-		PyErr_SetString( PyExc_TypeError,
-				"invalid arguments; expected a Specifier and a number" );
+	if( !PyArg_ParseTuple( args, "" ) ) {
 		return NULL;
 	}
 
-	spec->msg->what = B_SET_PROPERTY;
-	if( spec->msg->HasData( "data", B_ANY_TYPE ) ) {
-		(void)spec->msg->RemoveName( "data" );
-	}
-	spec->msg->AddBool( "data", val );
+	return PyInt_FromLong( self->validation );
+}
 
-	BMessage the_reply;
+// ----------------------------------------------------------------------
+// Create an empty specifier
+static PyObject *Hey_Specifier( HeyObject *self, PyObject *args )
+{
+	return (PyObject *)newSpecifierObject( args );
+}
 
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
+// ----------------------------------------------------------------------
+// Non-blocking versions of the methods above; these send the request and
+// return a Future right away.  Call the Future's Result() method to get
+// what the blocking method would have returned.
+
+// A Future for msg; Futures wait on a port for their reply, so there's no
+// such thing over a socket.
+static FutureObject *new_future( HeyObject *self, BMessage *msg,
+                                 const char *name )
+{
+	if( self->connection ) {
 		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Set message" );
-
+				"Async methods don't work over a connection; use a Batch" );
 		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	return newFutureObject( *self->target, msg, name, self->send_timeout,
+	                        self->reply_timeout, self->lazy_replies );
 }
 
-// ----------------------------------------------------------------------
-// "create" message
-static PyObject *Hey_Create( HeyObject *self, PyObject *args )
+static PyObject *Hey_async( HeyObject *self, PyObject *args, uint32 what,
+                            const char *name )
 {
-	// Make sure we got a specifier argument.
-	SpecifierObject *spec = parse_specifier(args);
-	if( ! spec) {
+	SpecifierObject *spec = parse_specifier( args );
+	if( spec == NULL ) {
 		return NULL;
 	}
 
-	spec->msg->what = B_CREATE_PROPERTY;
-	BMessage the_reply;
-
-	PyObject* obj;
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Create message" );
-
-		obj = NULL;
-	} else {
-		obj = explain_reply( the_reply );
+	BMessage *msg = new_request( spec, what );
+	Py_DECREF( spec );
+	if( msg == NULL ) {
+		return NULL;
 	}
-	
-	Py_DECREF(spec);
-	return obj;
-}
 
-// ----------------------------------------------------------------------
-// "delete" message
-static PyObject *Hey_Delete( HeyObject *self, PyObject *args )
-{
-	// Make sure we got a specifier argument.
-	SpecifierObject *spec = parse_specifier(args);
-	if( ! spec) {
+	if( refuse_fanout( *msg ) ||
+		!validate_request( self, msg, self->validation, self->send_timeout,
+	                       self->reply_timeout ) ) {
+		delete msg;
 		return NULL;
 	}
 
-	spec->msg->what = B_DELETE_PROPERTY;
-	BMessage the_reply;
+	FutureObject *future = new_future( self, msg, name );
+	delete msg;
 
-	PyObject* obj;
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Delete message" );
-
-		obj = NULL;
-	} else {
-		obj = explain_reply( the_reply );
-	}
-	
-	Py_DECREF(spec);
-	return obj;
+	return (PyObject *)future;
 }
 
-// ----------------------------------------------------------------------
-// "count" message
-//
-// call with a Specifier object
-static PyObject *Hey_Count( HeyObject *self, PyObject *args )
+static PyObject *Hey_GetAsync( HeyObject *self, PyObject *args )
 {
-	// Make sure we got a specifier argument.
-	SpecifierObject *spec = parse_specifier(args);
-	if( ! spec) {
-		return NULL;
-	}
+	return Hey_async( self, args, B_GET_PROPERTY, "Get" );
+}
 
-	spec->msg->what = B_COUNT_PROPERTIES;
-	BMessage the_reply;
+static PyObject *Hey_CountAsync( HeyObject *self, PyObject *args )
+{
+	return Hey_async( self, args, B_COUNT_PROPERTIES, "Count" );
+}
 
-	PyObject* obj;
-	if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending Count message" );
+static PyObject *Hey_CreateAsync( HeyObject *self, PyObject *args )
+{
+	return Hey_async( self, args, B_CREATE_PROPERTY, "Create" );
+}
 
-		obj = NULL;
-	} else {
-		obj = explain_reply( the_reply );
-	}
-	
-	Py_DECREF(spec);
-	return obj;
+static PyObject *Hey_DeleteAsync( HeyObject *self, PyObject *args )
+{
+	return Hey_async( self, args, B_DELETE_PROPERTY, "Delete" );
 }
 
-// ----------------------------------------------------------------------
-// "getsuites" message
-static PyObject *Hey_GetSuites( HeyObject *self, PyObject *args )
+static PyObject *Hey_GetSuitesAsync( HeyObject *self, PyObject *args )
 {
-	// Make sure we got a specifier argument.
 	SpecifierObject *spec = NULL;
 	if( !PyArg_ParseTuple( args, "|O!", &Specifier_Type, &spec ) ) {
 		PyErr_SetString( PyExc_TypeError,
@@ -1506,114 +1860,163 @@ static PyObject *Hey_GetSuites( HeyObject *self, PyObject *args )
 		return NULL;
 	}
 
-	BMessage the_reply;
+	BMessage *msg = new_request( spec, B_GET_SUPPORTED_SUITES );
+	if( msg == NULL ) {
+		return NULL;
+	}
+	if( refuse_fanout( *msg ) ) {
+		delete msg;
+		return NULL;
+	}
 
-	if( spec ) {
-		spec->msg->what = B_GET_SUPPORTED_SUITES;
-		if( self->target->SendMessage( spec->msg, &the_reply ) != B_OK ) {
-			PyErr_SetString( PyExc_RuntimeError,
-				        "error sending GetSuites message" );
+	FutureObject *future = new_future( self, msg, "GetSuites" );
+	delete msg;
 
-			return NULL;
-		}
-	} else {
-		BMessage the_msg( B_GET_SUPPORTED_SUITES );
-		if( self->target->SendMessage( &the_msg, &the_reply ) != B_OK ) {
-			PyErr_SetString( PyExc_RuntimeError,
-				        "error sending GetSuites message" );
+	return (PyObject *)future;
+}
 
-			return NULL;
-		}
+// SetAsync() picks the data type from the value the way Send() and
+// property attributes do (see marshal_value()).
+static PyObject *Hey_SetAsync( HeyObject *self, PyObject *args )
+{
+	SpecifierObject *spec;
+	PyObject *value;
+	if( !PyArg_ParseTuple( args, "O!O", &Specifier_Type, &spec, &value ) ) {
+		PyErr_SetString( PyExc_TypeError,
+				"invalid arguments; expected a Specifier and a value" );
+		return NULL;
+	}
+
+	BMessage *msg = new_request( spec, B_SET_PROPERTY );
+	if( msg == NULL ) {
+		return NULL;
 	}
 
-	return explain_reply( the_reply );
+	if( !marshal_value( "data", value, msg ) ) {
+		delete msg;
+		return NULL;
+	}
+
+	if( refuse_fanout( *msg ) ||
+		!validate_request( self, msg, self->validation, self->send_timeout,
+	                       self->reply_timeout ) ) {
+		delete msg;
+		return NULL;
+	}
+
+	FutureObject *future = new_future( self, msg, "Set" );
+	delete msg;
+
+	return (PyObject *)future;
 }
 
 // ----------------------------------------------------------------------
-// send a specific message; can be string of 1-4 chars, or an int
+// Walk through every item of an indexed property:
+//
+// for line in hey.Iterate( "Line", of = "View 0 of Window 0" ):
+//     ...
 //
-// TODO: can't currently send any extra data along with this... we
-// should take a dictionary and pack each item into the message;
-// difficult to handle properly though.
-static PyObject *Hey_Send( HeyObject *self, PyObject *args )
+// of is a Specifier or a specifier string (leave it out for the
+// application's own properties); page is how many items to ask for at
+// first.  The Iterator changes the page size as it goes, depending on
+// how quickly the target answers.
+static PyObject *Hey_Iterate( HeyObject *self, PyObject *args, PyObject *kwds )
 {
-	// Make sure we got a "what".
-	char *str;
-	uint32 what;
-	if( !PyArg_ParseTuple( args, "i", &what ) ) {
-		// Try to look for ( spec, str ).
-		PyErr_Clear();
+	static char *kwlist[] = { "property", "of", "page", NULL };
+	char *property;
+	PyObject *of = NULL;
+	int page = 64;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "s|Oi", kwlist,
+	                                  &property, &of, &page ) ) {
+		return NULL;
+	}
 
-		if( !PyArg_ParseTuple( args, "s", &str ) ) {
-			// That's bad.
-			PyErr_SetString( PyExc_TypeError,
-					"invalid arguments; expected a message 'what'" );
+	SpecifierObject *spec = NULL;
+	if( of != NULL && of != Py_None ) {
+		PyObject *spec_args = Py_BuildValue( "(O)", of );
+		if( spec_args == NULL ) {
+			return NULL;
+		}
+		spec = parse_specifier( spec_args );
+		Py_DECREF( spec_args );
+		if( spec == NULL ) {
 			return NULL;
-		} else {
-			if( strlen( str ) != 4 ) {
-				PyErr_SetString( PyExc_ValueError,
-					"invalid message 'what'" );
-				return NULL;
-			}
-
-			what = (((uint32)str[0]) << 24 ) +
-				   (((uint32)str[1]) << 16 ) +
-				   (((uint32)str[2]) <<  8 ) +
-				   ((uint32)str[3]);
 		}
 	}
 
-	BMessage msg( what );
-	BMessage the_reply;
-
-	if( self->target->SendMessage( &msg, &the_reply ) != B_OK ) {
-		PyErr_SetString( PyExc_RuntimeError,
-			        "error sending message" );
+	IteratorObject *iter = newIteratorObject( self, property,
+	                                          spec ? spec->msg : NULL, page );
+	Py_XDECREF( spec );
 
-		return NULL;
-	}
-
-	return explain_reply( the_reply );
+	return (PyObject *)iter;
 }
 
 // ----------------------------------------------------------------------
-// Create an empty specifier
-static PyObject *Hey_Specifier( HeyObject *self, PyObject *args )
+// Create a Batch for queueing up requests to this target
+static PyObject *Hey_Batch( HeyObject *self, PyObject *args )
 {
-	return (PyObject *)newSpecifierObject( args );
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return (PyObject *)newBatchObject( self );
 }
 
 // Method table for the Hey object
 static PyMethodDef HeyObject_methods[] = {
-	{ "Quit",	(PyCFunction)Hey_Quit,	1,	"Ask the target to quit." },
-	{ "Save",	(PyCFunction)Hey_Save,	1,	"Ask the target to save the specified document." },
-	{ "Load",	(PyCFunction)Hey_Load,	1,	"Ask the target to load the specified file." },
-	{ "Create",	(PyCFunction)Hey_Create,	1,	"Create a new instance of a property." },
-	{ "Delete",	(PyCFunction)Hey_Delete,	1,	"Delete an instance of a property." },
-	{ "Get",	(PyCFunction)Hey_Get,	1,	"Get the given specifier from the target." },
-	{ "GetSuites",	(PyCFunction)Hey_GetSuites,	1,	"Get the supported suites for the given specifier from the target." },
-	{ "SetString",	(PyCFunction)Hey_SetString,	1,	"Set the given specifier on the target to a string." },
-	{ "SetPath",	(PyCFunction)Hey_SetPath,	1,	"Set the given specifier on the target to a path." },
-	{ "SetColor",	(PyCFunction)Hey_SetColor,	1,	"Set the given specifier on the target to a color." },
-	{ "SetColour",	(PyCFunction)Hey_SetColour,	1,	"Set the given specifier on the target to a colour." },
-	{ "SetRect",	(PyCFunction)Hey_SetRect,	1,	"Set the given specifier on the target to a rectangle." },
-	{ "SetPoint",	(PyCFunction)Hey_SetPoint,	1,	"Set the given specifier on the target to a point." },
-	{ "SetInt",	(PyCFunction)Hey_SetInt,	1,	"Set the given specifier on the target to a number." },
-	{ "SetFloat",	(PyCFunction)Hey_SetFloat,	1,	"Set the given specifier on the target to a floating-point number." },
-	{ "SetBool",	(PyCFunction)Hey_SetBool,	1,	"Set the given specifier on the target to 'true' or 'false'." },
-	{ "SetInt8",	(PyCFunction)Hey_SetInt8,	1,	"Set the given specifier on the target to an 8-bit number." },
-	{ "SetInt16",	(PyCFunction)Hey_SetInt16,	1,	"Set the given specifier on the target to a 16-bit number." },
-	{ "SetInt32",	(PyCFunction)Hey_SetInt32,	1,	"Set the given specifier on the target to a 32-bit number." },
-	{ "SetDouble",	(PyCFunction)Hey_SetDouble,	1,	"Set the given specifier on the target to a double-precision floating-point number." },
-	{ "Count",	(PyCFunction)Hey_Count,	1,	"Count properties in the target." },
-	{ "Send",	(PyCFunction)Hey_Send,	1,	"Send any message to the target." },
+	{ "Quit",	(PyCFunction)Hey_Quit,	METH_VARARGS | METH_KEYWORDS,	"Ask the target to quit." },
+	{ "Save",	(PyCFunction)Hey_Save,	METH_VARARGS | METH_KEYWORDS,	"Ask the target to save the specified document." },
+	{ "Load",	(PyCFunction)Hey_Load,	METH_VARARGS | METH_KEYWORDS,	"Ask the target to load the specified file." },
+	{ "Create",	(PyCFunction)Hey_Create,	METH_VARARGS | METH_KEYWORDS,	"Create a new instance of a property." },
+	{ "Delete",	(PyCFunction)Hey_Delete,	METH_VARARGS | METH_KEYWORDS,	"Delete an instance of a property." },
+	{ "Get",	(PyCFunction)Hey_Get,	METH_VARARGS | METH_KEYWORDS,	"Get the given specifier from the target." },
+	{ "GetSuites",	(PyCFunction)Hey_GetSuites,	METH_VARARGS | METH_KEYWORDS,	"Get the supported suites for the given specifier from the target." },
+	{ "SetString",	(PyCFunction)Hey_SetString,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a string." },
+	{ "SetPath",	(PyCFunction)Hey_SetPath,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a path." },
+	{ "SetColor",	(PyCFunction)Hey_SetColor,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a color." },
+	{ "SetColour",	(PyCFunction)Hey_SetColour,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a colour." },
+	{ "SetRect",	(PyCFunction)Hey_SetRect,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a rectangle." },
+	{ "SetPoint",	(PyCFunction)Hey_SetPoint,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a point." },
+	{ "SetInt",	(PyCFunction)Hey_SetInt,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a number." },
+	{ "SetFloat",	(PyCFunction)Hey_SetFloat,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a floating-point number." },
+	{ "SetBool",	(PyCFunction)Hey_SetBool,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to 'true' or 'false'." },
+	{ "SetInt8",	(PyCFunction)Hey_SetInt8,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to an 8-bit number." },
+	{ "SetInt16",	(PyCFunction)Hey_SetInt16,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a 16-bit number." },
+	{ "SetInt32",	(PyCFunction)Hey_SetInt32,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a 32-bit number." },
+	{ "SetDouble",	(PyCFunction)Hey_SetDouble,	METH_VARARGS | METH_KEYWORDS,	"Set the given specifier on the target to a double-precision floating-point number." },
+	{ "Count",	(PyCFunction)Hey_Count,	METH_VARARGS | METH_KEYWORDS,	"Count properties in the target." },
+	{ "Supports",	(PyCFunction)Hey_Supports,	METH_VARARGS | METH_KEYWORDS,	"Return the suite that supports a property, command and specifier form, or None." },
+	{ "Send",	(PyCFunction)Hey_Send,	METH_VARARGS | METH_KEYWORDS,	"Send any message to the target." },
 	{ "Specifier",	(PyCFunction)Hey_Specifier,	1,	"Create a Specifier for this target." },
+	{ "SetTimeouts",	(PyCFunction)Hey_SetTimeouts,	METH_VARARGS | METH_KEYWORDS,	"Set the reply and delivery timeouts (in seconds) for this target." },
+	{ "Timeouts",	(PyCFunction)Hey_Timeouts,	1,	"Return the ( reply, delivery ) timeouts for this target." },
+	{ "SetLazyReplies",	(PyCFunction)Hey_SetLazyReplies,	1,	"Return Reply objects instead of converting replies right away." },
+	{ "SetValidation",	(PyCFunction)Hey_SetValidation,	1,	"Check requests against the target's suites before sending them (0, 1 or 2)." },
+	{ "Validation",	(PyCFunction)Hey_Validation,	1,	"Return this target's validation mode." },
+	{ "Iterate",	(PyCFunction)Hey_Iterate,	METH_VARARGS | METH_KEYWORDS,	"Return an Iterator over every item of an indexed property." },
+	{ "Batch",	(PyCFunction)Hey_Batch,	1,	"Create a Batch of pipelined requests for this target." },
+	{ "GetAsync",	(PyCFunction)Hey_GetAsync,	1,	"Start a Get and return a Future for the reply." },
+	{ "SetAsync",	(PyCFunction)Hey_SetAsync,	1,	"Start a Set and return a Future for the reply." },
+	{ "CountAsync",	(PyCFunction)Hey_CountAsync,	1,	"Start a Count and return a Future for the reply." },
+	{ "CreateAsync",	(PyCFunction)Hey_CreateAsync,	1,	"Start a Create and return a Future for the reply." },
+	{ "DeleteAsync",	(PyCFunction)Hey_DeleteAsync,	1,	"Start a Delete and return a Future for the reply." },
+	{ "GetSuitesAsync",	(PyCFunction)Hey_GetSuitesAsync,	1,	"Start a GetSuites and return a Future for the reply." },
 	{ NULL,		NULL }		// sentinel
 };
 
+// Anything else starting with a capital letter is one of the
+// application's properties: app.Window[0].Title
 static PyObject *Hey_getattr( HeyObject *self, char *name )
 {
-	return Py_FindMethod( HeyObject_methods, (PyObject *)self, name );
+	PyObject *method = Py_FindMethod( HeyObject_methods, (PyObject *)self,
+	                                  name );
+	if( method == NULL && name[0] >= 'A' && name[0] <= 'Z' &&
+		PyErr_ExceptionMatches( PyExc_AttributeError ) ) {
+		PyErr_Clear();
+		return newProxyObject( self, name );
+	}
+
+	return method;
 }
 
 staticforward PyTypeObject Hey_Type = {
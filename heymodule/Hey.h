@@ -17,12 +17,25 @@
 
 #include "Python.h"
 
+#include "Packed.h"
+
 #include <app/Messenger.h>
+#include <app/Message.h>
+#include <kernel/OS.h>
+
+class BPropertyInfo;
+class HeyConnection;
 
 // The object:
 typedef struct {
 	PyObject_HEAD
 	BMessenger *target;
+	HeyConnection *connection;	// Connect()ed over a socket, or NULL
+	bigtime_t send_timeout;		// delivery deadline for requests
+	bigtime_t reply_timeout;	// how long to wait for a reply
+	int lazy_replies;			// hand back Reply objects?
+	int validation;				// check requests against the suites first?
+	PyObject *proxies;			// shape -> Template for attribute access
 } HeyObject;
 
 // The object's type:
@@ -33,5 +46,84 @@ extern PyTypeObject Hey_Type;
 
 // Methods you can use.
 HeyObject *newHeyObject( PyObject *arg );
+HeyObject *newHeyObjectFromMessenger( const BMessenger &messenger );
+
+// Create a Hey object that sends everything over connection (which it
+// takes over); its target is an empty messenger.
+HeyObject *newHeyObjectFromConnection( HeyConnection *connection );
+
+// The target's team, whichever way we're talking to it.
+team_id hey_team( HeyObject *self );
+
+// Raised when a target doesn't take a request, or doesn't answer it, in
+// time; it's a RuntimeError, so old scripts still catch it.
+extern PyObject *HeyTimeoutError;
+
+// Raised when a request is turned down before it's sent, because the
+// target's suites say it won't understand it; also a RuntimeError.
+extern PyObject *HeyUnsupportedError;
+
+// Module functions for the timeouts new Hey objects start with.
+PyObject *Hey_SetDefaultTimeouts( PyObject *self, PyObject *args, PyObject *kwds );
+PyObject *Hey_DefaultTimeouts( PyObject *self, PyObject *args );
+
+// Send request to the target and wait for its reply (into reply), with
+// the interpreter lock released.  Returns false and sets an exception
+// (TimeoutError if time ran out) if that didn't work; name is the command
+// for the error message and the statistics, or NULL.  The request is
+// recorded and counted here.
+bool send_and_wait( HeyObject *self, BMessage *request, BMessage *reply,
+                    bigtime_t send_timeout, bigtime_t reply_timeout,
+                    const char *name );
+
+// send_pipelined() to the target, or over the connection; doesn't need
+// the interpreter lock.
+status_t hey_send_pipelined( HeyObject *self, BMessage **requests,
+                             BMessage **replies, int32 count,
+                             bigtime_t timeout = B_INFINITE_TIMEOUT,
+                             bigtime_t send_timeout = B_INFINITE_TIMEOUT );
+
+// What a Set method sets the property to.
+enum {
+	SET_STRING,
+	SET_PATH,		// an entry_ref, from a path
+	SET_COLOR,
+	SET_RECT,
+	SET_POINT,
+	SET_INT8,
+	SET_INT16,
+	SET_INT32,
+	SET_FLOAT,
+	SET_DOUBLE,
+	SET_BOOL		// a number, or "true", "yes" and so on
+};
+
+// Build a B_SET_PROPERTY request from a Set method's arguments (a
+// Specifier and a value of kind); returns NULL and sets an exception if
+// they're wrong.  The Hey and Batch Set methods both use this.
+BMessage *new_set_request( PyObject *args, int kind );
+
+// Send request to the target and convert the reply, the way Get() and
+// friends do; kwds holds the caller's keyword arguments (timeouts and so
+// on), or NULL.
+PyObject *send_request( HeyObject *self, BMessage *request,
+                        const char *name, PyObject *kwds );
+
+// Turn a scripting reply into something useful for Python; returns NULL
+// and sets an exception if the target didn't like the request.  packed
+// says whether numeric results come back as a PackedArray.
+PyObject *explain_reply( const BMessage &reply, int packed = PACK_AUTO );
+
+// Convert a whole message into a dictionary of lists, one per field.
+PyObject *msg_to_dict( const BMessage &msg );
+
+// Convert one item of message data into a Python object.
+PyObject *obj_to_python( uint32 type, const void *ptr, ssize_t size );
+
+// Turn a suite's property_info into a dictionary, keyed by property name.
+PyObject *build_property_info_dict( const BPropertyInfo& pi );
+
+// How many items are in a message field (0 if there's no such field).
+int32 count_message_items( const BMessage& msg, const char* name );
 
 #endif
@@ -0,0 +1,425 @@
+// Iterator
+//
+// The Iterator object is used by heymodule to walk through every item of
+// an indexed property a page at a time.  It asks for a Count first, then
+// gets the items with range specifiers ("Line [0 to 99] of View 0 of
+// Window 0"), so a 10,000 line document is a handful of round trips
+// instead of 10,000 of them.
+//
+// Python's for loop just calls __getitem__ with 0, 1, 2... until it gets
+// an IndexError; that's all an Iterator does, so it won't mind if you
+// index it directly, but it's fastest when you go in order.
+//
+// Lots of targets don't understand range specifiers for everything (or
+// quietly give you the first item of the range); if the first page goes
+// wrong like that, we fall back to index specifiers, sent a page at a
+// time back-to-back (see hey_send_pipelined()).
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Iterator.h"
+#include "FanOut.h"
+
+#include <app/Message.h>
+#include <string.h>
+#include <new>
+
+// Page sizes are kept between these.
+#define MIN_PAGE	1
+#define MAX_PAGE	4096
+
+// Pages that come back faster than this get twice as big next time;
+// pages that take longer than slow_page get cut in half.
+static const bigtime_t fast_page = 20000;
+static const bigtime_t slow_page = 200000;
+
+static BMessage *build_request( IteratorObject *self, uint32 what,
+                                int32 index, int32 range );
+static bool reply_ok( const BMessage &reply );
+static PyObject *fetch_range( IteratorObject *self, int32 start, int32 run );
+static PyObject *fetch_indexed( IteratorObject *self, int32 start, int32 run );
+static bool fetch_page( IteratorObject *self, int32 start );
+
+// ======================================================================
+// Iterator object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Create a new Iterator; this sends the Count.
+IteratorObject *newIteratorObject( HeyObject *hey, const char *property,
+                                   const BMessage *of, int32 page )
+{
+	IteratorObject *self;
+	self = PyObject_NEW( IteratorObject, &Iterator_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	Py_INCREF( hey );
+	self->hey = hey;
+	self->of = NULL;
+	self->count = 0;
+	self->first = 0;
+	self->items = NULL;
+	self->page = page < MIN_PAGE ? MIN_PAGE : ( page > MAX_PAGE ? MAX_PAGE : page );
+	self->ranges = -1;
+
+	self->property = PyString_FromString( (char *)property );
+	if( self->property == NULL ) {
+		Py_DECREF( self );
+		return NULL;
+	}
+
+	if( of ) {
+		try {
+			self->of = new BMessage( *of );
+		} catch ( bad_alloc &ex ) {
+			Py_DECREF( self );
+			return (IteratorObject *)PyErr_NoMemory();
+		}
+	}
+
+	// How many are there?  Every page goes to the same place, so a "*" or
+	// range in of can't be sent.
+	BMessage *request = build_request( self, B_COUNT_PROPERTIES, -1, 0 );
+	if( request == NULL ) {
+		Py_DECREF( self );
+		return NULL;
+	}
+	if( refuse_fanout( *request ) ) {
+		delete request;
+		Py_DECREF( self );
+		return NULL;
+	}
+
+	BMessage reply;
+	bool sent = send_and_wait( hey, request, &reply, hey->send_timeout,
+	                           hey->reply_timeout, "Count" );
+	delete request;
+	if( !sent ) {
+		Py_DECREF( self );
+		return NULL;
+	}
+
+	if( reply.what != B_REPLY ) {
+		(void)explain_reply( reply );	// sets the exception
+		Py_DECREF( self );
+		return NULL;
+	}
+
+	if( reply.FindInt32( "result", &self->count ) != B_OK ) {
+		PyErr_SetString( PyExc_RuntimeError, "target didn't return a count" );
+		Py_DECREF( self );
+		return NULL;
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Delete an Iterator object
+static void Iterator_dealloc( IteratorObject *self )
+{
+	delete self->of;
+	Py_XDECREF( self->items );
+	Py_XDECREF( self->property );
+	Py_DECREF( self->hey );
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Build a request for our property: a direct specifier if index is
+// negative, an index specifier if range is 0, a range specifier
+// otherwise.  The "of" part goes on after it.
+static BMessage *build_request( IteratorObject *self, uint32 what,
+                                int32 index, int32 range )
+{
+	BMessage *msg;
+	try {
+		msg = new BMessage( what );
+	} catch ( bad_alloc &ex ) {
+		(void)PyErr_NoMemory();
+		return NULL;
+	}
+
+	const char *property = PyString_AsString( self->property );
+	if( index < 0 ) {
+		msg->AddSpecifier( property );
+	} else if( range == 0 ) {
+		msg->AddSpecifier( property, index );
+	} else {
+		msg->AddSpecifier( property, index, range );
+	}
+
+	if( self->of ) {
+		BMessage spec;
+		for( int32 idx = 0;
+			 self->of->FindMessage( "specifiers", idx, &spec ) == B_OK;
+			 idx++ ) {
+			msg->AddSpecifier( &spec );
+		}
+	}
+
+	return msg;
+}
+
+// ----------------------------------------------------------------------
+// Did the target like the request?
+static bool reply_ok( const BMessage &reply )
+{
+	int32 error;
+	if( reply.what != B_REPLY ) return false;
+	if( reply.FindInt32( "error", &error ) == B_OK && error != B_OK ) return false;
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Get run items starting at start with one range specifier.  Returns
+// NULL without an exception if the target doesn't seem to do ranges for
+// this property (and we didn't already know it did).
+static PyObject *fetch_range( IteratorObject *self, int32 start, int32 run )
+{
+	BMessage *request = build_request( self, B_GET_PROPERTY, start, run );
+	if( request == NULL ) {
+		return NULL;
+	}
+
+	BMessage reply;
+	bool sent = send_and_wait( self->hey, request, &reply,
+	                           self->hey->send_timeout,
+	                           self->hey->reply_timeout, "Get" );
+	delete request;
+	if( !sent ) {
+		return NULL;
+	}
+
+	if( self->ranges < 0 ) {
+		// First time; if it's an error, or we asked for several and got
+		// one, the target didn't understand.
+		int32 got = count_message_items( reply, "result" );
+		if( !reply_ok( reply ) || ( run > 1 && got == 1 ) ) {
+			self->ranges = 0;
+			return NULL;
+		}
+
+		self->ranges = 1;
+	}
+
+	// fetch_page() needs a list, however big the page gets.
+	return explain_reply( reply, PACK_NEVER );
+}
+
+// ----------------------------------------------------------------------
+// Get run items starting at start with one index specifier each, all
+// sent at once.  The page stops short at the first item the target
+// couldn't find (they went away since the Count, probably); if that's the
+// very first item, you get the target's error.
+static PyObject *fetch_indexed( IteratorObject *self, int32 start, int32 run )
+{
+	BMessage **requests;
+	BMessage **replies;
+	try {
+		requests = new BMessage *[run];
+	} catch ( bad_alloc &ex ) {
+		return PyErr_NoMemory();
+	}
+	try {
+		replies = new BMessage *[run];
+	} catch ( bad_alloc &ex ) {
+		delete [] requests;
+		return PyErr_NoMemory();
+	}
+
+	int32 built = 0;
+	for( ; built < run; built++ ) {
+		requests[built] = build_request( self, B_GET_PROPERTY, start + built, 0 );
+		if( requests[built] == NULL ) break;
+	}
+
+	PyObject *items = NULL;
+	if( built == run ) {
+		status_t retval;
+
+		Py_BEGIN_ALLOW_THREADS
+		retval = hey_send_pipelined( self->hey, requests, replies, run,
+		                             self->hey->reply_timeout,
+		                             self->hey->send_timeout );
+		Py_END_ALLOW_THREADS
+
+		int32 got = 0;
+		while( got < run && replies[got] && reply_ok( *replies[got] ) ) {
+			got++;
+		}
+
+		if( got == 0 && replies[0] == NULL ) {
+			PyErr_SetString( retval == B_TIMED_OUT ? HeyTimeoutError : PyExc_RuntimeError,
+					retval == B_TIMED_OUT ? "timed out waiting for reply" : "error sending Get message" );
+		} else if( got == 0 && start == 0 ) {
+			(void)explain_reply( *replies[0] );	// sets the exception
+		} else {
+			items = PyList_New( got );
+		}
+
+		for( int32 idx = 0; items && idx < got; idx++ ) {
+			PyObject *obj = explain_reply( *replies[idx], PACK_NEVER );
+
+			// A one-item result is the item.
+			if( obj && PyList_Check( obj ) && PyList_Size( obj ) == 1 ) {
+				PyObject *item = PyList_GetItem( obj, 0 );
+				Py_INCREF( item );
+				Py_DECREF( obj );
+				obj = item;
+			}
+
+			if( obj == NULL ) {
+				Py_DECREF( items );
+				items = NULL;
+				break;
+			}
+
+			(void)PyList_SetItem( items, idx, obj );
+		}
+
+		for( int32 idx = 0; idx < run; idx++ ) {
+			delete replies[idx];
+		}
+	}
+
+	for( int32 idx = 0; idx < built; idx++ ) {
+		delete requests[idx];
+	}
+	delete [] requests;
+	delete [] replies;
+
+	return items;
+}
+
+// ----------------------------------------------------------------------
+// Load the page starting at start, and size the next one by how long this
+// one took.
+static bool fetch_page( IteratorObject *self, int32 start )
+{
+	int32 run = self->count - start;
+	if( run > self->page ) run = self->page;
+
+	bigtime_t began = system_time();
+
+	PyObject *items = NULL;
+	if( self->ranges != 0 ) {
+		items = fetch_range( self, start, run );
+		if( items == NULL && PyErr_Occurred() ) {
+			return false;
+		}
+	}
+	if( items == NULL ) {
+		items = fetch_indexed( self, start, run );
+		if( items == NULL ) {
+			return false;
+		}
+	}
+
+	bigtime_t took = system_time() - began;
+	if( took < fast_page && self->page < MAX_PAGE ) {
+		self->page *= 2;
+		if( self->page > MAX_PAGE ) self->page = MAX_PAGE;
+	} else if( took > slow_page && self->page > MIN_PAGE ) {
+		self->page /= 2;
+	}
+
+	Py_XDECREF( self->items );
+	self->items = items;
+	self->first = start;
+
+	// Fewer than we asked for means there are fewer than the Count said.
+	if( PyList_Size( items ) < run ) {
+		self->count = start + PyList_Size( items );
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Sequence protocol: len( iterator ) is the Count, and iterator[ n ] is
+// the nth item, fetched with the rest of its page if we don't have it.
+static int Iterator_length( IteratorObject *self )
+{
+	return self->count;
+}
+
+static PyObject *Iterator_item( IteratorObject *self, int index )
+{
+	if( index < 0 || index >= self->count ) {
+		PyErr_SetString( PyExc_IndexError, "Iterator index out of range" );
+		return NULL;
+	}
+
+	if( self->items == NULL || index < self->first ||
+		index >= self->first + PyList_Size( self->items ) ) {
+		if( !fetch_page( self, index ) ) {
+			return NULL;
+		}
+
+		if( index >= self->count ) {
+			PyErr_SetString( PyExc_IndexError, "Iterator index out of range" );
+			return NULL;
+		}
+	}
+
+	PyObject *item = PyList_GetItem( self->items, index - self->first );
+	Py_XINCREF( item );
+	return item;
+}
+
+// ----------------------------------------------------------------------
+// The attributes are there so you can see what it's doing.
+static PyObject *Iterator_getattr( IteratorObject *self, char *name )
+{
+	if( strcmp( name, "page" ) == 0 ) {
+		return PyInt_FromLong( self->page );
+	} else if( strcmp( name, "ranges" ) == 0 ) {
+		return PyInt_FromLong( self->ranges );
+	} else if( strcmp( name, "property" ) == 0 ) {
+		Py_INCREF( self->property );
+		return self->property;
+	}
+
+	PyErr_SetString( PyExc_AttributeError, name );
+	return NULL;
+}
+
+static PySequenceMethods Iterator_as_sequence = {
+	(inquiry)Iterator_length,		// sq_length
+	0,								// sq_concat
+	0,								// sq_repeat
+	(intargfunc)Iterator_item,		// sq_item
+	0,								// sq_slice
+	0,								// sq_ass_item
+	0,								// sq_ass_slice
+};
+
+PyTypeObject Iterator_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"Iterator",			// tp_name
+	sizeof(IteratorObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)Iterator_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)Iterator_getattr, // tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	&Iterator_as_sequence,	// tp_as_sequence
+	0,			// tp_as_mapping
+	0,			// tp_hash
+};
@@ -0,0 +1,52 @@
+// Iterator
+//
+// The Iterator object is used by heymodule to walk through every item of
+// an indexed property (the Lines of a document, say) a page at a time,
+// instead of one request per item.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Iterator_H
+#define PyHey_Iterator_H
+
+#include "Python.h"
+
+#include "Hey.h"
+
+#include <app/Message.h>
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	HeyObject *hey;		// where the requests go
+	PyObject *property;	// the property we're walking through (a string)
+	BMessage *of;		// what it's a property of; NULL for the application
+	int32 count;		// how many items there are
+	int32 first;		// index of the first item in items
+	PyObject *items;	// the page we're on (a list), or NULL
+	int32 page;			// how many items to ask for next time
+	int ranges;			// range specifiers work: 1 yes, 0 no, -1 don't know
+} IteratorObject;
+
+// The object's type:
+extern PyTypeObject Iterator_Type;
+
+// Macro for checking the type:
+#define IteratorObject_Check(v)	((v)->ob_type == &Iterator_Type)
+
+// Methods you can use.
+//
+// Ask hey's target how many property items there are in of (which can be
+// NULL), and return an Iterator for them that starts out fetching page
+// items at a time.
+IteratorObject *newIteratorObject( HeyObject *hey, const char *property,
+                                   const BMessage *of, int32 page );
+
+#endif
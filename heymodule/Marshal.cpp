@@ -0,0 +1,508 @@
+// Marshal
+//
+// The marshaller is used by heymodule to pack Python data into a
+// BMessage.  Types are worked out from the values:
+//
+//     int                        B_INT32_TYPE (B_INT64_TYPE if it won't fit)
+//     long int                   B_INT64_TYPE
+//     float                      B_DOUBLE_TYPE
+//     string                     B_STRING_TYPE (B_RAW_TYPE if it has NULs)
+//     buffer                     B_RAW_TYPE
+//     ( x, y )                   B_POINT_TYPE
+//     ( r, g, b )                B_RGB_COLOR_TYPE (opaque)
+//     ( left, top, right, bottom )  B_RECT_TYPE
+//     dictionary                 B_MESSAGE_TYPE
+//     list                       one item per list entry, same field
+//
+// or you can say what you want with a ( type, value ) tuple, where type is
+// one of the names in hint_names below, or a type code (a number or four
+// characters) for raw data of that type.
+//
+// Everything is added straight into the message as we go; the only
+// copies are the ones BMessage makes.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Marshal.h"
+
+#include <app/Message.h>
+#include <interface/GraphicsDefs.h>
+#include <interface/Point.h>
+#include <interface/Rect.h>
+#include <storage/Entry.h>
+#include <support/TypeConstants.h>
+#include <string.h>
+#include <stdio.h>
+
+// Type names for ( type, value ) hints.
+static struct {
+	const char *name;
+	type_code type;
+} hint_names[] = {
+	{ "bool",		B_BOOL_TYPE },
+	{ "int8",		B_INT8_TYPE },
+	{ "int16",		B_INT16_TYPE },
+	{ "int32",		B_INT32_TYPE },
+	{ "int64",		B_INT64_TYPE },
+	{ "float",		B_FLOAT_TYPE },
+	{ "double",		B_DOUBLE_TYPE },
+	{ "string",		B_STRING_TYPE },
+	{ "mime",		B_MIME_TYPE },
+	{ "point",		B_POINT_TYPE },
+	{ "rect",		B_RECT_TYPE },
+	{ "color",		B_RGB_COLOR_TYPE },
+	{ "colour",		B_RGB_COLOR_TYPE },
+	{ "raw",		B_RAW_TYPE },
+	{ "message",	B_MESSAGE_TYPE },
+	{ "ref",		B_REF_TYPE },
+	{ NULL,			0 }
+};
+
+static bool marshal_error( PyObject *type, const char *what, const char *name );
+static bool get_double( PyObject *obj, double *val );
+static bool get_int64( PyObject *obj, int64 *val );
+static bool get_bytes( PyObject *obj, const void **ptr, int *size );
+static bool get_numbers( PyObject *seq, double *vals, int count );
+static bool add_typed( const char *name, type_code type, PyObject *value,
+                       BMessage *msg );
+static bool add_message( const char *name, PyObject *value, BMessage *msg );
+static bool add_hinted( const char *name, PyObject *hint, PyObject *value,
+                        BMessage *msg );
+
+// ======================================================================
+// Helpers
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static bool marshal_error( PyObject *type, const char *what, const char *name )
+{
+	char buff[128];
+	sprintf( buff, "%.48s for field '%.48s'", what, name );
+	PyErr_SetString( type, buff );
+	return false;
+}
+
+// ----------------------------------------------------------------------
+// Numbers of any kind.
+static bool get_double( PyObject *obj, double *val )
+{
+	if( PyFloat_Check( obj ) ) {
+		*val = PyFloat_AsDouble( obj );
+	} else if( PyInt_Check( obj ) ) {
+		*val = (double)PyInt_AsLong( obj );
+	} else if( PyLong_Check( obj ) ) {
+		*val = PyLong_AsDouble( obj );
+	} else {
+		return false;
+	}
+
+	return !PyErr_Occurred();
+}
+
+static bool get_int64( PyObject *obj, int64 *val )
+{
+	if( PyInt_Check( obj ) ) {
+		*val = PyInt_AsLong( obj );
+	} else if( PyLong_Check( obj ) ) {
+		*val = PyLong_AsLongLong( obj );
+	} else if( PyFloat_Check( obj ) ) {
+		*val = (int64)PyFloat_AsDouble( obj );
+	} else {
+		return false;
+	}
+
+	return !PyErr_Occurred();
+}
+
+// ----------------------------------------------------------------------
+// The bytes in a string or a (single-segment) buffer, in place.
+static bool get_bytes( PyObject *obj, const void **ptr, int *size )
+{
+	if( PyString_Check( obj ) ) {
+		*ptr = PyString_AsString( obj );
+		*size = PyString_Size( obj );
+		return true;
+	}
+
+	PyBufferProcs *procs = obj->ob_type->tp_as_buffer;
+	if( procs == NULL || procs->bf_getreadbuffer == NULL ||
+		procs->bf_getsegcount == NULL ||
+		(*procs->bf_getsegcount)( obj, NULL ) != 1 ) {
+		return false;
+	}
+
+	void *data;
+	*size = (*procs->bf_getreadbuffer)( obj, 0, &data );
+	*ptr = data;
+
+	return *size >= 0;
+}
+
+// ----------------------------------------------------------------------
+// Pull count numbers out of a tuple or list.
+static bool get_numbers( PyObject *seq, double *vals, int count )
+{
+	if( PyTuple_Check( seq ) ) {
+		if( PyTuple_Size( seq ) != count ) return false;
+		for( int i = 0; i < count; i++ ) {
+			if( !get_double( PyTuple_GET_ITEM( seq, i ), &vals[i] ) ) return false;
+		}
+		return true;
+	}
+
+	if( PyList_Check( seq ) ) {
+		if( PyList_Size( seq ) != count ) return false;
+		for( int i = 0; i < count; i++ ) {
+			if( !get_double( PyList_GET_ITEM( seq, i ), &vals[i] ) ) return false;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// ======================================================================
+// The marshaller
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Add value as the given type.
+static bool add_typed( const char *name, type_code type, PyObject *value,
+                       BMessage *msg )
+{
+	// A list of values all go in as the same type.
+	if( PyList_Check( value ) && type != B_POINT_TYPE &&
+		type != B_RECT_TYPE && type != B_RGB_COLOR_TYPE ) {
+		for( int i = 0; i < PyList_Size( value ); i++ ) {
+			if( !add_typed( name, type, PyList_GET_ITEM( value, i ), msg ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	status_t retval = B_OK;
+	int64 l;
+	double d;
+	double vals[4];
+	const void *ptr;
+	int size;
+
+	switch( type ) {
+	case B_BOOL_TYPE:
+		retval = msg->AddBool( name, PyObject_IsTrue( value ) ? true : false );
+		break;
+
+	case B_INT8_TYPE:
+	case B_INT16_TYPE:
+	case B_INT32_TYPE:
+	case B_INT64_TYPE:
+		if( !get_int64( value, &l ) ) {
+			return marshal_error( PyExc_TypeError, "expected an integer", name );
+		}
+		if( ( type == B_INT8_TYPE && ( l < -128 || l > 255 ) ) ||
+			( type == B_INT16_TYPE && ( l < -32768 || l > 65535 ) ) ||
+			( type == B_INT32_TYPE && ( l < -2147483647LL - 1 || l > 4294967295LL ) ) ) {
+			return marshal_error( PyExc_OverflowError, "integer too big", name );
+		}
+
+		switch( type ) {
+		case B_INT8_TYPE:	retval = msg->AddInt8( name, (int8)l );	break;
+		case B_INT16_TYPE:	retval = msg->AddInt16( name, (int16)l );	break;
+		case B_INT32_TYPE:	retval = msg->AddInt32( name, (int32)l );	break;
+		default:			retval = msg->AddInt64( name, l );	break;
+		}
+		break;
+
+	case B_FLOAT_TYPE:
+	case B_DOUBLE_TYPE:
+		if( !get_double( value, &d ) ) {
+			return marshal_error( PyExc_TypeError, "expected a number", name );
+		}
+		if( type == B_FLOAT_TYPE ) {
+			retval = msg->AddFloat( name, (float)d );
+		} else {
+			retval = msg->AddDouble( name, d );
+		}
+		break;
+
+	case B_STRING_TYPE:
+	case B_MIME_TYPE:
+		if( !PyString_Check( value ) ) {
+			return marshal_error( PyExc_TypeError, "expected a string", name );
+		}
+		retval = msg->AddData( name, type, PyString_AsString( value ),
+		                       PyString_Size( value ) + 1, false );
+		break;
+
+	case B_POINT_TYPE:
+		if( !get_numbers( value, vals, 2 ) ) {
+			return marshal_error( PyExc_TypeError, "expected ( x, y )", name );
+		}
+		retval = msg->AddPoint( name, BPoint( (float)vals[0], (float)vals[1] ) );
+		break;
+
+	case B_RECT_TYPE:
+		if( !get_numbers( value, vals, 4 ) ) {
+			return marshal_error( PyExc_TypeError,
+					"expected ( left, top, right, bottom )", name );
+		}
+		retval = msg->AddRect( name, BRect( (float)vals[0], (float)vals[1],
+		                                    (float)vals[2], (float)vals[3] ) );
+		break;
+
+	case B_RGB_COLOR_TYPE:
+		{
+			vals[3] = 255.0;
+			if( !get_numbers( value, vals, 3 ) && !get_numbers( value, vals, 4 ) ) {
+				return marshal_error( PyExc_TypeError,
+						"expected ( red, green, blue[, alpha] )", name );
+			}
+
+			rgb_color colour;
+			colour.red = (uint8)vals[0];
+			colour.green = (uint8)vals[1];
+			colour.blue = (uint8)vals[2];
+			colour.alpha = (uint8)vals[3];
+			retval = msg->AddData( name, B_RGB_COLOR_TYPE, &colour,
+			                       sizeof( rgb_color ) );
+		}
+		break;
+
+	case B_MESSAGE_TYPE:
+		return add_message( name, value, msg );
+
+	case B_REF_TYPE:
+		{
+			if( !PyString_Check( value ) ) {
+				return marshal_error( PyExc_TypeError, "expected a path", name );
+			}
+
+			entry_ref ref;
+			retval = get_ref_for_path( PyString_AsString( value ), &ref );
+			if( retval != B_OK ) {
+				return marshal_error( PyExc_IOError, "can't find file", name );
+			}
+			retval = msg->AddRef( name, &ref );
+		}
+		break;
+
+	default:
+		// Raw data, of whatever type you say.
+		if( !get_bytes( value, &ptr, &size ) ) {
+			return marshal_error( PyExc_TypeError,
+					"expected a string or buffer", name );
+		}
+		retval = msg->AddData( name, type, ptr, size, false );
+		break;
+	}
+
+	if( retval != B_OK ) {
+		// Usually because the field already has items of another type.
+		return marshal_error( PyExc_ValueError, "can't add item", name );
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// A nested message: a dictionary (or sequence of pairs) of its fields, or
+// ( what, fields ).
+static bool add_message( const char *name, PyObject *value, BMessage *msg )
+{
+	BMessage sub;
+	PyObject *fields = value;
+
+	if( PyTuple_Check( value ) && PyTuple_Size( value ) == 2 &&
+		!PyTuple_Check( PyTuple_GET_ITEM( value, 0 ) ) ) {
+		if( !what_from_python( PyTuple_GET_ITEM( value, 0 ), &sub.what ) ) {
+			return false;
+		}
+		fields = PyTuple_GET_ITEM( value, 1 );
+	}
+
+	if( !marshal_fields( fields, &sub ) ) {
+		return false;
+	}
+
+	if( msg->AddMessage( name, &sub ) != B_OK ) {
+		return marshal_error( PyExc_ValueError, "can't add message", name );
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// ( type, value ): type is a name from hint_names, or a type code.
+static bool add_hinted( const char *name, PyObject *hint, PyObject *value,
+                        BMessage *msg )
+{
+	if( PyString_Check( hint ) ) {
+		const char *str = PyString_AsString( hint );
+		for( int i = 0; hint_names[i].name; i++ ) {
+			if( strcmp( str, hint_names[i].name ) == 0 ) {
+				return add_typed( name, hint_names[i].type, value, msg );
+			}
+		}
+	}
+
+	uint32 type;
+	if( !what_from_python( hint, &type ) ) {
+		PyErr_Clear();
+		return marshal_error( PyExc_ValueError, "unknown type", name );
+	}
+
+	return add_typed( name, type, value, msg );
+}
+
+// ----------------------------------------------------------------------
+bool marshal_value( const char *name, PyObject *value, BMessage *msg )
+{
+	if( PyInt_Check( value ) ) {
+		long l = PyInt_AsLong( value );
+		if( (long)(int32)l == l ) {
+			return add_typed( name, B_INT32_TYPE, value, msg );
+		}
+		return add_typed( name, B_INT64_TYPE, value, msg );
+	}
+
+	if( PyLong_Check( value ) ) {
+		return add_typed( name, B_INT64_TYPE, value, msg );
+	}
+
+	if( PyFloat_Check( value ) ) {
+		return add_typed( name, B_DOUBLE_TYPE, value, msg );
+	}
+
+	if( PyString_Check( value ) ) {
+		const char *str = PyString_AsString( value );
+		int size = PyString_Size( value );
+		if( (int)strlen( str ) == size ) {
+			return add_typed( name, B_STRING_TYPE, value, msg );
+		}
+		return add_typed( name, B_RAW_TYPE, value, msg );
+	}
+
+	if( PyDict_Check( value ) ) {
+		return add_message( name, value, msg );
+	}
+
+	if( PyList_Check( value ) ) {
+		for( int i = 0; i < PyList_Size( value ); i++ ) {
+			if( !marshal_value( name, PyList_GET_ITEM( value, i ), msg ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	if( PyTuple_Check( value ) ) {
+		switch( PyTuple_Size( value ) ) {
+		case 2:
+			{
+				// ( type, value ), unless it's a point.
+				PyObject *first = PyTuple_GET_ITEM( value, 0 );
+				double second;
+				if( PyString_Check( first ) ||
+					( PyInt_Check( first ) &&
+					  !get_double( PyTuple_GET_ITEM( value, 1 ), &second ) ) ) {
+					return add_hinted( name, first, PyTuple_GET_ITEM( value, 1 ),
+					                   msg );
+				}
+			}
+			return add_typed( name, B_POINT_TYPE, value, msg );
+
+		case 3:
+			return add_typed( name, B_RGB_COLOR_TYPE, value, msg );
+
+		case 4:
+			return add_typed( name, B_RECT_TYPE, value, msg );
+
+		default:
+			break;
+		}
+	} else {
+		const void *ptr;
+		int size;
+		if( get_bytes( value, &ptr, &size ) ) {
+			return add_typed( name, B_RAW_TYPE, value, msg );
+		}
+	}
+
+	char buff[64];
+	sprintf( buff, "can't put a %.32s in a message", value->ob_type->tp_name );
+	return marshal_error( PyExc_TypeError, buff, name );
+}
+
+// ----------------------------------------------------------------------
+bool marshal_fields( PyObject *payload, BMessage *msg )
+{
+	if( PyDict_Check( payload ) ) {
+		int pos = 0;
+		PyObject *key;
+		PyObject *value;
+		while( PyDict_Next( payload, &pos, &key, &value ) ) {
+			if( !PyString_Check( key ) ) {
+				PyErr_SetString( PyExc_TypeError, "field names must be strings" );
+				return false;
+			}
+			if( !marshal_value( PyString_AsString( key ), value, msg ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// A sequence of ( name, value ) pairs keeps the fields in order.
+	if( PyList_Check( payload ) || PyTuple_Check( payload ) ) {
+		int count = PyList_Check( payload ) ? PyList_Size( payload )
+		                                    : PyTuple_Size( payload );
+		for( int i = 0; i < count; i++ ) {
+			PyObject *pair = PyList_Check( payload ) ? PyList_GET_ITEM( payload, i )
+			                                         : PyTuple_GET_ITEM( payload, i );
+			if( !PyTuple_Check( pair ) || PyTuple_Size( pair ) != 2 ||
+				!PyString_Check( PyTuple_GET_ITEM( pair, 0 ) ) ) {
+				PyErr_SetString( PyExc_TypeError,
+						"expected ( name, value ) pairs" );
+				return false;
+			}
+			if( !marshal_value( PyString_AsString( PyTuple_GET_ITEM( pair, 0 ) ),
+			                    PyTuple_GET_ITEM( pair, 1 ), msg ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	PyErr_SetString( PyExc_TypeError,
+			"expected a dictionary or a sequence of ( name, value ) pairs" );
+	return false;
+}
+
+// ----------------------------------------------------------------------
+bool what_from_python( PyObject *obj, uint32 *what )
+{
+	if( PyInt_Check( obj ) ) {
+		*what = (uint32)PyInt_AsLong( obj );
+		return true;
+	}
+
+	if( PyString_Check( obj ) && PyString_Size( obj ) == 4 ) {
+		const char *str = PyString_AsString( obj );
+		*what = (((uint32)(uint8)str[0]) << 24 ) +
+		        (((uint32)(uint8)str[1]) << 16 ) +
+		        (((uint32)(uint8)str[2]) <<  8 ) +
+		        ((uint32)(uint8)str[3]);
+		return true;
+	}
+
+	PyErr_SetString( PyExc_ValueError, "invalid message 'what'" );
+	return false;
+}
@@ -0,0 +1,35 @@
+// Marshal
+//
+// The marshaller is used by heymodule to pack Python data into a
+// BMessage, so Send() can carry more than a bare "what" code.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Marshal_H
+#define PyHey_Marshal_H
+
+#include "Python.h"
+
+#include <app/Message.h>
+
+// Add the fields in payload (a dictionary, or a sequence of
+// ( name, value ) pairs) to msg.  Returns false and sets an exception if
+// something in there can't go in a message; msg may have some of the
+// fields in it by then.
+bool marshal_fields( PyObject *payload, BMessage *msg );
+
+// Add one value to msg under name, working out the type from the value
+// (or from a ( type, value ) hint).  A list adds each of its items.
+bool marshal_value( const char *name, PyObject *value, BMessage *msg );
+
+// Get a message "what" from a number or a four-character string.
+bool what_from_python( PyObject *obj, uint32 *what );
+
+#endif
@@ -0,0 +1,153 @@
+// MessageWalker
+//
+// Walks through every field of a BMessage once, in order, handing out
+// each field's name, type and item count along with the items' data.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "MessageWalker.h"
+
+#include <support/TypeConstants.h>
+
+// ----------------------------------------------------------------------
+// Types whose items are always the same size; only these are worth
+// checking for a single block of items.
+static bool fixed_size_type( type_code type )
+{
+	switch( type ) {
+	case B_BOOL_TYPE:		// fall through
+	case B_INT8_TYPE:		// fall through
+	case B_UINT8_TYPE:		// fall through
+	case B_INT16_TYPE:		// fall through
+	case B_UINT16_TYPE:		// fall through
+	case B_INT32_TYPE:		// fall through
+	case B_UINT32_TYPE:		// fall through
+	case B_INT64_TYPE:		// fall through
+	case B_UINT64_TYPE:		// fall through
+	case B_SIZE_T_TYPE:		// fall through
+	case B_SSIZE_T_TYPE:	// fall through
+	case B_FLOAT_TYPE:		// fall through
+	case B_DOUBLE_TYPE:		// fall through
+	case B_POINT_TYPE:		// fall through
+	case B_RECT_TYPE:		// fall through
+	case B_RGB_COLOR_TYPE:
+		return true;
+	}
+
+	return false;
+}
+
+// ======================================================================
+// MessageWalker
+// ======================================================================
+
+// ----------------------------------------------------------------------
+MessageWalker::MessageWalker( const BMessage &m )
+	: msg( m ), which( -1 ), names( m.CountNames( B_ANY_TYPE ) ),
+	  name( NULL ), type( 0 ), count( 0 )
+{
+	StartField();
+}
+
+// ----------------------------------------------------------------------
+void MessageWalker::StartField()
+{
+	items = NULL;
+	itemsize = 0;
+	looked = false;
+}
+
+// ----------------------------------------------------------------------
+bool MessageWalker::NextField()
+{
+	StartField();
+
+	if( ++which >= names ||
+		msg.GetInfo( B_ANY_TYPE, which, &name, &type, &count ) != B_OK ) {
+		which = names;
+		name = NULL;
+		count = 0;
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+bool MessageWalker::FindField( const char *field )
+{
+	StartField();
+
+	// We can't tell where it is in the field list, so NextField() will
+	// start from the top again.
+	which = -1;
+
+	if( msg.GetInfo( field, &type, &count ) != B_OK || count == 0 ) {
+		name = NULL;
+		count = 0;
+		return false;
+	}
+
+	// ODS 22-Jul-1999: "name" should be treated as const char.
+	name = (char *)field;
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// See whether the current field's items are one block: if they're a fixed
+// size and the last one is exactly where it would be, they all are.
+void MessageWalker::LookAtItems()
+{
+	looked = true;
+
+	const void *first;
+	if( name == NULL || !fixed_size_type( type ) ||
+		msg.FindData( name, type, 0, &first, &itemsize ) != B_OK ) {
+		return;
+	}
+
+	const void *last = first;
+	ssize_t lastsize = itemsize;
+	if( count > 1 &&
+		msg.FindData( name, type, count - 1, &last, &lastsize ) != B_OK ) {
+		return;
+	}
+
+	if( lastsize == itemsize &&
+		(const char *)last == (const char *)first + ( count - 1 ) * itemsize ) {
+		items = (const char *)first;
+	}
+}
+
+// ----------------------------------------------------------------------
+const void *MessageWalker::Items()
+{
+	if( !looked ) LookAtItems();
+
+	return items;
+}
+
+// ----------------------------------------------------------------------
+status_t MessageWalker::ItemAt( int32 index, const void **ptr, ssize_t *size )
+{
+	if( name == NULL || index < 0 || index >= count ) {
+		return B_BAD_INDEX;
+	}
+
+	if( !looked ) LookAtItems();
+
+	if( items ) {
+		*ptr = items + index * itemsize;
+		*size = itemsize;
+		return B_OK;
+	}
+
+	return msg.FindData( name, type, index, ptr, size );
+}
@@ -0,0 +1,73 @@
+// MessageWalker
+//
+// Walks through every field of a BMessage once, in order, handing out
+// each field's name, type and item count along with the items' data.
+// This doesn't need Python, so the benchmarks can use it too.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_MessageWalker_H
+#define PyHey_MessageWalker_H
+
+#include <app/Message.h>
+#include <sys/types.h>
+
+// Looking a field up by name means searching the message's fields, so
+// doing it for every item of every field makes decoding a big reply
+// quadratic.  The walker gets each field's name, type and count with one
+// GetInfo(), and when the items are a fixed size and sit end to end it
+// finds them all with a single FindData() instead of one per item.
+class MessageWalker {
+public:
+	MessageWalker( const BMessage &msg );
+
+	// Move on to the next field; returns false when there aren't any
+	// more.
+	bool NextField();
+
+	// Jump straight to the field called name; returns false (and leaves
+	// you with no current field) if there isn't one.
+	bool FindField( const char *name );
+
+	// The current field.
+	const char *Name() const { return name; }
+	type_code Type() const { return type; }
+	int32 Count() const { return count; }
+
+	// Get item index of the current field.  Returns B_OK, or B_BAD_INDEX
+	// if there isn't one.
+	status_t ItemAt( int32 index, const void **ptr, ssize_t *size );
+
+	// All of the current field's items, if they're a fixed size and sit
+	// end to end in the message (each is ItemSize() bytes); NULL if not.
+	const void *Items();
+	ssize_t ItemSize() const { return itemsize; }
+
+private:
+	void StartField();
+	void LookAtItems();
+
+	const BMessage &msg;
+	int32 which;		// index of the current field, for NextField()
+	int32 names;		// number of fields in the message
+
+	char *name;
+	type_code type;
+	int32 count;
+
+	// For fixed-size items that sit end to end: the first item, and the
+	// size of each.  items is NULL if we haven't looked yet, or if we
+	// have to use FindData() for every item.
+	const char *items;
+	ssize_t itemsize;
+	bool looked;
+};
+
+#endif
@@ -0,0 +1,320 @@
+// Packed
+//
+// The PackedArray object is used by heymodule to hand back a big field of
+// numbers (int32, float, double and friends) as one block of memory,
+// instead of making a Python int or float for every item up front.
+//
+// A PackedArray acts like a read-only list (len(), indexing, slicing and
+// for loops all work, and items are made as you look at them) and like a
+// read-only buffer, so array.array's fromstring(), struct and friends can
+// have all of the data at once.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Packed.h"
+#include "Hey.h"
+#include "MessageWalker.h"
+
+#include <support/TypeConstants.h>
+#include <new>
+#include <string.h>
+
+// Fields with at least this many numbers in them come back packed unless
+// you say otherwise; -1 (the default, so Get() keeps giving you lists)
+// means only when you ask.
+static long packed_threshold = -1;
+
+// ======================================================================
+// PackedArray object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// The array module's type code for a type we pack, or 0 if we don't.
+static char packed_typecode( type_code type )
+{
+	switch( type ) {
+	case B_INT8_TYPE:	return 'b';
+	case B_UINT8_TYPE:	return 'B';
+	case B_INT16_TYPE:	return 'h';
+	case B_UINT16_TYPE:	return 'H';
+	case B_INT32_TYPE:	// fall through
+	case B_SSIZE_T_TYPE:	return 'l';
+	case B_UINT32_TYPE:	// fall through
+	case B_SIZE_T_TYPE:	return 'L';
+	case B_FLOAT_TYPE:	return 'f';
+	case B_DOUBLE_TYPE:	return 'd';
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------
+bool want_packed( type_code type, int32 count, int mode )
+{
+	if( mode == PACK_NEVER || packed_typecode( type ) == 0 ) {
+		return false;
+	}
+
+	if( mode == PACK_ALWAYS ) {
+		return true;
+	}
+
+	return packed_threshold >= 0 && count >= packed_threshold;
+}
+
+// ----------------------------------------------------------------------
+// Create a new PackedArray.  Fixed-size items usually sit end to end
+// inside a BMessage, so we can use (or copy) the whole field in one go;
+// if not, we copy the items one at a time.
+PyObject *newPackedArray( const BMessage &msg, const char *name,
+                          type_code type, int32 count, PyObject *owner )
+{
+	MessageWalker walker( msg );
+	const void *first;
+	ssize_t itemsize;
+	if( count < 1 || !walker.FindField( name ) || walker.Type() != type ||
+		walker.Count() != count ||
+		walker.ItemAt( 0, &first, &itemsize ) != B_OK ) {
+		PyErr_SetString( PyExc_RuntimeError, "error getting message data" );
+		return NULL;
+	}
+
+	const void *block = walker.Items();
+
+	PackedArrayObject *self;
+	self = PyObject_NEW( PackedArrayObject, &PackedArray_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	self->owner = NULL;
+	self->ptr = NULL;
+	self->data = NULL;
+	self->count = count;
+	self->itemsize = itemsize;
+	self->type = type;
+
+	if( owner && block ) {
+		Py_INCREF( owner );
+		self->owner = owner;
+		self->ptr = (const char *)block;
+
+		return (PyObject *)self;
+	}
+
+	try {
+		self->data = new char[count * itemsize];
+	} catch ( bad_alloc &ex ) {
+		Py_DECREF( self );
+		return PyErr_NoMemory();
+	}
+	self->ptr = self->data;
+
+	if( block ) {
+		memcpy( self->data, block, count * itemsize );
+	} else {
+		for( int32 idx = 0; idx < count; idx++ ) {
+			const void *ptr;
+			ssize_t size;
+			if( walker.ItemAt( idx, &ptr, &size ) != B_OK ||
+				size != itemsize ) {
+				Py_DECREF( self );
+				PyErr_SetString( PyExc_RuntimeError,
+				                 "error getting message data" );
+				return NULL;
+			}
+			memcpy( self->data + idx * itemsize, ptr, itemsize );
+		}
+	}
+
+	return (PyObject *)self;
+}
+
+// ----------------------------------------------------------------------
+// Delete a PackedArray object
+static void PackedArray_dealloc( PackedArrayObject *self )
+{
+	Py_XDECREF( self->owner );
+	delete [] self->data;
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Sequence protocol; items are converted the same way they would've
+// been in a list.
+static int PackedArray_length( PackedArrayObject *self )
+{
+	return self->count;
+}
+
+static PyObject *PackedArray_item( PackedArrayObject *self, int index )
+{
+	if( index < 0 || index >= self->count ) {
+		PyErr_SetString( PyExc_IndexError, "PackedArray index out of range" );
+		return NULL;
+	}
+
+	return obj_to_python( self->type, self->ptr + index * self->itemsize,
+	                      self->itemsize );
+}
+
+static PyObject *PackedArray_slice( PackedArrayObject *self, int low,
+                                    int high )
+{
+	if( low < 0 ) low = 0;
+	if( high > self->count ) high = self->count;
+	if( high < low ) high = low;
+
+	PyObject *list = PyList_New( high - low );
+	if( list == NULL ) return NULL;
+
+	for( int idx = low; idx < high; idx++ ) {
+		PyObject *item = PackedArray_item( self, idx );
+		if( item == NULL ) {
+			Py_DECREF( list );
+			return NULL;
+		}
+		(void)PyList_SetItem( list, idx - low, item );
+	}
+
+	return list;
+}
+
+// ----------------------------------------------------------------------
+// Buffer interface; there's only ever one segment, and you can't write
+// to it.
+static int PackedArray_getreadbuffer( PackedArrayObject *self, int segment,
+                                      void **ptr )
+{
+	if( segment != 0 ) {
+		PyErr_SetString( PyExc_SystemError,
+				"accessing non-existent PackedArray segment" );
+		return -1;
+	}
+
+	*ptr = (void *)self->ptr;
+	return (int)( self->count * self->itemsize );
+}
+
+static int PackedArray_getsegcount( PackedArrayObject *self, int *lenp )
+{
+	if( lenp ) *lenp = (int)( self->count * self->itemsize );
+	return 1;
+}
+
+// ----------------------------------------------------------------------
+// Get everything as a list.
+static PyObject *PackedArray_tolist( PackedArrayObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return PackedArray_slice( self, 0, self->count );
+}
+
+// ----------------------------------------------------------------------
+// Get everything as a string of machine values, for array.array's
+// fromstring() or the struct module.
+static PyObject *PackedArray_tostring( PackedArrayObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return PyString_FromStringAndSize( (char *)self->ptr,
+	                                   self->count * self->itemsize );
+}
+
+// ----------------------------------------------------------------------
+static PyMethodDef PackedArrayObject_methods[] = {
+	{ "tolist",	(PyCFunction)PackedArray_tolist,	1,	"Return the items as a list." },
+	{ "tostring",	(PyCFunction)PackedArray_tostring,	1,	"Return the items as a string of machine values." },
+	{ NULL,		NULL }		// sentinel
+};
+
+static PyObject *PackedArray_getattr( PackedArrayObject *self, char *name )
+{
+	if( strcmp( name, "typecode" ) == 0 ) {
+		char code = packed_typecode( self->type );
+		return PyString_FromStringAndSize( &code, 1 );
+	} else if( strcmp( name, "itemsize" ) == 0 ) {
+		return PyInt_FromLong( self->itemsize );
+	} else if( strcmp( name, "type" ) == 0 ) {
+		return PyInt_FromLong( self->type );
+	}
+
+	return Py_FindMethod( PackedArrayObject_methods, (PyObject *)self, name );
+}
+
+static PySequenceMethods PackedArray_as_sequence = {
+	(inquiry)PackedArray_length,		// sq_length
+	0,									// sq_concat
+	0,									// sq_repeat
+	(intargfunc)PackedArray_item,		// sq_item
+	(intintargfunc)PackedArray_slice,	// sq_slice
+	0,									// sq_ass_item
+	0,									// sq_ass_slice
+};
+
+static PyBufferProcs PackedArray_as_buffer = {
+	(getreadbufferproc)PackedArray_getreadbuffer,	// bf_getreadbuffer
+	0,												// bf_getwritebuffer
+	(getsegcountproc)PackedArray_getsegcount,		// bf_getsegcount
+};
+
+PyTypeObject PackedArray_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"PackedArray",			// tp_name
+	sizeof(PackedArrayObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)PackedArray_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)PackedArray_getattr, // tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	&PackedArray_as_sequence,	// tp_as_sequence
+	0,			// tp_as_mapping
+	0,			// tp_hash
+	0,			// tp_call
+	0,			// tp_str
+	0,			// tp_getattro
+	0,			// tp_setattro
+	&PackedArray_as_buffer,	// tp_as_buffer
+};
+
+// ----------------------------------------------------------------------
+// Module functions for the number of items at which numeric fields come
+// back packed.
+PyObject *Packed_SetThreshold( PyObject *self, PyObject *args )
+{
+	long threshold;
+	if( !PyArg_ParseTuple( args, "l", &threshold ) ) {
+		return NULL;
+	}
+
+	packed_threshold = ( threshold < 0 ) ? -1 : threshold;
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+PyObject *Packed_Threshold( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return PyInt_FromLong( packed_threshold );
+}
@@ -0,0 +1,63 @@
+// Packed
+//
+// The PackedArray object is used by heymodule to hand back a big field of
+// numbers (int32, float, double and friends) as one block of memory,
+// instead of making a Python int or float for every item up front.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Packed_H
+#define PyHey_Packed_H
+
+#include "Python.h"
+
+#include <app/Message.h>
+#include <sys/types.h>
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	PyObject *owner;	// whatever owns the data, or NULL if it's ours
+	const char *ptr;	// count items, itemsize bytes each, end to end
+	char *data;			// our copy, if we made one
+	int32 count;
+	ssize_t itemsize;
+	type_code type;
+} PackedArrayObject;
+
+// The object's type:
+extern PyTypeObject PackedArray_Type;
+
+// Macro for checking the type:
+#define PackedArrayObject_Check(v)	((v)->ob_type == &PackedArray_Type)
+
+// Packing modes: PACK_AUTO packs fields with at least PackedThreshold()
+// items in them (none, unless SetPackedThreshold() has been called).
+#define PACK_NEVER	0
+#define PACK_ALWAYS	1
+#define PACK_AUTO	-1
+
+// Methods you can use.
+//
+// Should a field with count items of type come back packed?
+bool want_packed( type_code type, int32 count, int mode );
+
+// Return a PackedArray holding the count items of msg's name field.  If
+// owner isn't NULL it keeps msg alive, and the array looks at the data in
+// place when it can; otherwise the items are copied.
+PyObject *newPackedArray( const BMessage &msg, const char *name,
+                          type_code type, int32 count, PyObject *owner );
+
+// Module functions for the number of items at which fields come back
+// packed.
+PyObject *Packed_SetThreshold( PyObject *self, PyObject *args );
+PyObject *Packed_Threshold( PyObject *self, PyObject *args );
+
+#endif
@@ -0,0 +1,649 @@
+// Proxy
+//
+// The Proxy object is used by heymodule to script a target with
+// attributes and indexes instead of specifier strings:
+//
+// app = hey.Hey( "StyledEdit" )
+// print app.Window[0].Title()
+// app.Window[0].Title = "Hello"
+//
+// Each step is a new Proxy pointing at the one before it.  Proxies with
+// the same shape of specifier stack ("Title of Window %d") share a
+// Template, kept in the Hey object; the first time a shape turns up, the
+// last property in it is looked up in the suites of the handler it
+// belongs to, and after that nobody asks again.  A Proxy binds its
+// Template once, the first time it's used, so keeping one around and
+// calling it over and over costs nothing but the round trip.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Proxy.h"
+#include "Specifier.h"
+#include "Template.h"
+#include "Suites.h"
+#include "Marshal.h"
+
+#include <app/Message.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+static ProxyObject *make_proxy( HeyObject *hey, ProxyObject *parent,
+                                PyObject *property, char form,
+                                PyObject *key, bool resolve );
+
+// ======================================================================
+// Shapes and templates
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// The shape of a Proxy's specifier stack, for finding its Template: a
+// tuple with one ( property, form ) per level, innermost first.  Ranges
+// aren't placeholders, so they're part of the shape.
+static PyObject *shape_key( ProxyObject *self )
+{
+	PyObject *levels = PyList_New( 0 );
+	for( ProxyObject *p = self; levels && p; p = p->parent ) {
+		char form[2] = { p->form ? p->form : '-', '\0' };
+
+		PyObject *level;
+		if( p->form == 'r' ) {
+			level = Py_BuildValue( "(OsO)", p->property, form, p->key );
+		} else {
+			level = Py_BuildValue( "(Os)", p->property, form );
+		}
+
+		if( level == NULL || PyList_Append( levels, level ) != 0 ) {
+			Py_XDECREF( level );
+			Py_DECREF( levels );
+			return NULL;
+		}
+		Py_DECREF( level );
+	}
+
+	if( levels == NULL ) {
+		return NULL;
+	}
+
+	PyObject *key = PyList_AsTuple( levels );
+	Py_DECREF( levels );
+
+	return key;
+}
+
+// ----------------------------------------------------------------------
+// The values for the Template's placeholders, in the same order.
+static PyObject *shape_values( ProxyObject *self )
+{
+	int count = 0;
+	for( ProxyObject *p = self; p; p = p->parent ) {
+		if( p->form == 'd' || p->form == 's' ) count++;
+	}
+
+	PyObject *values = PyTuple_New( count );
+	int idx = 0;
+	for( ProxyObject *p = self; values && p; p = p->parent ) {
+		if( p->form == 'd' || p->form == 's' ) {
+			Py_INCREF( p->key );
+			(void)PyTuple_SetItem( values, idx++, p->key );
+		}
+	}
+
+	return values;
+}
+
+// ----------------------------------------------------------------------
+// Build a Template for self's shape.
+static PyObject *build_template( ProxyObject *self )
+{
+	PyObject *args = PyTuple_New( 0 );
+	if( args == NULL ) {
+		return NULL;
+	}
+
+	PyObject *tmpl = (PyObject *)newTemplateObject( args );
+	Py_DECREF( args );
+
+	for( ProxyObject *p = self; tmpl && p; p = p->parent ) {
+		PyObject *result;
+		int start, run;
+
+		switch( p->form ) {
+		case 'd':
+			result = PyObject_CallMethod( tmpl, "Add", "(Os)", p->property,
+			                              "%d" );
+			break;
+
+		case 's':
+			result = PyObject_CallMethod( tmpl, "Add", "(Os)", p->property,
+			                              "%s" );
+			break;
+
+		case '*':
+			result = PyObject_CallMethod( tmpl, "Add", "(Os)", p->property,
+			                              "*" );
+			break;
+
+		case 'r':
+			result = NULL;
+			if( PyArg_ParseTuple( p->key, "ii", &start, &run ) ) {
+				result = PyObject_CallMethod( tmpl, "Add", "(Oii)",
+				                              p->property, start, run );
+			}
+			break;
+
+		default:
+			result = PyObject_CallMethod( tmpl, "Add", "(O)", p->property );
+			break;
+		}
+
+		if( result == NULL ) {
+			Py_DECREF( tmpl );
+			return NULL;
+		}
+		Py_DECREF( result );
+	}
+
+	return tmpl;
+}
+
+// ----------------------------------------------------------------------
+// Look self's property up in the suites of the handler it belongs to.
+// Ranges and "*"s stand in for their first item, since that's something
+// we can ask about.  If the handler has no suites to look at, let the
+// target decide, like loose validation does; if we couldn't ask it
+// (a timeout, say), that's raised.
+static bool resolve_property( ProxyObject *self )
+{
+	BMessage path;
+	for( ProxyObject *p = self->parent; p; p = p->parent ) {
+		const char *property = PyString_AsString( p->property );
+
+		switch( p->form ) {
+		case 'd':
+			{
+				long index = PyInt_AsLong( p->key );
+				if( index < 0 ) {
+					BMessage reverse( B_REVERSE_INDEX_SPECIFIER );
+					reverse.AddString( "property", property );
+					reverse.AddInt32( "index", (int32)-index );
+					path.AddSpecifier( &reverse );
+				} else {
+					path.AddSpecifier( property, (int32)index );
+				}
+			}
+			break;
+
+		case 's':
+			path.AddSpecifier( property, PyString_AsString( p->key ) );
+			break;
+
+		case 'r':
+			path.AddSpecifier( property,
+			                   (int32)PyInt_AsLong( PyTuple_GetItem( p->key, 0 ) ) );
+			break;
+
+		case '*':
+			path.AddSpecifier( property, (int32)0 );
+			break;
+
+		default:
+			path.AddSpecifier( property );
+			break;
+		}
+	}
+
+	const char *property = PyString_AsString( self->property );
+	bool refused;
+	PyObject *suite = find_property( self->hey, self->parent ? &path : NULL,
+	                                 property, self->hey->send_timeout,
+	                                 self->hey->reply_timeout, &refused );
+	if( suite == NULL ) {
+		// A handler without suites could have any property, so let the
+		// target decide; but a target that doesn't answer is an error.
+		if( !refused ) return false;
+
+		PyErr_Clear();
+		return true;
+	}
+
+	bool known = ( suite != Py_None );
+	Py_DECREF( suite );
+
+	if( !known ) {
+		char buff[256];
+		if( self->parent ) {
+			sprintf( buff, "%.64s has no %.64s property",
+			         PyString_AsString( self->parent->property ), property );
+		} else {
+			sprintf( buff, "the application has no %.64s property",
+			         property );
+		}
+		PyErr_SetString( PyExc_AttributeError, buff );
+	}
+
+	return known;
+}
+
+// ----------------------------------------------------------------------
+// Find the Template for self's shape in the Hey object, building it (and
+// checking the property against the suites first, if resolve says to) if
+// this is the first time we've seen it.
+static bool find_template( ProxyObject *self, bool resolve )
+{
+	HeyObject *hey = self->hey;
+	if( hey->proxies == NULL ) {
+		hey->proxies = PyDict_New();
+		if( hey->proxies == NULL ) {
+			return false;
+		}
+	}
+
+	PyObject *key = shape_key( self );
+	if( key == NULL ) {
+		return false;
+	}
+
+	PyObject *tmpl = PyDict_GetItem( hey->proxies, key );
+	if( tmpl ) {
+		Py_INCREF( tmpl );
+		self->tmpl = tmpl;
+		Py_DECREF( key );
+		return true;
+	}
+
+	if( resolve && !resolve_property( self ) ) {
+		Py_DECREF( key );
+		return false;
+	}
+
+	tmpl = build_template( self );
+	if( tmpl == NULL || PyDict_SetItem( hey->proxies, key, tmpl ) != 0 ) {
+		Py_XDECREF( tmpl );
+		Py_DECREF( key );
+		return false;
+	}
+	self->tmpl = tmpl;
+
+	Py_DECREF( key );
+	return true;
+}
+
+// ======================================================================
+// Proxy object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Create a Proxy for property (of parent, if it isn't NULL).
+static ProxyObject *make_proxy( HeyObject *hey, ProxyObject *parent,
+                                PyObject *property, char form,
+                                PyObject *key, bool resolve )
+{
+	ProxyObject *self;
+	self = PyObject_NEW( ProxyObject, &Proxy_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	Py_INCREF( hey );
+	self->hey = hey;
+	Py_XINCREF( parent );
+	self->parent = parent;
+	Py_INCREF( property );
+	self->property = property;
+	self->form = form;
+	Py_XINCREF( key );
+	self->key = key;
+	self->tmpl = NULL;
+	self->spec = NULL;
+
+	if( !find_template( self, resolve ) ) {
+		Py_DECREF( self );
+		return NULL;
+	}
+
+	return self;
+}
+
+PyObject *newProxyObject( HeyObject *hey, const char *property )
+{
+	PyObject *name = PyString_InternFromString( (char *)property );
+	if( name == NULL ) {
+		return NULL;
+	}
+
+	ProxyObject *self = make_proxy( hey, NULL, name, 0, NULL, true );
+	Py_DECREF( name );
+
+	return (PyObject *)self;
+}
+
+// ----------------------------------------------------------------------
+// A property of the handler self points at.
+static ProxyObject *proxy_attribute( ProxyObject *self, const char *name )
+{
+	PyObject *property = PyString_InternFromString( (char *)name );
+	if( property == NULL ) {
+		return NULL;
+	}
+
+	ProxyObject *child = make_proxy( self->hey, self, property, 0, NULL,
+	                                 true );
+	Py_DECREF( property );
+
+	return child;
+}
+
+// ----------------------------------------------------------------------
+// Delete a Proxy object
+static void Proxy_dealloc( ProxyObject *self )
+{
+	Py_XDECREF( self->hey );
+	Py_XDECREF( self->parent );
+	Py_XDECREF( self->property );
+	Py_XDECREF( self->key );
+	Py_XDECREF( self->tmpl );
+	Py_XDECREF( self->spec );
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// The Specifier for self, bound the first time somebody wants it; it's a
+// borrowed reference.
+static SpecifierObject *proxy_specifier( ProxyObject *self )
+{
+	if( self->spec == NULL ) {
+		PyObject *values = shape_values( self );
+		if( values == NULL ) {
+			return NULL;
+		}
+
+		self->spec = PyObject_CallObject( self->tmpl, values );
+		Py_DECREF( values );
+	}
+
+	return (SpecifierObject *)self->spec;
+}
+
+// ----------------------------------------------------------------------
+// Send a request for self, with value as its "data" if it isn't NULL.
+static PyObject *proxy_send( ProxyObject *self, uint32 what,
+                             const char *name, PyObject *value,
+                             PyObject *kwds )
+{
+	SpecifierObject *spec = proxy_specifier( self );
+	if( spec == NULL ) {
+		return NULL;
+	}
+
+	BMessage *msg = new_request( spec, what );
+	if( msg == NULL ) {
+		return NULL;
+	}
+
+	if( value && !marshal_value( "data", value, msg ) ) {
+		delete msg;
+		return NULL;
+	}
+
+	PyObject *obj = send_request( self->hey, msg, name, kwds );
+	delete msg;
+
+	return obj;
+}
+
+// ----------------------------------------------------------------------
+// The usual commands; they take the same keyword arguments as the Hey
+// object's methods.
+static PyObject *Proxy_Get( ProxyObject *self, PyObject *args,
+                            PyObject *kwds )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return proxy_send( self, B_GET_PROPERTY, "Get", NULL, kwds );
+}
+
+// Set() works out the data type from the value, like Send() does.
+static PyObject *Proxy_Set( ProxyObject *self, PyObject *args,
+                            PyObject *kwds )
+{
+	PyObject *value;
+	if( !PyArg_ParseTuple( args, "O", &value ) ) {
+		return NULL;
+	}
+
+	return proxy_send( self, B_SET_PROPERTY, "Set", value, kwds );
+}
+
+static PyObject *Proxy_Count( ProxyObject *self, PyObject *args,
+                              PyObject *kwds )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return proxy_send( self, B_COUNT_PROPERTIES, "Count", NULL, kwds );
+}
+
+static PyObject *Proxy_Create( ProxyObject *self, PyObject *args,
+                               PyObject *kwds )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return proxy_send( self, B_CREATE_PROPERTY, "Create", NULL, kwds );
+}
+
+static PyObject *Proxy_Delete( ProxyObject *self, PyObject *args,
+                               PyObject *kwds )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return proxy_send( self, B_DELETE_PROPERTY, "Delete", NULL, kwds );
+}
+
+// GetSuites() goes through the Hey object, so it gets the suite cache.
+static PyObject *Proxy_GetSuites( ProxyObject *self, PyObject *args,
+                                  PyObject *kwds )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	SpecifierObject *spec = proxy_specifier( self );
+	if( spec == NULL ) {
+		return NULL;
+	}
+
+	PyObject *method = PyObject_GetAttrString( (PyObject *)self->hey,
+	                                           "GetSuites" );
+	PyObject *method_args = Py_BuildValue( "(O)", spec );
+	PyObject *obj = NULL;
+	if( method && method_args ) {
+		obj = PyEval_CallObjectWithKeywords( method, method_args, kwds );
+	}
+	Py_XDECREF( method );
+	Py_XDECREF( method_args );
+
+	return obj;
+}
+
+static PyObject *Proxy_call( ProxyObject *self, PyObject *args,
+                             PyObject *kwds )
+{
+	return Proxy_Get( self, args, kwds );
+}
+
+// ----------------------------------------------------------------------
+// app.Window[0], app.Window["Untitled"], app.Window[-1] (the last one),
+// app.Window[0:3] (a range) and app.Window[:] or app.Window["*"] (every
+// one; see FanOut.h).
+static PyObject *Proxy_subscript( ProxyObject *self, PyObject *key )
+{
+	if( self->form != 0 ) {
+		PyErr_SetString( PyExc_TypeError,
+		                 "this property already has a specifier" );
+		return NULL;
+	}
+
+	char form;
+	if( PyInt_Check( key ) ) {
+		form = 'd';
+	} else if( PyString_Check( key ) ) {
+		form = ( strcmp( PyString_AsString( key ), "*" ) == 0 ) ? '*' : 's';
+	} else {
+		PyErr_SetString( PyExc_TypeError,
+		                 "property index must be an integer or a name" );
+		return NULL;
+	}
+
+	return (PyObject *)make_proxy( self->hey, self->parent, self->property,
+	                               form, ( form == '*' ) ? NULL : key,
+	                               false );
+}
+
+static PyObject *Proxy_slice( ProxyObject *self, int low, int high )
+{
+	if( self->form != 0 ) {
+		PyErr_SetString( PyExc_TypeError,
+		                 "this property already has a specifier" );
+		return NULL;
+	}
+
+	if( low == 0 && high == INT_MAX ) {
+		return (PyObject *)make_proxy( self->hey, self->parent,
+		                               self->property, '*', NULL, false );
+	}
+
+	if( low < 0 || high == INT_MAX || high < low ) {
+		PyErr_SetString( PyExc_ValueError,
+		                 "ranges need a start and an end; use [:] for every item" );
+		return NULL;
+	}
+
+	PyObject *key = Py_BuildValue( "(ii)", low, high - low );
+	if( key == NULL ) {
+		return NULL;
+	}
+
+	ProxyObject *range = make_proxy( self->hey, self->parent, self->property,
+	                                 'r', key, false );
+	Py_DECREF( key );
+
+	return (PyObject *)range;
+}
+
+// ----------------------------------------------------------------------
+// Method table and whatnot for the Proxy object.
+static PyMethodDef ProxyObject_methods[] = {
+	{ "Get",	(PyCFunction)Proxy_Get,	METH_VARARGS | METH_KEYWORDS,	"Get the property from the target." },
+	{ "Set",	(PyCFunction)Proxy_Set,	METH_VARARGS | METH_KEYWORDS,	"Set the property on the target to a value." },
+	{ "Count",	(PyCFunction)Proxy_Count,	METH_VARARGS | METH_KEYWORDS,	"Count instances of the property." },
+	{ "Create",	(PyCFunction)Proxy_Create,	METH_VARARGS | METH_KEYWORDS,	"Create a new instance of the property." },
+	{ "Delete",	(PyCFunction)Proxy_Delete,	METH_VARARGS | METH_KEYWORDS,	"Delete this instance of the property." },
+	{ "GetSuites",	(PyCFunction)Proxy_GetSuites,	METH_VARARGS | METH_KEYWORDS,	"Get the supported suites of the handler for the property." },
+	{ NULL, NULL }	// sentinel
+};
+
+// Anything else starting with a capital letter is a property of the
+// handler this Proxy points at.
+static PyObject *Proxy_getattr( ProxyObject *self, char *name )
+{
+	if( strcmp( name, "specifier" ) == 0 ) {
+		PyObject *spec = (PyObject *)proxy_specifier( self );
+		Py_XINCREF( spec );
+		return spec;
+	} else if( strcmp( name, "property" ) == 0 ) {
+		Py_INCREF( self->property );
+		return self->property;
+	}
+
+	PyObject *method = Py_FindMethod( ProxyObject_methods, (PyObject *)self,
+	                                  name );
+	if( method == NULL && name[0] >= 'A' && name[0] <= 'Z' &&
+		PyErr_ExceptionMatches( PyExc_AttributeError ) ) {
+		PyErr_Clear();
+		return (PyObject *)proxy_attribute( self, name );
+	}
+
+	return method;
+}
+
+// app.Window[0].Title = "Hello" is app.Window[0].Title.Set( "Hello" ).
+static int Proxy_setattr( ProxyObject *self, char *name, PyObject *value )
+{
+	if( value == NULL ) {
+		PyErr_SetString( PyExc_AttributeError,
+		                 "use Delete() to delete a property" );
+		return -1;
+	}
+
+	if( name[0] < 'A' || name[0] > 'Z' ) {
+		PyErr_SetString( PyExc_AttributeError,
+		                 "only properties can be set on a Proxy" );
+		return -1;
+	}
+
+	ProxyObject *child = proxy_attribute( self, name );
+	if( child == NULL ) {
+		return -1;
+	}
+
+	PyObject *result = proxy_send( child, B_SET_PROPERTY, "Set", value,
+	                               NULL );
+	Py_DECREF( child );
+	if( result == NULL ) {
+		return -1;
+	}
+
+	Py_DECREF( result );
+	return 0;
+}
+
+static PyMappingMethods Proxy_as_mapping = {
+	0,									// mp_length
+	(binaryfunc)Proxy_subscript,		// mp_subscript
+	0,									// mp_ass_subscript
+};
+
+static PySequenceMethods Proxy_as_sequence = {
+	0,									// sq_length
+	0,									// sq_concat
+	0,									// sq_repeat
+	0,									// sq_item
+	(intintargfunc)Proxy_slice,			// sq_slice
+	0,									// sq_ass_item
+	0,									// sq_ass_slice
+};
+
+PyTypeObject Proxy_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"Proxy",			// tp_name
+	sizeof(ProxyObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)Proxy_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)Proxy_getattr, // tp_getattr
+	(setattrfunc)Proxy_setattr, // tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	&Proxy_as_sequence,	// tp_as_sequence
+	&Proxy_as_mapping,	// tp_as_mapping
+	0,			// tp_hash
+	(ternaryfunc)Proxy_call,	// tp_call
+};
@@ -0,0 +1,51 @@
+// Proxy
+//
+// The Proxy object is used by heymodule to script a target with
+// attributes and indexes instead of specifier strings:
+// app.Window[0].Title is the same as "Title of Window 0".
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Proxy_H
+#define PyHey_Proxy_H
+
+#include "Python.h"
+
+#include "Hey.h"
+
+// The object:
+typedef struct ProxyObject {
+	PyObject_HEAD
+	HeyObject *hey;				// the target
+	struct ProxyObject *parent;	// what this is a property of; NULL for the
+								// application itself
+	PyObject *property;			// the property's name
+	char form;					// 0 (direct), 'd' (index), 's' (name),
+								// 'r' (range) or '*' (every one)
+	PyObject *key;				// the index, name or ( start, run )
+	PyObject *tmpl;				// the Template for this shape of stack
+	PyObject *spec;				// the Specifier, once it's been used
+} ProxyObject;
+
+// The object's type:
+extern PyTypeObject Proxy_Type;
+
+// Macro for checking the type:
+#define ProxyObject_Check(v)	((v)->ob_type == &Proxy_Type)
+
+// Methods you can use.
+//
+// Create a Proxy for one of the application's properties.  The first
+// time anybody asks for a property at a given spot, it's looked up in the
+// suites of the handler it belongs to; AttributeError if they don't list
+// it.
+PyObject *newProxyObject( HeyObject *hey, const char *property );
+
+#endif
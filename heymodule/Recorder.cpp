@@ -0,0 +1,663 @@
+// Recorder
+//
+// The recorder is used by heymodule to write every scripting request it
+// sends, and the reply it got, to a log file; see Recorder.h for the
+// format.
+//
+// Requests are recorded where they're sent (send_and_wait(),
+// send_pipelined(), HeyConnection and Future objects), so everything the
+// Hey methods, Batch, Iterator, fan-out and Snapshot() send ends up in
+// the log.  The log is a plain stdio file behind a lock; recording
+// doesn't need the interpreter lock, since most requests are sent
+// without it.
+//
+// Replay() sends a log's requests to a target again, one at a time
+// (optionally with the same gaps between them), and counts the replies
+// that came back different.  Replayer() starts a looper in this team that
+// answers requests from a log's replies, and hands back a Hey object for
+// it; Replay() without a target uses one of those, which measures
+// heymodule and the port round trip without the application.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Recorder.h"
+#include "Hey.h"
+#include "Stats.h"
+
+#include <app/Looper.h>
+#include <app/Messenger.h>
+#include <support/DataIO.h>
+#include <support/List.h>
+#include <support/Locker.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+volatile int32 hey_recording = 0;
+
+static BLocker log_lock( "hey recorder" );
+static FILE *log_file = NULL;
+static long log_records = 0;
+
+// What goes in front of each request in the log.
+struct log_header {
+	int32 magic;
+	int32 team;
+	int64 sent;
+	int64 latency;
+	int32 request_size;
+	int32 reply_size;
+};
+
+// One request, read back from a log.
+struct log_record {
+	log_header header;
+	BMessage request;
+	BMessage reply;
+	bool has_reply;
+};
+
+// ======================================================================
+// Recording
+// ======================================================================
+
+// ----------------------------------------------------------------------
+void record_exchange( team_id team, const BMessage &request,
+                      const BMessage *reply, bigtime_t sent,
+                      bigtime_t arrived )
+{
+	log_header header;
+	header.magic = HEY_LOG_RECORD;
+	header.team = team;
+	header.sent = sent;
+	header.latency = reply ? arrived - sent : -1;
+	header.request_size = request.FlattenedSize();
+	header.reply_size = reply ? reply->FlattenedSize() : 0;
+
+	// Flatten before taking the lock, so threads only wait for the write.
+	char *buff;
+	try {
+		buff = new char[header.request_size + header.reply_size];
+	} catch ( bad_alloc &ex ) {
+		return;
+	}
+
+	if( request.Flatten( buff, header.request_size ) != B_OK ||
+		( reply && reply->Flatten( buff + header.request_size,
+		                           header.reply_size ) != B_OK ) ) {
+		delete [] buff;
+		return;
+	}
+
+	if( log_lock.Lock() ) {
+		if( log_file ) {
+			(void)fwrite( &header, sizeof( header ), 1, log_file );
+			(void)fwrite( buff, 1, header.request_size + header.reply_size,
+			              log_file );
+			log_records++;
+		}
+		log_lock.Unlock();
+	}
+
+	delete [] buff;
+}
+
+// ======================================================================
+// Reading logs
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static status_t open_log( const char *filename, FILE **file )
+{
+	*file = fopen( filename, "rb" );
+	if( *file == NULL ) {
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	int32 magic[2];
+	if( fread( magic, sizeof( magic ), 1, *file ) != 1 ||
+		magic[0] != HEY_LOG || magic[1] != HEY_LOG_VERSION ) {
+		fclose( *file );
+		*file = NULL;
+		return B_BAD_TYPE;
+	}
+
+	return B_OK;
+}
+
+// ----------------------------------------------------------------------
+// Read the next request; B_ENTRY_NOT_FOUND at the end of the log.
+static status_t read_record( FILE *file, log_record &rec )
+{
+	if( fread( &rec.header, sizeof( rec.header ), 1, file ) != 1 ) {
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	if( rec.header.magic != HEY_LOG_RECORD || rec.header.request_size <= 0 ||
+		rec.header.reply_size < 0 ) {
+		return B_BAD_VALUE;
+	}
+
+	int32 size = rec.header.request_size + rec.header.reply_size;
+	char *buff;
+	try {
+		buff = new char[size];
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+
+	status_t retval = B_OK;
+	if( fread( buff, 1, size, file ) != (size_t)size ) {
+		retval = B_BAD_VALUE;
+	} else {
+		retval = rec.request.Unflatten( buff );
+		rec.has_reply = ( rec.header.reply_size > 0 );
+		if( retval == B_OK && rec.has_reply ) {
+			retval = rec.reply.Unflatten( buff + rec.header.request_size );
+		}
+	}
+
+	delete [] buff;
+	return retval;
+}
+
+// ----------------------------------------------------------------------
+// Everything about a message that matters when matching requests and
+// comparing replies: the what, and every field's name, type and items.
+// The flattened message won't do, since it carries the return address.
+static void message_key( const BMessage &msg, BMallocIO &key )
+{
+	(void)key.Write( &msg.what, sizeof( msg.what ) );
+
+	char *name;
+	type_code type;
+	int32 count;
+	for( int32 idx = 0;
+		 msg.GetInfo( B_ANY_TYPE, idx, &name, &type, &count ) == B_OK;
+		 idx++ ) {
+		(void)key.Write( name, strlen( name ) + 1 );
+		(void)key.Write( &type, sizeof( type ) );
+		(void)key.Write( &count, sizeof( count ) );
+
+		for( int32 item = 0; item < count; item++ ) {
+			const void *ptr;
+			ssize_t size;
+			if( msg.FindData( name, type, item, &ptr, &size ) == B_OK ) {
+				(void)key.Write( &size, sizeof( size ) );
+				(void)key.Write( ptr, size );
+			}
+		}
+	}
+}
+
+static uint32 key_hash( const BMallocIO &key )
+{
+	const uint8 *ptr = (const uint8 *)key.Buffer();
+	uint32 hash = 2166136261UL;
+	for( size_t idx = 0; idx < key.BufferLength(); idx++ ) {
+		hash = ( hash ^ ptr[idx] ) * 16777619UL;
+	}
+
+	return hash;
+}
+
+static bool same_message( const BMessage &a, const BMessage &b )
+{
+	BMallocIO key_a;
+	BMallocIO key_b;
+	message_key( a, key_a );
+	message_key( b, key_b );
+
+	return key_a.BufferLength() == key_b.BufferLength() &&
+		memcmp( key_a.Buffer(), key_b.Buffer(), key_a.BufferLength() ) == 0;
+}
+
+// ======================================================================
+// The stand-in
+// ======================================================================
+
+// Every recorded answer to one request.  If a request was made more than
+// once, the answers are given in the order they were recorded, and the
+// last one over and over after that.
+struct replay_answer {
+	BMessage *reply;
+	bigtime_t latency;
+};
+
+struct replay_entry {
+	uint32 hash;
+	BMallocIO key;
+	BList answers;			// replay_answer *s
+	int32 next;
+};
+
+class ReplayTarget : public BLooper {
+public:
+	ReplayTarget( bool delay );
+	virtual ~ReplayTarget();
+
+	status_t Load( const char *filename );
+
+	virtual BHandler *ResolveSpecifier( BMessage *msg, int32 index,
+	                                    BMessage *specifier, int32 form,
+	                                    const char *property );
+	virtual void MessageReceived( BMessage *msg );
+
+private:
+	replay_entry *Find( const BMallocIO &key, uint32 hash );
+
+	bool delay_replies;
+	BList entries;			// replay_entry *s
+};
+
+// ----------------------------------------------------------------------
+ReplayTarget::ReplayTarget( bool delay )
+	: BLooper( "hey replayer" ),
+	  delay_replies( delay )
+{
+}
+
+ReplayTarget::~ReplayTarget()
+{
+	for( int32 idx = 0; idx < entries.CountItems(); idx++ ) {
+		replay_entry *entry = (replay_entry *)entries.ItemAt( idx );
+		for( int32 a = 0; a < entry->answers.CountItems(); a++ ) {
+			replay_answer *answer = (replay_answer *)entry->answers.ItemAt( a );
+			delete answer->reply;
+			delete answer;
+		}
+		delete entry;
+	}
+}
+
+// ----------------------------------------------------------------------
+replay_entry *ReplayTarget::Find( const BMallocIO &key, uint32 hash )
+{
+	for( int32 idx = 0; idx < entries.CountItems(); idx++ ) {
+		replay_entry *entry = (replay_entry *)entries.ItemAt( idx );
+		if( entry->hash == hash &&
+			entry->key.BufferLength() == key.BufferLength() &&
+			memcmp( entry->key.Buffer(), key.Buffer(),
+			        key.BufferLength() ) == 0 ) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+// ----------------------------------------------------------------------
+status_t ReplayTarget::Load( const char *filename )
+{
+	FILE *file;
+	status_t retval = open_log( filename, &file );
+	if( retval != B_OK ) {
+		return retval;
+	}
+
+	try {
+		log_record rec;
+		while( ( retval = read_record( file, rec ) ) == B_OK ) {
+			if( !rec.has_reply ) continue;
+
+			BMallocIO key;
+			message_key( rec.request, key );
+			uint32 hash = key_hash( key );
+
+			replay_entry *entry = Find( key, hash );
+			if( entry == NULL ) {
+				entry = new replay_entry;
+				entry->hash = hash;
+				(void)entry->key.Write( key.Buffer(), key.BufferLength() );
+				entry->next = 0;
+				entries.AddItem( entry );
+			}
+
+			replay_answer *answer = new replay_answer;
+			answer->reply = new BMessage( rec.reply );
+			answer->latency = rec.header.latency;
+			entry->answers.AddItem( answer );
+
+			rec.request.MakeEmpty();
+			rec.reply.MakeEmpty();
+		}
+	} catch ( bad_alloc &ex ) {
+		retval = B_NO_MEMORY;
+	}
+
+	fclose( file );
+	return ( retval == B_ENTRY_NOT_FOUND ) ? B_OK : retval;
+}
+
+// ----------------------------------------------------------------------
+// Every request comes to us, whatever its specifiers say.
+BHandler *ReplayTarget::ResolveSpecifier( BMessage *msg, int32 index,
+                                          BMessage *specifier, int32 form,
+                                          const char *property )
+{
+	return this;
+}
+
+void ReplayTarget::MessageReceived( BMessage *msg )
+{
+	BMallocIO key;
+	message_key( *msg, key );
+
+	replay_entry *entry = Find( key, key_hash( key ) );
+	if( entry == NULL ) {
+		BMessage reply( B_MESSAGE_NOT_UNDERSTOOD );
+		reply.AddInt32( "error", B_BAD_SCRIPT_SYNTAX );
+		reply.AddString( "message", "not in the recording" );
+		msg->SendReply( &reply );
+		return;
+	}
+
+	replay_answer *answer = (replay_answer *)entry->answers.ItemAt( entry->next );
+	if( entry->next < entry->answers.CountItems() - 1 ) {
+		entry->next++;
+	}
+
+	if( delay_replies && answer->latency > 0 ) {
+		snooze( answer->latency );
+	}
+	msg->SendReply( answer->reply );
+}
+
+// ----------------------------------------------------------------------
+// Start a stand-in for the log in filename.
+static status_t start_replayer( const char *filename, bool delay,
+                                BMessenger *messenger )
+{
+	ReplayTarget *target;
+	try {
+		target = new ReplayTarget( delay );
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+
+	// Loopers are born locked; Quit() deletes it, Run() unlocks it.
+	status_t retval = target->Load( filename );
+	if( retval != B_OK ) {
+		target->Quit();
+		return retval;
+	}
+
+	(void)target->Run();
+	*messenger = BMessenger( target );
+
+	return B_OK;
+}
+
+static void stop_replayer( const BMessenger &messenger )
+{
+	BLooper *looper;
+	BHandler *handler = messenger.Target( &looper );
+	if( handler && looper && looper->Lock() ) {
+		looper->Quit();
+	}
+}
+
+// ======================================================================
+// Replaying
+// ======================================================================
+
+struct replay_stats {
+	long requests;
+	long errors;			// not sent, or not answered
+	long changed;			// answered differently
+	bigtime_t elapsed;
+	bigtime_t latency;		// total round trips now
+	bigtime_t recorded;		// total round trips in the log
+};
+
+// ----------------------------------------------------------------------
+// Send everything in the log to target, one request at a time.  With
+// timing, requests go out with the same gaps between them as they did
+// when they were recorded.  No Python in here.
+static status_t replay_log( const char *filename, const BMessenger &target,
+                            bigtime_t send_timeout, bigtime_t reply_timeout,
+                            bool timing, replay_stats &stats )
+{
+	FILE *file;
+	status_t retval = open_log( filename, &file );
+	if( retval != B_OK ) {
+		return retval;
+	}
+
+	bigtime_t start = system_time();
+	bigtime_t first = -1;
+
+	try {
+		log_record rec;
+		while( ( retval = read_record( file, rec ) ) == B_OK ) {
+			if( timing ) {
+				if( first < 0 ) first = rec.header.sent;
+				bigtime_t due = start + ( rec.header.sent - first );
+				if( due > system_time() ) {
+					(void)snooze_until( due, B_SYSTEM_TIMEBASE );
+				}
+			}
+
+			BMessage reply;
+			bigtime_t sent = system_time();
+			status_t err = target.SendMessage( &rec.request, &reply,
+			                                   send_timeout, reply_timeout );
+			bigtime_t arrived = system_time();
+			stats_exchange( target.Team(),
+			                stats_command_for( rec.request.what ),
+			                rec.request.FlattenedSize(),
+			                err == B_OK ? &reply : NULL, err,
+			                arrived - sent );
+
+			stats.requests++;
+			if( err != B_OK ) {
+				stats.errors++;
+			} else {
+				stats.latency += arrived - sent;
+				if( rec.has_reply ) {
+					stats.recorded += rec.header.latency;
+					if( !same_message( rec.reply, reply ) ) {
+						stats.changed++;
+					}
+				}
+			}
+
+			rec.request.MakeEmpty();
+			rec.reply.MakeEmpty();
+		}
+	} catch ( bad_alloc &ex ) {
+		retval = B_NO_MEMORY;
+	}
+
+	fclose( file );
+	stats.elapsed = system_time() - start;
+
+	return ( retval == B_ENTRY_NOT_FOUND ) ? B_OK : retval;
+}
+
+// ======================================================================
+// Module functions
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static PyObject *log_error( const char *filename, status_t retval )
+{
+	if( retval == B_NO_MEMORY ) {
+		return PyErr_NoMemory();
+	}
+
+	char buff[256];
+	sprintf( buff, "can't use log %.128s: %.64s", filename,
+	         strerror( retval ) );
+	PyErr_SetString( PyExc_IOError, buff );
+	return NULL;
+}
+
+// ----------------------------------------------------------------------
+// StartRecording( filename ): record every request from now on.
+PyObject *Recorder_Start( PyObject *self, PyObject *args )
+{
+	char *filename;
+	if( !PyArg_ParseTuple( args, "s", &filename ) ) {
+		return NULL;
+	}
+
+	if( !log_lock.Lock() ) {
+		PyErr_SetString( PyExc_RuntimeError, "unable to lock the recorder" );
+		return NULL;
+	}
+
+	if( log_file ) {
+		log_lock.Unlock();
+		PyErr_SetString( PyExc_RuntimeError, "already recording" );
+		return NULL;
+	}
+
+	log_file = fopen( filename, "wb" );
+	int32 magic[2] = { HEY_LOG, HEY_LOG_VERSION };
+	if( log_file == NULL ||
+		fwrite( magic, sizeof( magic ), 1, log_file ) != 1 ) {
+		if( log_file ) fclose( log_file );
+		log_file = NULL;
+		log_lock.Unlock();
+		return log_error( filename, B_ERROR );
+	}
+
+	log_records = 0;
+	hey_recording = 1;
+	log_lock.Unlock();
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+// ----------------------------------------------------------------------
+// StopRecording(): close the log; returns the number of requests in it.
+PyObject *Recorder_Stop( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	long records = 0;
+	if( log_lock.Lock() ) {
+		hey_recording = 0;
+		if( log_file ) {
+			fclose( log_file );
+			log_file = NULL;
+			records = log_records;
+		}
+		log_lock.Unlock();
+	}
+
+	return PyInt_FromLong( records );
+}
+
+// ----------------------------------------------------------------------
+// Replay( filename, target = None, timing = 0 )
+//
+// target is a Hey object, or anything you could make one from; without
+// one, the log is replayed against a stand-in answering from its own
+// replies.  Returns a dictionary of counters and times (in seconds).
+PyObject *Recorder_Replay( PyObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { "filename", "target", "timing", NULL };
+	char *filename;
+	PyObject *target = Py_None;
+	int timing = 0;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "s|Oi", kwlist, &filename,
+	                                  &target, &timing ) ) {
+		return NULL;
+	}
+
+	BMessenger messenger;
+	bigtime_t send_timeout = B_INFINITE_TIMEOUT;
+	bigtime_t reply_timeout = B_INFINITE_TIMEOUT;
+	bool stand_in = ( target == Py_None );
+	if( stand_in ) {
+		status_t retval = start_replayer( filename, false, &messenger );
+		if( retval != B_OK ) {
+			return log_error( filename, retval );
+		}
+	} else {
+		HeyObject *hey;
+		if( HeyObject_Check( target ) ) {
+			Py_INCREF( target );
+			hey = (HeyObject *)target;
+		} else {
+			PyObject *hey_args = Py_BuildValue( "(O)", target );
+			hey = hey_args ? newHeyObject( hey_args ) : NULL;
+			Py_XDECREF( hey_args );
+			if( hey == NULL ) {
+				return NULL;
+			}
+		}
+
+		bool remote = ( hey->connection != NULL );
+		messenger = *hey->target;
+		send_timeout = hey->send_timeout;
+		reply_timeout = hey->reply_timeout;
+		Py_DECREF( hey );
+
+		if( remote ) {
+			PyErr_SetString( PyExc_ValueError,
+			                 "can't replay to a target on a socket" );
+			return NULL;
+		}
+	}
+
+	replay_stats stats;
+	memset( &stats, 0, sizeof( stats ) );
+
+	status_t retval;
+	Py_BEGIN_ALLOW_THREADS
+	retval = replay_log( filename, messenger, send_timeout, reply_timeout,
+	                     timing != 0, stats );
+	if( stand_in ) {
+		stop_replayer( messenger );
+	}
+	Py_END_ALLOW_THREADS
+
+	if( retval != B_OK ) {
+		return log_error( filename, retval );
+	}
+
+	return Py_BuildValue( "{s:l,s:l,s:l,s:d,s:d,s:d}",
+	                      "requests", stats.requests,
+	                      "errors", stats.errors,
+	                      "changed", stats.changed,
+	                      "time", (double)stats.elapsed / 1000000.0,
+	                      "latency", (double)stats.latency / 1000000.0,
+	                      "recorded", (double)stats.recorded / 1000000.0 );
+}
+
+// ----------------------------------------------------------------------
+// Replayer( filename, delay = 0 ): a Hey object for a stand-in that
+// answers from the log's replies (after the recorded round trip time, if
+// delay is set).  Requests that aren't in the log get
+// B_MESSAGE_NOT_UNDERSTOOD; Quit() it when you're done.
+PyObject *Recorder_Replayer( PyObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { "filename", "delay", NULL };
+	char *filename;
+	int delay = 0;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "s|i", kwlist, &filename,
+	                                  &delay ) ) {
+		return NULL;
+	}
+
+	BMessenger messenger;
+	status_t retval = start_replayer( filename, delay != 0, &messenger );
+	if( retval != B_OK ) {
+		return log_error( filename, retval );
+	}
+
+	return (PyObject *)newHeyObjectFromMessenger( messenger );
+}
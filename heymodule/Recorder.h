@@ -0,0 +1,62 @@
+// Recorder
+//
+// The recorder is used by heymodule to write every scripting request it
+// sends, and the reply it got, to a log file; the log can be sent to a
+// target again later, or answered by a stand-in that plays the recorded
+// replies back.
+//
+// The log starts with HEY_LOG and a version number (both int32s, in the
+// recording machine's byte order).  Each request is then:
+//
+// int32	HEY_LOG_RECORD
+// int32	the target's team
+// int64	system_time() when the request went out
+// int64	microseconds until the reply came back (-1 if it didn't)
+// int32	size of the flattened request
+// int32	size of the flattened reply (0 if there wasn't one)
+//			the flattened request, then the flattened reply
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Recorder_H
+#define PyHey_Recorder_H
+
+#include "Python.h"
+
+#include <app/Message.h>
+#include <kernel/OS.h>
+
+#define HEY_LOG				'hLog'
+#define HEY_LOG_VERSION		1
+#define HEY_LOG_RECORD		'hRec'
+
+// Non-zero while somebody's recording; check it before calling
+// record_exchange(), so not recording costs next to nothing.
+extern volatile int32 hey_recording;
+
+// Write one request and its reply (NULL if there wasn't one) to the log.
+// sent and arrived are system_time()s; arrived is ignored if there's no
+// reply.  Doesn't need the interpreter lock.
+void record_exchange( team_id team, const BMessage &request,
+                      const BMessage *reply, bigtime_t sent,
+                      bigtime_t arrived );
+
+// Module functions:
+//
+// StartRecording( filename )
+// StopRecording()
+// Replay( filename, target = None, timing = 0 )
+// Replayer( filename, delay = 0 )
+PyObject *Recorder_Start( PyObject *self, PyObject *args );
+PyObject *Recorder_Stop( PyObject *self, PyObject *args );
+PyObject *Recorder_Replay( PyObject *self, PyObject *args, PyObject *kwds );
+PyObject *Recorder_Replayer( PyObject *self, PyObject *args, PyObject *kwds );
+
+#endif
@@ -0,0 +1,411 @@
+// Reply
+//
+// The Reply object is used by heymodule to hand a scripting reply to
+// Python without converting all of it up front; fields are turned into
+// Python objects when you ask for them, and only once.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Reply.h"
+#include "Hey.h"
+#include "DataView.h"
+#include "MessageWalker.h"
+
+#include <support/TypeConstants.h>
+#include <new>
+
+static PyObject *convert_item( ReplyObject *self, const char *name,
+                               int32 index );
+static PyObject *convert_field( ReplyObject *self, const char *name );
+
+// Raw, MIME and string items at least this big come back as read-only
+// buffers into the reply instead of copies; -1 means never.
+static long view_threshold = 65536;
+
+// ======================================================================
+// Reply object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Create a new Reply object for the given message.
+ReplyObject *newReplyObject( BMessage *msg, int packed )
+{
+	ReplyObject *self;
+	self = PyObject_NEW( ReplyObject, &Reply_Type );
+	if( self == NULL ) {
+		delete msg;
+		return NULL;
+	}
+
+	self->msg = msg;
+	self->packed = packed;
+	self->fields = PyDict_New();
+	if( self->fields == NULL ) {
+		Py_DECREF( self );
+		return (ReplyObject *)PyErr_NoMemory();
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+PyObject *lazy_reply( BMessage *reply, int packed )
+{
+	if( reply->what == B_REPLY ) {
+		return (PyObject *)newReplyObject( reply, packed );
+	}
+
+	// Errors and oddities get the usual treatment.
+	PyObject *obj = explain_reply( *reply, packed );
+	delete reply;
+
+	return obj;
+}
+
+// ----------------------------------------------------------------------
+// Delete a Reply object
+static void Reply_dealloc( ReplyObject *self )
+{
+	delete self->msg;
+	Py_XDECREF( self->fields );
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Convert one item's data.  Nested messages become Reply objects too, so
+// their insides aren't converted until someone looks.
+static PyObject *convert_data( ReplyObject *self, type_code type,
+                               const void *ptr, ssize_t size )
+{
+	if( type == B_MESSAGE_TYPE ) {
+		BMessage *msg;
+		try {
+			msg = new BMessage;
+		} catch ( bad_alloc &ex ) {
+			return PyErr_NoMemory();
+		}
+
+		if( msg->Unflatten( (const char *)ptr ) != B_OK ) {
+			delete msg;
+			PyErr_SetString( PyExc_RuntimeError, "error getting message data" );
+			return NULL;
+		}
+
+		return (PyObject *)newReplyObject( msg, self->packed );
+	}
+
+	switch( type ) {
+	case B_STRING_TYPE:	// fall through
+	case B_ASCII_TYPE:	// fall through
+	case B_MIME_TYPE:	// fall through
+	case B_RAW_TYPE:
+		if( view_threshold >= 0 && size >= view_threshold ) {
+			return newDataView( (PyObject *)self, ptr, size );
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return obj_to_python( type, ptr, size );
+}
+
+// ----------------------------------------------------------------------
+// Convert one item.
+static PyObject *convert_item( ReplyObject *self, const char *name,
+                               int32 index )
+{
+	type_code type;
+	const void *ptr;
+	ssize_t size;
+
+	if( self->msg->GetInfo( name, &type ) != B_OK ||
+		self->msg->FindData( name, type, index, &ptr, &size ) != B_OK ) {
+		PyErr_SetString( PyExc_IndexError, "no such item in reply" );
+		return NULL;
+	}
+
+	return convert_data( self, type, ptr, size );
+}
+
+// ----------------------------------------------------------------------
+// Convert a whole field into a list, or return the one we made last time.
+// Big fields of numbers become PackedArrays looking straight at the reply.
+static PyObject *convert_field( ReplyObject *self, const char *name )
+{
+	PyObject *list = PyDict_GetItemString( self->fields, (char *)name );
+	if( list ) {
+		Py_INCREF( list );
+		return list;
+	}
+
+	MessageWalker walker( *self->msg );
+	if( !walker.FindField( name ) ) {
+		PyErr_SetString( PyExc_KeyError, (char *)name );
+		return NULL;
+	}
+
+	int32 count = walker.Count();
+	type_code type = walker.Type();
+
+	// Anything that looks into the reply holds a reference to us, so it
+	// can't go in self->fields; that would be a cycle, and neither of us
+	// would ever go away.  They're cheap to make again.
+	bool keep = true;
+
+	if( want_packed( type, count, self->packed ) ) {
+		list = newPackedArray( *self->msg, name, type, count,
+		                       (PyObject *)self );
+		if( list == NULL ) return NULL;
+		keep = false;
+	} else {
+		list = PyList_New( count );
+		if( list == NULL ) return NULL;
+
+		for( int32 idx = 0; idx < count; idx++ ) {
+			const void *ptr;
+			ssize_t size;
+			if( walker.ItemAt( idx, &ptr, &size ) != B_OK ) {
+				Py_DECREF( list );
+				PyErr_SetString( PyExc_RuntimeError,
+				                 "error getting message data" );
+				return NULL;
+			}
+
+			PyObject *item = convert_data( self, type, ptr, size );
+			if( item == NULL ) {
+				Py_DECREF( list );
+				return NULL;
+			}
+			if( PyBuffer_Check( item ) ) keep = false;
+			(void)PyList_SetItem( list, idx, item );
+		}
+	}
+
+	if( keep &&
+		PyDict_SetItemString( self->fields, (char *)name, list ) != 0 ) {
+		Py_DECREF( list );
+		return NULL;
+	}
+
+	return list;
+}
+
+// ----------------------------------------------------------------------
+// Mapping protocol: len( reply ) and reply[ name ].
+static int Reply_length( ReplyObject *self )
+{
+	return self->msg->CountNames( B_ANY_TYPE );
+}
+
+static PyObject *Reply_subscript( ReplyObject *self, PyObject *key )
+{
+	if( !PyString_Check( key ) ) {
+		PyErr_SetString( PyExc_TypeError, "reply field names are strings" );
+		return NULL;
+	}
+
+	return convert_field( self, PyString_AsString( key ) );
+}
+
+// ----------------------------------------------------------------------
+// The field names, without converting any of the fields.
+static PyObject *Reply_keys( ReplyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	int32 count = self->msg->CountNames( B_ANY_TYPE );
+	PyObject *keys = PyList_New( count );
+	if( keys == NULL ) return NULL;
+
+	char *name;
+	type_code type;
+	for( int32 idx = 0; idx < count; idx++ ) {
+		self->msg->GetInfo( B_ANY_TYPE, idx, &name, &type );
+		PyObject *key = PyString_FromString( name );
+		if( key == NULL ) {
+			Py_DECREF( keys );
+			return NULL;
+		}
+		(void)PyList_SetItem( keys, idx, key );
+	}
+
+	return keys;
+}
+
+static PyObject *Reply_has_key( ReplyObject *self, PyObject *args )
+{
+	char *name;
+	if( !PyArg_ParseTuple( args, "s", &name ) ) {
+		return NULL;
+	}
+
+	return PyInt_FromLong( count_message_items( *self->msg, name ) > 0 );
+}
+
+// ----------------------------------------------------------------------
+// get( name [, default] ), like a dictionary's.
+static PyObject *Reply_get( ReplyObject *self, PyObject *args )
+{
+	char *name;
+	PyObject *def = Py_None;
+	if( !PyArg_ParseTuple( args, "s|O", &name, &def ) ) {
+		return NULL;
+	}
+
+	if( count_message_items( *self->msg, name ) == 0 ) {
+		Py_INCREF( def );
+		return def;
+	}
+
+	return convert_field( self, name );
+}
+
+// ----------------------------------------------------------------------
+// Count( name ) is the number of items under name; Item( name, index )
+// converts just one of them, so you can pick through a big list without
+// paying for all of it.
+static PyObject *Reply_Count( ReplyObject *self, PyObject *args )
+{
+	char *name;
+	if( !PyArg_ParseTuple( args, "s", &name ) ) {
+		return NULL;
+	}
+
+	return PyInt_FromLong( count_message_items( *self->msg, name ) );
+}
+
+static PyObject *Reply_Item( ReplyObject *self, PyObject *args )
+{
+	char *name;
+	int index = 0;
+	if( !PyArg_ParseTuple( args, "s|i", &name, &index ) ) {
+		return NULL;
+	}
+
+	PyObject *list = PyDict_GetItemString( self->fields, name );
+	if( list ) {
+		PyObject *item = PyList_GetItem( list, index );
+		Py_XINCREF( item );
+		return item;
+	}
+
+	return convert_item( self, name, index );
+}
+
+// ----------------------------------------------------------------------
+// Data( name, index ) gives you an item's bytes as a read-only buffer,
+// whatever its type, without copying them.
+static PyObject *Reply_Data( ReplyObject *self, PyObject *args )
+{
+	char *name;
+	int index = 0;
+	if( !PyArg_ParseTuple( args, "s|i", &name, &index ) ) {
+		return NULL;
+	}
+
+	type_code type;
+	const void *ptr;
+	ssize_t size;
+	if( self->msg->GetInfo( name, &type ) != B_OK ||
+		self->msg->FindData( name, type, index, &ptr, &size ) != B_OK ) {
+		PyErr_SetString( PyExc_IndexError, "no such item in reply" );
+		return NULL;
+	}
+
+	return newDataView( (PyObject *)self, ptr, size );
+}
+
+// ----------------------------------------------------------------------
+// What the Hey method would have returned if you hadn't asked for a
+// Reply object.
+static PyObject *Reply_Result( ReplyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return explain_reply( *self->msg );
+}
+
+// ----------------------------------------------------------------------
+// Method table and whatnot for the Reply object.
+static PyMethodDef ReplyObject_methods[] = {
+	{ "keys",	(PyCFunction)Reply_keys,	1,	"Return a list of the reply's field names." },
+	{ "has_key",	(PyCFunction)Reply_has_key,	1,	"Return true if the reply has a field with this name." },
+	{ "get",	(PyCFunction)Reply_get,	1,	"Return a field's items, or a default if it isn't there." },
+	{ "Count",	(PyCFunction)Reply_Count,	1,	"Return the number of items in a field." },
+	{ "Item",	(PyCFunction)Reply_Item,	1,	"Return one item from a field." },
+	{ "Data",	(PyCFunction)Reply_Data,	1,	"Return one item's raw data as a read-only buffer." },
+	{ "Result",	(PyCFunction)Reply_Result,	1,	"Return what the Hey method would have returned." },
+	{ NULL,		NULL }		// sentinel
+};
+
+static PyObject *Reply_getattr( ReplyObject *self, char *name )
+{
+	if( strcmp( name, "what" ) == 0 ) {
+		return PyInt_FromLong( self->msg->what );
+	}
+
+	return Py_FindMethod( ReplyObject_methods, (PyObject *)self, name );
+}
+
+static PyMappingMethods Reply_as_mapping = {
+	(inquiry)Reply_length,			// mp_length
+	(binaryfunc)Reply_subscript,	// mp_subscript
+	0,								// mp_ass_subscript
+};
+
+PyTypeObject Reply_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"Reply",			// tp_name
+	sizeof(ReplyObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)Reply_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)Reply_getattr, // tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	0,			// tp_as_sequence
+	&Reply_as_mapping,	// tp_as_mapping
+	0,			// tp_hash
+};
+
+// ----------------------------------------------------------------------
+// Module functions for the size at which Reply objects stop copying
+// strings and raw data.
+PyObject *Reply_SetDataViewThreshold( PyObject *self, PyObject *args )
+{
+	long threshold;
+	if( !PyArg_ParseTuple( args, "l", &threshold ) ) {
+		return NULL;
+	}
+
+	view_threshold = ( threshold < 0 ) ? -1 : threshold;
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+PyObject *Reply_DataViewThreshold( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return PyInt_FromLong( view_threshold );
+}
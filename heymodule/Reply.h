@@ -0,0 +1,54 @@
+// Reply
+//
+// The Reply object is used by heymodule to hand a scripting reply to
+// Python without converting all of it up front; fields are turned into
+// Python objects when you ask for them.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Reply_H
+#define PyHey_Reply_H
+
+#include "Python.h"
+
+#include "Packed.h"
+
+#include <app/Message.h>
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	BMessage *msg;		// the reply; it's ours
+	PyObject *fields;	// field name -> list of converted items, as needed
+	int packed;			// PACK_AUTO etc., for fields of numbers
+} ReplyObject;
+
+// The object's type:
+extern PyTypeObject Reply_Type;
+
+// Macro for checking the type:
+#define ReplyObject_Check(v)	((v)->ob_type == &Reply_Type)
+
+// Methods you can use.
+//
+// Wrap msg in a Reply; the Reply owns it from now on (even if this fails).
+// packed says which numeric fields come back as PackedArrays.
+ReplyObject *newReplyObject( BMessage *msg, int packed = PACK_AUTO );
+
+// Like explain_reply(), but a successful reply comes back as a Reply
+// object.  Either way, reply belongs to us now.
+PyObject *lazy_reply( BMessage *reply, int packed = PACK_AUTO );
+
+// Module functions for the size at which string and raw data items come
+// back as read-only buffers instead of copies.
+PyObject *Reply_SetDataViewThreshold( PyObject *self, PyObject *args );
+PyObject *Reply_DataViewThreshold( PyObject *self, PyObject *args );
+
+#endif
@@ -0,0 +1,232 @@
+// ReplyHandler
+//
+// The ReplyHandler is used by heymodule to collect scripting replies
+// without blocking inside BMessenger::SendMessage().
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "ReplyHandler.h"
+#include "Recorder.h"
+#include "Stats.h"
+#include "Wire.h"
+
+#include <support/Locker.h>
+#include <new>
+
+// ----------------------------------------------------------------------
+// Where the replies go.  There's only ever one of these, and it lives
+// until the team dies.  It's asked for without the interpreter lock, so
+// it's made under a lock of its own, and only handed out once it's
+// running.
+static BLocker reply_looper_lock( "hey reply looper" );
+static BLooper * volatile the_reply_looper = NULL;
+
+BLooper *reply_looper( void )
+{
+	if( the_reply_looper != NULL ) return the_reply_looper;
+
+	if( !reply_looper_lock.Lock() ) return NULL;
+	if( the_reply_looper == NULL ) {
+		BLooper *looper;
+		try {
+			looper = new BLooper( "hey replies" );
+		} catch ( bad_alloc &ex ) {
+			looper = NULL;
+		}
+
+		if( looper ) {
+			// The looper is born locked; Run() unlocks it for us.
+			(void)looper->Run();
+			the_reply_looper = looper;
+		}
+	}
+	reply_looper_lock.Unlock();
+
+	return the_reply_looper;
+}
+
+// ======================================================================
+// ReplyHandler
+// ======================================================================
+
+ReplyHandler::ReplyHandler( sem_id done, int notify )
+	: BHandler( "hey reply" ),
+	  done_sem( done ),
+	  notify_fd( notify ),
+	  reply( NULL ),
+	  arrived( 0 )
+{
+}
+
+ReplyHandler::~ReplyHandler()
+{
+	delete reply;
+}
+
+void ReplyHandler::MessageReceived( BMessage *msg )
+{
+	if( reply != NULL ) {
+		// Only the first reply counts; anything else is the target
+		// being chatty.
+		BHandler::MessageReceived( msg );
+		return;
+	}
+
+	arrived = system_time();
+
+	// Take the message away from the looper instead of copying it.
+	if( Looper()->CurrentMessage() == msg ) {
+		reply = Looper()->DetachCurrentMessage();
+	} else {
+		reply = new BMessage( *msg );
+	}
+
+	(void)release_sem( done_sem );
+	if( notify_fd >= 0 ) {
+		wire_notify( notify_fd );
+	}
+}
+
+bool ReplyHandler::HasReply( void ) const
+{
+	return reply != NULL;
+}
+
+BMessage *ReplyHandler::DetachReply( void )
+{
+	BMessage *rv = reply;
+	reply = NULL;
+
+	return rv;
+}
+
+bigtime_t ReplyHandler::Arrived( void ) const
+{
+	return arrived;
+}
+
+// ----------------------------------------------------------------------
+// Send a bunch of requests without waiting for each reply in turn; the
+// target (and the port between us) get to overlap the work, so N requests
+// cost about one round trip instead of N.
+status_t send_pipelined( const BMessenger &target, BMessage **requests,
+                         BMessage **replies, int32 count, bigtime_t timeout,
+                         bigtime_t send_timeout )
+{
+	int32 idx;
+
+	for( idx = 0; idx < count; idx++ ) {
+		replies[idx] = NULL;
+	}
+	if( count < 1 ) return B_OK;
+
+	BLooper *looper = reply_looper();
+	if( looper == NULL ) return B_NO_MEMORY;
+
+	sem_id done = create_sem( 0, "hey pipelined replies" );
+	if( done < B_OK ) return done;
+
+	ReplyHandler **handlers = NULL;
+	try {
+		handlers = new ReplyHandler *[count];
+		for( idx = 0; idx < count; idx++ ) {
+			handlers[idx] = NULL;
+		}
+		for( idx = 0; idx < count; idx++ ) {
+			handlers[idx] = new ReplyHandler( done );
+		}
+	} catch ( bad_alloc &ex ) {
+		if( handlers ) {
+			for( idx = 0; idx < count; idx++ ) {
+				delete handlers[idx];
+			}
+			delete [] handlers;
+		}
+		delete_sem( done );
+		return B_NO_MEMORY;
+	}
+
+	if( !looper->Lock() ) {
+		for( idx = 0; idx < count; idx++ ) {
+			delete handlers[idx];
+		}
+		delete [] handlers;
+		delete_sem( done );
+		return B_ERROR;
+	}
+	for( idx = 0; idx < count; idx++ ) {
+		looper->AddHandler( handlers[idx] );
+	}
+	looper->Unlock();
+
+	// times[idx] is when request idx went out and times[count + idx] is
+	// when its reply arrived, for the recorder and the statistics.
+	bigtime_t *times;
+	try {
+		times = new bigtime_t[count * 2];
+	} catch ( bad_alloc &ex ) {
+		times = NULL;
+	}
+
+	// Fire everything off; each request gets its own handler, so the
+	// replies can come back in any order.
+	int32 pending = 0;
+	for( idx = 0; idx < count; idx++ ) {
+		if( times ) times[idx] = system_time();
+		if( target.SendMessage( requests[idx], handlers[idx], send_timeout ) == B_OK ) {
+			pending++;
+		}
+	}
+
+	status_t retval = B_OK;
+	if( pending > 0 ) {
+		if( timeout == B_INFINITE_TIMEOUT ) {
+			retval = acquire_sem_etc( done, pending, 0, 0 );
+		} else {
+			retval = acquire_sem_etc( done, pending, B_RELATIVE_TIMEOUT, timeout );
+		}
+	}
+
+	// With the looper locked none of the handlers can be running, so it's
+	// safe to pull them out even if some replies are still on their way;
+	// stragglers get dropped by the looper.
+	looper->Lock();
+	for( idx = 0; idx < count; idx++ ) {
+		replies[idx] = handlers[idx]->DetachReply();
+		if( times ) times[count + idx] = handlers[idx]->Arrived();
+		looper->RemoveHandler( handlers[idx] );
+		delete handlers[idx];
+	}
+	looper->Unlock();
+
+	delete [] handlers;
+	delete_sem( done );
+
+	// Recording and counting can wait until the replies are out of the
+	// looper.  Requests that never got a reply waited until now.
+	if( times ) {
+		team_id team = target.Team();
+		bigtime_t now = system_time();
+		for( idx = 0; idx < count; idx++ ) {
+			if( hey_recording ) {
+				record_exchange( team, *requests[idx], replies[idx],
+				                 times[idx], times[count + idx] );
+			}
+			stats_exchange( team, stats_command_for( requests[idx]->what ),
+			                requests[idx]->FlattenedSize(), replies[idx],
+			                retval,
+			                ( replies[idx] ? times[count + idx] : now ) -
+			                    times[idx] );
+		}
+		delete [] times;
+	}
+
+	return retval;
+}
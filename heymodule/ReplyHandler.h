@@ -0,0 +1,67 @@
+// ReplyHandler
+//
+// The ReplyHandler is used by heymodule to collect scripting replies
+// without blocking inside BMessenger::SendMessage(); requests are sent
+// asynchronously and their replies land in handlers living in a private
+// looper.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_ReplyHandler_H
+#define PyHey_ReplyHandler_H
+
+#include <app/Handler.h>
+#include <app/Looper.h>
+#include <app/Message.h>
+#include <app/Messenger.h>
+#include <kernel/OS.h>
+
+// One of these per outstanding request; the reply is detached from the
+// looper (no copy) and done is released once it arrives.  If you give it
+// a notify socket (from wire_pair()), a byte is sent there too, so
+// select() can wait for the reply.
+class ReplyHandler : public BHandler {
+public:
+	ReplyHandler( sem_id done, int notify = -1 );
+	virtual ~ReplyHandler();
+
+	virtual void MessageReceived( BMessage *msg );
+
+	// Only call these with the reply looper locked.
+	bool HasReply( void ) const;
+
+	// Hand the reply over to the caller; NULL if it hasn't arrived yet.
+	BMessage *DetachReply( void );
+
+	// system_time() when the reply arrived.
+	bigtime_t Arrived( void ) const;
+
+private:
+	sem_id done_sem;
+	int notify_fd;
+	BMessage *reply;
+	bigtime_t arrived;
+};
+
+// The looper that receives replies for every ReplyHandler; it's started
+// the first time someone asks for it.
+BLooper *reply_looper( void );
+
+// Send count requests to target back-to-back, then wait for all of the
+// replies.  On return replies[i] is the reply to requests[i] (yours to
+// delete), or NULL if that request couldn't be sent or wasn't answered
+// before the timeout.  Returns B_TIMED_OUT if any replies are missing
+// because time ran out.  Each request is recorded and counted here.
+status_t send_pipelined( const BMessenger &target, BMessage **requests,
+                         BMessage **replies, int32 count,
+                         bigtime_t timeout = B_INFINITE_TIMEOUT,
+                         bigtime_t send_timeout = B_INFINITE_TIMEOUT );
+
+#endif
@@ -0,0 +1,779 @@
+// Snapshot
+//
+// Snapshots are used by heymodule to write down everything an
+// application's scripting interface will tell you in one file.
+//
+// The crawl goes a level of the handler tree at a time, and never touches
+// Python (so the interpreter lock is released for the whole thing):
+//
+// 1. GetSuites for every new shape of handler ("View of Window"); every
+//    handler with the same shape is assumed to have the same suites.
+// 2. Get every property that takes a direct Get, and Count every
+//    property that takes a Count.
+// 3. Get every item of countable properties that can only be had by
+//    index (like "Line"), and make a handler for every item of properties
+//    whose items are handlers (like "Window"); those are the next level.
+//
+// Each step's requests go out with hey_send_pipelined(), at most
+// concurrency at a time, so a Hey object from Connect() works too.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Snapshot.h"
+#include "Connection.h"
+#include "Hey.h"
+
+#include <app/PropertyInfo.h>
+#include <app/Roster.h>
+#include <kernel/OS.h>
+#include <storage/File.h>
+#include <support/List.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+// How many slots a property_info has for commands and specifiers.
+#define INFO_SLOTS(a)	( sizeof( a ) / sizeof( a[0] ) )
+
+// What we can do with a property.
+#define SNAP_GET		0x01	// Get, direct
+#define SNAP_GET_INDEX	0x02	// Get, by index
+#define SNAP_COUNT		0x04	// Count
+#define SNAP_HANDLER	0x08	// any command, by index; the items are handlers
+
+struct snap_property {
+	char *name;
+	uint32 flags;
+};
+
+// What we know about every handler of one shape.
+struct snap_suites {
+	char *shape;
+	bool handler;			// did GetSuites work?
+	BMessage names;			// "suites"
+	BList props;			// snap_property *s
+};
+
+// One handler.
+struct snap_node {
+	BMessage path;			// the specifier stack that gets here
+	char *text;				// the same thing, hey-style
+	char *shape;			// and without the indexes
+	int32 depth;
+	snap_suites *suites;
+	BMessage values;
+	BMessage counts;
+	BMessage errors;
+	BList items;			// snap_node *s
+};
+
+// One request, and where its reply goes.
+struct snap_request {
+	BMessage *msg;
+	snap_node *node;
+	snap_property *prop;	// NULL for GetSuites
+	char kind;				// 's'uites, 'g'et or 'c'ount
+	int32 count;			// what a Count said
+};
+
+struct snap_stats {
+	long handlers;
+	long requests;
+	long errors;
+};
+
+struct snap_crawl {
+	HeyObject *hey;			// referenced until the crawl is done
+	bigtime_t send_timeout;
+	bigtime_t reply_timeout;
+	int32 depth;
+	int32 items;
+	int32 concurrency;
+
+	BList nodes;			// every snap_node, for cleaning up
+	BList memo;				// snap_suites *s
+	snap_stats stats;
+};
+
+// ======================================================================
+// Odds and ends
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static char *copy_string( const char *str )
+{
+	char *copy = new char[strlen( str ) + 1];
+	strcpy( copy, str );
+	return copy;
+}
+
+// "Title" and "View 0", "Window 1" gives "Title of View 0 of Window 1".
+static char *join_path( const char *first, const char *rest )
+{
+	char *path = new char[strlen( first ) + strlen( rest ) + 5];
+	if( rest[0] ) {
+		sprintf( path, "%s of %s", first, rest );
+	} else {
+		strcpy( path, first );
+	}
+	return path;
+}
+
+// ----------------------------------------------------------------------
+// Copy every item of from's field to a field called name in to; false if
+// the types don't match what's already there.
+static bool copy_field( const BMessage &from, const char *field,
+                        BMessage &to, const char *name )
+{
+	type_code type;
+	int32 count;
+	bool fixed;
+	if( from.GetInfo( field, &type, &count ) != B_OK ||
+		from.GetInfo( field, &type, &fixed ) != B_OK ) {
+		return false;
+	}
+
+	for( int32 idx = 0; idx < count; idx++ ) {
+		const void *ptr;
+		ssize_t size;
+		if( from.FindData( field, type, idx, &ptr, &size ) != B_OK ||
+			to.AddData( name, type, ptr, size, fixed ) != B_OK ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Make a request for property (item index, if it isn't negative) of the
+// handler at node, or for the handler itself if property is NULL.
+static BMessage *make_request( uint32 what, const snap_node *node,
+                               const char *property, int32 index )
+{
+	BMessage *msg = new BMessage( what );
+	if( property ) {
+		if( index < 0 ) {
+			msg->AddSpecifier( property );
+		} else {
+			msg->AddSpecifier( property, index );
+		}
+	}
+
+	BMessage level;
+	for( int32 idx = 0;
+		 node->path.FindMessage( "specifiers", idx, &level ) == B_OK;
+		 idx++ ) {
+		msg->AddSpecifier( &level );
+	}
+
+	return msg;
+}
+
+static snap_request *add_request( BList &requests, uint32 what,
+                                  snap_node *node, snap_property *prop,
+                                  int32 index, char kind )
+{
+	snap_request *req = new snap_request;
+	req->msg = NULL;
+	req->node = node;
+	req->prop = prop;
+	req->kind = kind;
+	req->count = 0;
+	requests.AddItem( req );
+
+	req->msg = make_request( what, node, prop ? prop->name : NULL, index );
+	return req;
+}
+
+static void free_requests( BList &requests )
+{
+	for( int32 idx = 0; idx < requests.CountItems(); idx++ ) {
+		snap_request *req = (snap_request *)requests.ItemAt( idx );
+		delete req->msg;
+		delete req;
+	}
+	requests.MakeEmpty();
+}
+
+// ----------------------------------------------------------------------
+// Send every request, concurrency at a time; replies has room for all of
+// them, and gets NULL for the ones that didn't get an answer.
+static void send_requests( snap_crawl &crawl, BList &requests,
+                           BMessage **replies )
+{
+	int32 count = requests.CountItems();
+	BMessage **msgs = new BMessage *[count > 0 ? count : 1];
+	for( int32 idx = 0; idx < count; idx++ ) {
+		msgs[idx] = ( (snap_request *)requests.ItemAt( idx ) )->msg;
+	}
+
+	for( int32 first = 0; first < count; first += crawl.concurrency ) {
+		int32 run = count - first;
+		if( run > crawl.concurrency ) run = crawl.concurrency;
+
+		(void)hey_send_pipelined( crawl.hey, msgs + first, replies + first,
+		                          run, crawl.reply_timeout, crawl.send_timeout );
+	}
+
+	delete [] msgs;
+	crawl.stats.requests += count;
+}
+
+// ----------------------------------------------------------------------
+// Why didn't that work?
+static int32 reply_error( const BMessage *reply )
+{
+	int32 error;
+	if( reply == NULL ) {
+		return B_TIMED_OUT;
+	} else if( reply->FindInt32( "error", &error ) == B_OK && error != B_OK ) {
+		return error;
+	} else if( reply->what == B_MESSAGE_NOT_UNDERSTOOD ) {
+		return B_BAD_SCRIPT_SYNTAX;
+	} else if( reply->what != B_REPLY ) {
+		return B_ERROR;
+	}
+
+	return B_OK;
+}
+
+// ======================================================================
+// Suites
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Read one property_info entry.  A property with no commands takes any
+// command; if it takes them by index, its items are handlers.
+static uint32 property_flags( const property_info &prop )
+{
+	bool any = ( prop.commands[0] == 0 );
+	bool get = false;
+	bool count = false;
+	for( unsigned int c = 0; c < INFO_SLOTS( prop.commands ); c++ ) {
+		if( prop.commands[c] == 0 ) break;
+		if( prop.commands[c] == B_GET_PROPERTY ) get = true;
+		if( prop.commands[c] == B_COUNT_PROPERTIES ) count = true;
+	}
+
+	bool direct = ( prop.specifiers[0] == 0 );
+	bool index = false;
+	for( unsigned int s = 0; s < INFO_SLOTS( prop.specifiers ); s++ ) {
+		if( prop.specifiers[s] == 0 ) break;
+		if( prop.specifiers[s] == B_DIRECT_SPECIFIER ) direct = true;
+		if( prop.specifiers[s] == B_INDEX_SPECIFIER ) index = true;
+	}
+
+	uint32 flags = 0;
+	if( get && direct ) flags |= SNAP_GET;
+	if( get && index ) flags |= SNAP_GET_INDEX;
+	if( count ) flags |= SNAP_COUNT;
+	if( any && index ) flags |= SNAP_HANDLER;
+
+	return flags;
+}
+
+// ----------------------------------------------------------------------
+static snap_suites *read_suites( const char *shape, const BMessage *reply )
+{
+	snap_suites *suites = new snap_suites;
+	suites->shape = copy_string( shape );
+	suites->handler = ( reply_error( reply ) == B_OK );
+	if( !suites->handler ) {
+		return suites;
+	}
+
+	const char *name;
+	for( int32 idx = 0; reply->FindString( "suites", idx, &name ) == B_OK;
+		 idx++ ) {
+		suites->names.AddString( "suites", name );
+	}
+
+	const void *data;
+	ssize_t size;
+	for( int32 idx = 0;
+		 reply->FindData( "messages", B_PROPERTY_INFO_TYPE, idx, &data,
+		                  &size ) == B_OK;
+		 idx++ ) {
+		BPropertyInfo pi;
+		if( pi.Unflatten( B_PROPERTY_INFO_TYPE, data, size ) != B_OK ) {
+			continue;
+		}
+
+		const property_info *props = pi.Properties();
+		for( int32 p = 0; p < pi.CountProperties(); p++ ) {
+			// We already have the suites.
+			if( props[p].name == NULL ||
+				strcmp( props[p].name, "Suites" ) == 0 ) {
+				continue;
+			}
+
+			uint32 flags = property_flags( props[p] );
+			if( flags == 0 ) continue;
+
+			// The same property is often listed once per command.
+			snap_property *prop = NULL;
+			for( int32 i = 0; i < suites->props.CountItems(); i++ ) {
+				snap_property *known = (snap_property *)suites->props.ItemAt( i );
+				if( strcmp( known->name, props[p].name ) == 0 ) {
+					prop = known;
+					break;
+				}
+			}
+
+			if( prop == NULL ) {
+				prop = new snap_property;
+				prop->name = copy_string( props[p].name );
+				prop->flags = 0;
+				suites->props.AddItem( prop );
+			}
+			prop->flags |= flags;
+		}
+	}
+
+	return suites;
+}
+
+static snap_suites *find_suites( snap_crawl &crawl, const char *shape )
+{
+	for( int32 idx = 0; idx < crawl.memo.CountItems(); idx++ ) {
+		snap_suites *suites = (snap_suites *)crawl.memo.ItemAt( idx );
+		if( strcmp( suites->shape, shape ) == 0 ) {
+			return suites;
+		}
+	}
+
+	return NULL;
+}
+
+// ======================================================================
+// The crawl
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static snap_node *new_node( snap_crawl &crawl, snap_node *parent,
+                            const char *property, int32 index )
+{
+	snap_node *node = new snap_node;
+	node->text = NULL;
+	node->shape = NULL;
+	node->suites = NULL;
+	node->depth = parent ? parent->depth + 1 : 0;
+	crawl.nodes.AddItem( node );
+	crawl.stats.handlers++;
+
+	if( parent == NULL ) {
+		node->text = copy_string( "" );
+		node->shape = copy_string( "" );
+		return node;
+	}
+
+	node->path.AddSpecifier( property, index );
+	BMessage level;
+	for( int32 idx = 0;
+		 parent->path.FindMessage( "specifiers", idx, &level ) == B_OK;
+		 idx++ ) {
+		node->path.AddSpecifier( &level );
+	}
+
+	char item[B_OS_NAME_LENGTH + 80];
+	sprintf( item, "%.64s %ld", property, index );
+	node->text = join_path( item, parent->text );
+	node->shape = join_path( property, parent->shape );
+	parent->items.AddItem( node );
+
+	return node;
+}
+
+// ----------------------------------------------------------------------
+// Step 1: suites for every shape we haven't seen.
+static void crawl_suites( snap_crawl &crawl, BList &level )
+{
+	BList requests;
+	for( int32 idx = 0; idx < level.CountItems(); idx++ ) {
+		snap_node *node = (snap_node *)level.ItemAt( idx );
+		if( find_suites( crawl, node->shape ) ) continue;
+
+		bool asked = false;
+		for( int32 r = 0; !asked && r < requests.CountItems(); r++ ) {
+			snap_request *req = (snap_request *)requests.ItemAt( r );
+			asked = ( strcmp( req->node->shape, node->shape ) == 0 );
+		}
+		if( asked ) continue;
+
+		(void)add_request( requests, B_GET_SUPPORTED_SUITES, node, NULL, -1,
+		                   's' );
+	}
+
+	int32 count = requests.CountItems();
+	BMessage **replies = new BMessage *[count > 0 ? count : 1];
+	send_requests( crawl, requests, replies );
+
+	for( int32 idx = 0; idx < count; idx++ ) {
+		snap_request *req = (snap_request *)requests.ItemAt( idx );
+		snap_suites *suites = read_suites( req->node->shape, replies[idx] );
+		crawl.memo.AddItem( suites );
+
+		int32 error = reply_error( replies[idx] );
+		if( error != B_OK ) {
+			req->node->errors.AddInt32( "GetSuites", error );
+			crawl.stats.errors++;
+		}
+		delete replies[idx];
+	}
+	delete [] replies;
+	free_requests( requests );
+
+	for( int32 idx = 0; idx < level.CountItems(); idx++ ) {
+		snap_node *node = (snap_node *)level.ItemAt( idx );
+		node->suites = find_suites( crawl, node->shape );
+	}
+}
+
+// ----------------------------------------------------------------------
+// Step 2: direct Gets and Counts.  The Counts are left in counts for
+// step 3.
+static void crawl_properties( snap_crawl &crawl, BList &level,
+                              BList &counts )
+{
+	BList requests;
+	for( int32 idx = 0; idx < level.CountItems(); idx++ ) {
+		snap_node *node = (snap_node *)level.ItemAt( idx );
+		if( node->suites == NULL || !node->suites->handler ) continue;
+
+		BList &props = node->suites->props;
+		for( int32 p = 0; p < props.CountItems(); p++ ) {
+			snap_property *prop = (snap_property *)props.ItemAt( p );
+			if( prop->flags & SNAP_GET ) {
+				(void)add_request( requests, B_GET_PROPERTY, node, prop, -1,
+				                   'g' );
+			}
+			if( prop->flags & SNAP_COUNT ) {
+				(void)add_request( requests, B_COUNT_PROPERTIES, node, prop,
+				                   -1, 'c' );
+			}
+		}
+	}
+
+	int32 count = requests.CountItems();
+	BMessage **replies = new BMessage *[count > 0 ? count : 1];
+	send_requests( crawl, requests, replies );
+
+	for( int32 idx = 0; idx < count; idx++ ) {
+		snap_request *req = (snap_request *)requests.ItemAt( idx );
+		snap_node *node = req->node;
+		const char *name = req->prop->name;
+
+		int32 error = reply_error( replies[idx] );
+		if( error == B_OK && req->kind == 'c' &&
+			replies[idx]->FindInt32( "result", &req->count ) != B_OK ) {
+			error = B_BAD_VALUE;
+		}
+		if( error == B_OK && req->kind == 'g' &&
+			!copy_field( *replies[idx], "result", node->values, name ) ) {
+			error = B_BAD_VALUE;
+		}
+
+		if( error != B_OK ) {
+			node->errors.AddInt32( name, error );
+			crawl.stats.errors++;
+		} else if( req->kind == 'c' ) {
+			node->counts.AddInt32( name, req->count );
+		}
+		delete replies[idx];
+	}
+	delete [] replies;
+
+	// Hang on to the Counts; throw out the rest.
+	for( int32 idx = 0; idx < count; idx++ ) {
+		snap_request *req = (snap_request *)requests.ItemAt( idx );
+		if( req->kind == 'c' && req->count > 0 ) {
+			counts.AddItem( req );
+		} else {
+			delete req->msg;
+			delete req;
+		}
+	}
+	requests.MakeEmpty();
+}
+
+// ----------------------------------------------------------------------
+// Step 3: items.  Handlers go in next for the next level.
+static void crawl_items( snap_crawl &crawl, BList &counts, BList &next )
+{
+	BList requests;
+	for( int32 idx = 0; idx < counts.CountItems(); idx++ ) {
+		snap_request *counted = (snap_request *)counts.ItemAt( idx );
+		snap_node *node = counted->node;
+		snap_property *prop = counted->prop;
+
+		int32 items = counted->count;
+		if( items > crawl.items ) items = crawl.items;
+
+		for( int32 item = 0; item < items; item++ ) {
+			if( prop->flags & SNAP_HANDLER ) {
+				if( node->depth + 1 < crawl.depth ) {
+					next.AddItem( new_node( crawl, node, prop->name, item ) );
+				}
+			} else if( ( prop->flags & SNAP_GET_INDEX ) &&
+			           !( prop->flags & SNAP_GET ) ) {
+				(void)add_request( requests, B_GET_PROPERTY, node, prop, item,
+				                   'g' );
+			}
+		}
+	}
+
+	int32 count = requests.CountItems();
+	BMessage **replies = new BMessage *[count > 0 ? count : 1];
+	send_requests( crawl, requests, replies );
+
+	// One error per property is plenty.
+	for( int32 idx = 0; idx < count; idx++ ) {
+		snap_request *req = (snap_request *)requests.ItemAt( idx );
+		snap_node *node = req->node;
+		const char *name = req->prop->name;
+
+		int32 error = reply_error( replies[idx] );
+		if( error == B_OK &&
+			!copy_field( *replies[idx], "result", node->values, name ) ) {
+			error = B_BAD_VALUE;
+		}
+
+		if( error != B_OK ) {
+			if( !node->errors.HasInt32( name ) ) {
+				node->errors.AddInt32( name, error );
+			}
+			crawl.stats.errors++;
+		}
+		delete replies[idx];
+	}
+	delete [] replies;
+	free_requests( requests );
+}
+
+// ----------------------------------------------------------------------
+// Put a handler (and everything under it) into one message.
+static void build_message( const snap_node *node, BMessage &msg )
+{
+	msg.what = HEY_SNAPSHOT;
+	msg.AddString( "path", node->text );
+
+	if( node->suites && node->suites->handler ) {
+		const char *name;
+		for( int32 idx = 0;
+			 node->suites->names.FindString( "suites", idx, &name ) == B_OK;
+			 idx++ ) {
+			msg.AddString( "suites", name );
+		}
+	}
+
+	if( node->values.CountNames( B_ANY_TYPE ) > 0 ) {
+		msg.AddMessage( "values", &node->values );
+	}
+	if( node->counts.CountNames( B_ANY_TYPE ) > 0 ) {
+		msg.AddMessage( "counts", &node->counts );
+	}
+	if( node->errors.CountNames( B_ANY_TYPE ) > 0 ) {
+		msg.AddMessage( "errors", &node->errors );
+	}
+
+	for( int32 idx = 0; idx < node->items.CountItems(); idx++ ) {
+		BMessage item;
+		build_message( (snap_node *)node->items.ItemAt( idx ), item );
+		msg.AddMessage( "items", &item );
+	}
+}
+
+static void free_crawl( snap_crawl &crawl )
+{
+	for( int32 idx = 0; idx < crawl.nodes.CountItems(); idx++ ) {
+		snap_node *node = (snap_node *)crawl.nodes.ItemAt( idx );
+		delete [] node->text;
+		delete [] node->shape;
+		delete node;
+	}
+	crawl.nodes.MakeEmpty();
+
+	for( int32 idx = 0; idx < crawl.memo.CountItems(); idx++ ) {
+		snap_suites *suites = (snap_suites *)crawl.memo.ItemAt( idx );
+		for( int32 p = 0; p < suites->props.CountItems(); p++ ) {
+			snap_property *prop = (snap_property *)suites->props.ItemAt( p );
+			delete [] prop->name;
+			delete prop;
+		}
+		delete [] suites->shape;
+		delete suites;
+	}
+	crawl.memo.MakeEmpty();
+}
+
+// ----------------------------------------------------------------------
+// Crawl the whole tree into root.  No Python in here.
+static status_t crawl_target( snap_crawl &crawl, BMessage &root )
+{
+	BList level;
+	BList next;
+	BList counts;
+	status_t retval = B_OK;
+
+	try {
+		level.AddItem( new_node( crawl, NULL, NULL, -1 ) );
+
+		while( !level.IsEmpty() ) {
+			crawl_suites( crawl, level );
+			crawl_properties( crawl, level, counts );
+			crawl_items( crawl, counts, next );
+			free_requests( counts );
+
+			level.MakeEmpty();
+			level.AddList( &next );
+			next.MakeEmpty();
+		}
+
+		build_message( (snap_node *)crawl.nodes.ItemAt( 0 ), root );
+
+		// A connection's team is in some other machine, maybe, so only
+		// the agent can say what it is.
+		app_info info;
+		if( crawl.hey->connection ) {
+			const char *signature = crawl.hey->connection->Signature();
+			if( signature[0] ) root.AddString( "signature", signature );
+		} else if( be_roster->GetRunningAppInfo( hey_team( crawl.hey ),
+		                                         &info ) == B_OK ) {
+			root.AddString( "signature", info.signature );
+		}
+		root.AddInt32( "time", (int32)real_time_clock() );
+	} catch ( bad_alloc &ex ) {
+		free_requests( counts );
+		retval = B_NO_MEMORY;
+	}
+
+	free_crawl( crawl );
+	return retval;
+}
+
+// ======================================================================
+// Module functions
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Snapshot( target, filename, depth = 8, items = 256, concurrency = 16 )
+//
+// target is a Hey object, or anything you could make one from.  depth
+// is how many levels of handlers to go down, items is the most items of
+// any one property to look at, and concurrency is the most requests to
+// have outstanding at once.  Returns ( handlers, requests, errors ).
+PyObject *Snapshot_Take( PyObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { "target", "filename", "depth", "items",
+	                          "concurrency", NULL };
+	PyObject *target;
+	char *filename;
+	int depth = 8;
+	int items = 256;
+	int concurrency = 16;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "Os|iii", kwlist, &target,
+	                                  &filename, &depth, &items,
+	                                  &concurrency ) ) {
+		return NULL;
+	}
+
+	if( depth < 1 || items < 0 || concurrency < 1 ) {
+		PyErr_SetString( PyExc_ValueError,
+		                 "depth and concurrency must be at least 1, and items can't be negative" );
+		return NULL;
+	}
+
+	HeyObject *hey;
+	if( HeyObject_Check( target ) ) {
+		Py_INCREF( target );
+		hey = (HeyObject *)target;
+	} else {
+		PyObject *hey_args = Py_BuildValue( "(O)", target );
+		hey = hey_args ? newHeyObject( hey_args ) : NULL;
+		Py_XDECREF( hey_args );
+		if( hey == NULL ) {
+			return NULL;
+		}
+	}
+
+	snap_crawl crawl;
+	crawl.hey = hey;
+	crawl.send_timeout = hey->send_timeout;
+	crawl.reply_timeout = hey->reply_timeout;
+	crawl.depth = depth;
+	crawl.items = items;
+	crawl.concurrency = concurrency;
+	crawl.stats.handlers = 0;
+	crawl.stats.requests = 0;
+	crawl.stats.errors = 0;
+
+	status_t retval;
+	Py_BEGIN_ALLOW_THREADS
+	BMessage root;
+	retval = crawl_target( crawl, root );
+	if( retval == B_OK ) {
+		BFile file( filename, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE );
+		retval = file.InitCheck();
+		if( retval == B_OK ) {
+			retval = root.Flatten( &file );
+		}
+	}
+	Py_END_ALLOW_THREADS
+
+	Py_DECREF( hey );
+
+	if( retval == B_NO_MEMORY ) {
+		return PyErr_NoMemory();
+	} else if( retval != B_OK ) {
+		char buff[256];
+		sprintf( buff, "can't write %.128s: %.64s", filename,
+		         strerror( retval ) );
+		PyErr_SetString( PyExc_IOError, buff );
+		return NULL;
+	}
+
+	return Py_BuildValue( "(lll)", crawl.stats.handlers,
+	                      crawl.stats.requests, crawl.stats.errors );
+}
+
+// ----------------------------------------------------------------------
+// ReadSnapshot( filename ): a snapshot file as a dictionary, converted
+// the same way replies are.
+PyObject *Snapshot_Read( PyObject *self, PyObject *args )
+{
+	char *filename;
+	if( !PyArg_ParseTuple( args, "s", &filename ) ) {
+		return NULL;
+	}
+
+	BMessage root;
+	status_t retval;
+	Py_BEGIN_ALLOW_THREADS
+	BFile file( filename, B_READ_ONLY );
+	retval = file.InitCheck();
+	if( retval == B_OK ) {
+		retval = root.Unflatten( &file );
+	}
+	Py_END_ALLOW_THREADS
+
+	if( retval == B_OK && root.what != HEY_SNAPSHOT ) {
+		retval = B_BAD_TYPE;
+	}
+	if( retval != B_OK ) {
+		char buff[256];
+		sprintf( buff, "can't read %.128s: %.64s", filename,
+		         strerror( retval ) );
+		PyErr_SetString( PyExc_IOError, buff );
+		return NULL;
+	}
+
+	return msg_to_dict( root );
+}
@@ -0,0 +1,45 @@
+// Snapshot
+//
+// Snapshots are used by heymodule to write down everything an
+// application's scripting interface will tell you (suites, counts, and
+// every property you can Get, for every handler you can get to) in one
+// file, so two runs can be compared.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Snapshot_H
+#define PyHey_Snapshot_H
+
+#include "Python.h"
+
+#include <app/Message.h>
+
+// The "what" of every handler's message in a snapshot file.  The file is
+// one flattened message: the application's handler, with these fields:
+//
+// "path"		hey-style specifier for the handler ("" for the application)
+// "suites"		the handler's suite names
+// "values"		a message with the reply data for each property
+// "counts"		a message with the Count for each countable property
+// "errors"		a message with the error for each request that failed
+// "items"		a message like this one for each item of a handler property
+//
+// The application's message also has its "signature" and the "time" it
+// was taken.
+#define HEY_SNAPSHOT	'hSnp'
+
+// Module functions:
+//
+// Snapshot( target, filename, depth = 8, items = 256, concurrency = 16 )
+// ReadSnapshot( filename )
+PyObject *Snapshot_Take( PyObject *self, PyObject *args, PyObject *kwds );
+PyObject *Snapshot_Read( PyObject *self, PyObject *args );
+
+#endif
@@ -6,9 +6,8 @@
 // Copyright © 1998 Chris Herborth (chrish@kagi.com)
 //                  Arcane Dragon Software
 //
-// The add_specifier() function at the end of this file was borrowed from
-// code posted by Attila Mezei at http://w3.datanet.hu/~amezei/ in the
-// "hey" utility.
+// The specifier string parser (borrowed from Attila Mezei's "hey"
+// utility) lives in SpecifierParser.cpp.
 //
 // License:  You can do anything you want with this source code, including
 //           incorporating it into commercial applications, as long as you
@@ -17,14 +16,89 @@
 // $Id: Specifier.cpp,v 1.1.1.1 1999/06/08 12:49:38 chrish Exp $
 
 #include "Specifier.h"
+#include "SpecifierParser.h"
 
-// Proto for func stolen from Attila's "hey"... code is at the bottom.
-static status_t add_specifier( BMessage *to_message, char *argv[], int32 *argx );
+#include <string.h>
 
 // ======================================================================
 // Specifier object
 // ======================================================================
 
+// ----------------------------------------------------------------------
+// The compiled specifier cache.
+//
+// Scripts love to build the same specifier strings over and over (usually
+// inside a loop), so we remember the last few we've parsed.  spec_cache
+// maps the string to its compiled Specifier; since that's frozen, everyone
+// who asks for the same string gets the same object.  spec_cache_order
+// remembers the order they went in, so the oldest one can be thrown out
+// when the cache is full.
+static PyObject *spec_cache = NULL;
+static PyObject *spec_cache_order = NULL;
+static int spec_cache_limit = 256;
+static long spec_cache_hits = 0;
+static long spec_cache_misses = 0;
+
+static SpecifierObject *alloc_specifier( void );
+static void cache_specifier( PyObject *key, SpecifierObject *spec );
+
+// ----------------------------------------------------------------------
+// Create an empty Specifier object.
+static SpecifierObject *alloc_specifier( void )
+{
+	SpecifierObject *self;
+	self = PyObject_NEW( SpecifierObject, &Specifier_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	self->frozen = 0;
+	try {
+		self->msg = new BMessage;
+	} catch ( bad_alloc &ex ) {
+		self->msg = NULL;
+		Py_DECREF( self );
+		return (SpecifierObject *)PyErr_NoMemory();
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Remember a compiled specifier; spec must be frozen.
+static void cache_specifier( PyObject *key, SpecifierObject *spec )
+{
+	if( spec_cache_limit < 1 ) return;
+
+	if( spec_cache == NULL ) {
+		spec_cache = PyDict_New();
+		spec_cache_order = PyList_New( 0 );
+		if( spec_cache == NULL || spec_cache_order == NULL ) {
+			// No cache this time; maybe next time.
+			Py_XDECREF( spec_cache );
+			Py_XDECREF( spec_cache_order );
+			spec_cache = NULL;
+			spec_cache_order = NULL;
+			PyErr_Clear();
+			return;
+		}
+	}
+
+	// Make room by throwing out the oldest entries.
+	while( PyList_Size( spec_cache_order ) >= spec_cache_limit ) {
+		PyObject *oldest = PyList_GetItem( spec_cache_order, 0 );
+		(void)PyDict_DelItem( spec_cache, oldest );
+		(void)PyList_SetSlice( spec_cache_order, 0, 1, NULL );
+	}
+
+	if( PyDict_SetItem( spec_cache, key, (PyObject *)spec ) != 0 ||
+		PyList_Append( spec_cache_order, key ) != 0 ) {
+		// Caching is only an optimization; don't let it cause trouble.
+		(void)PyDict_DelItem( spec_cache, key );
+		PyErr_Clear();
+	}
+}
+
 // ----------------------------------------------------------------------
 // Create a new Specifier object.
 SpecifierObject *newSpecifierObject( PyObject *arg )
@@ -43,77 +117,198 @@ SpecifierObject *newSpecifierObject( PyObject *arg )
 		}
 	}
 
-	SpecifierObject *self;
-	self = PyObject_NEW( SpecifierObject, &Specifier_Type );
-	if( self == NULL ) {
-		return NULL;
+	PyObject *key = NULL;
+	if( spec ) {
+		// Been here before?  Then you can have the one we made last time.
+		key = PyTuple_GetItem( arg, 0 );
+		SpecifierObject *cached = NULL;
+		if( spec_cache ) {
+			cached = (SpecifierObject *)PyDict_GetItem( spec_cache, key );
+		}
+
+		if( cached ) {
+			spec_cache_hits++;
+			Py_INCREF( cached );
+			return cached;
+		}
+		spec_cache_misses++;
 	}
-	
-	try {
-		self->msg = new BMessage;
-	} catch ( bad_alloc &ex ) {
-		// TODO: we leak self here...
+
+	SpecifierObject *self = alloc_specifier();
+	if( self == NULL ) {
 		return NULL;
 	}
 
 	if( spec ) {
-		// Ow!  Evil string specifier given...
-		char *tmp = strdup( spec );
 
-		// Count the number of "words".
-		int spec_argc = 1;
-		for( size_t idx = 0; idx < strlen( tmp ); idx++ ) {
-			if( tmp[idx] == ' ' ) spec_argc++;
-		}
-		
-		char **spec_argv = (char **)malloc( sizeof( char * ) * ( spec_argc + 1 ) );
-		if( spec_argv == NULL ) return (SpecifierObject *)PyErr_NoMemory();
-
-		// Split the string up into "words".
-		int arg = 0;
-		char *ptr = strtok( tmp, " " );
-		while( ptr ) {
-			spec_argv[arg++] = strdup( ptr );
-			ptr = strtok( NULL, " " );
-		}
-		spec_argv[arg] = NULL;
+		status_t retval = parse_specifier_string( self->msg, spec );
 
-		int32 argx = 0;
-		status_t retval = B_OK;
-		while( retval == B_OK ) {
-			retval = add_specifier( self->msg, spec_argv, &argx );
-		}
-		
-		// Release all the memory we wasted.
-		for( int idx = 0; spec_argv[idx] != NULL; idx++ ) {
-			free( spec_argv[idx] );
-		}
-		free( spec_argv );
-		free( tmp );
-		
 		// Now decide how well things went.
 		switch( retval ) {
 		case B_BAD_SCRIPT_SYNTAX:
-			// TODO: we leak here...
+			Py_DECREF( self );
 			PyErr_SetString( PyExc_SyntaxError, "bad script syntax" );
 			return NULL;
 			break;
-			
-		case B_ERROR:	// That's OK, we're just at the end of our string.
-			// Fall-through...
-		case B_OK:		// That's OK too.
+
+		case B_NO_MEMORY:
+			Py_DECREF( self );
+			return (SpecifierObject *)PyErr_NoMemory();
+			break;
+
+		case B_OK:		// That's OK.
 			break;
 
 		default:
 			// "The frogurt is also cursed."
+			Py_DECREF( self );
 			PyErr_SetString( PyExc_RuntimeError, "unknown specifier error" );
+			return NULL;
 			break;
 		}
+
+		// It's built; keep it for next time.
+		self->frozen = 1;
+		cache_specifier( key, self );
 	}
 
 	return self;
 }
 
+// ----------------------------------------------------------------------
+// Wrap a copy of a finished specifier stack (from a Template, say).
+SpecifierObject *newSpecifierFromMessage( const BMessage &msg )
+{
+	SpecifierObject *self = alloc_specifier();
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	*self->msg = msg;
+	self->frozen = 1;
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Module functions for looking at and tuning the specifier cache.
+PyObject *Specifier_CacheInfo( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	int size = spec_cache ? PyDict_Size( spec_cache ) : 0;
+
+	return Py_BuildValue( "{s:l,s:l,s:i,s:i}",
+				"hits", spec_cache_hits,
+				"misses", spec_cache_misses,
+				"size", size,
+				"limit", spec_cache_limit );
+}
+
+PyObject *Specifier_SetCacheSize( PyObject *self, PyObject *args )
+{
+	int limit;
+	if( !PyArg_ParseTuple( args, "i", &limit ) ) {
+		return NULL;
+	}
+	if( limit < 0 ) {
+		PyErr_SetString( PyExc_ValueError, "cache size must not be negative" );
+		return NULL;
+	}
+
+	spec_cache_limit = limit;
+
+	// Trim the cache down to size right away.
+	while( spec_cache_order && PyList_Size( spec_cache_order ) > spec_cache_limit ) {
+		PyObject *oldest = PyList_GetItem( spec_cache_order, 0 );
+		(void)PyDict_DelItem( spec_cache, oldest );
+		(void)PyList_SetSlice( spec_cache_order, 0, 1, NULL );
+	}
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+PyObject *Specifier_ClearCache( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	if( spec_cache ) {
+		PyDict_Clear( spec_cache );
+		(void)PyList_SetSlice( spec_cache_order, 0,
+					PyList_Size( spec_cache_order ), NULL );
+	}
+	spec_cache_hits = 0;
+	spec_cache_misses = 0;
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+// ----------------------------------------------------------------------
+// ODS 22-Jul-1999
+// Create a specifier object from arguments.
+// This differs from standard specifier creation in that, if a specifier
+// object is passed in, that specifier object is simply incremented and
+// returned. Otherwise, a new specifier object is created and returned.
+// In either case, this function increments the specifier's reference
+// count, so when you're done with the specifier object, decrement it.
+SpecifierObject* parse_specifier(PyObject* args)
+{
+	// Get the specifier first.	
+	PyObject* obj;
+	if (! PyArg_ParseTuple( args, "O", &obj ) )
+		return NULL;
+	
+	SpecifierObject *spec = NULL;
+	// Mmm, crufty C casts! Gotta love that object-oriented C...
+	PyTypeObject* type = reinterpret_cast<PyTypeObject*>(PyObject_Type( obj ));
+	if (type == &Specifier_Type) {
+		// we were passed in a specifier directly
+		// recast and increment count to balance
+		// the decrement later on
+		spec = reinterpret_cast<SpecifierObject*>(obj);
+		Py_INCREF(spec);
+	} else {
+		// we were passed in something else;
+		// see if we can make a specifier out of it!
+		spec = newSpecifierObject(args);
+	}
+	
+	// Whoever asked is going to use it, so it can't change any more.
+	if (spec) spec->frozen = 1;
+
+	return spec;
+}
+
+// ----------------------------------------------------------------------
+// Build a request from a specifier; the caller owns the new message.  A
+// Specifier only ever holds its specifier stack (Add() can't put anything
+// else in it), so the copy is ready for the caller's command and data.
+BMessage *new_request( SpecifierObject *spec, uint32 what )
+{
+	BMessage *msg;
+	try {
+		if( spec ) {
+			msg = new BMessage( *spec->msg );
+			spec->frozen = 1;
+		} else {
+			msg = new BMessage;
+		}
+	} catch ( bad_alloc &ex ) {
+		(void)PyErr_NoMemory();
+		return NULL;
+	}
+
+	msg->what = what;
+
+	return msg;
+}
+
 // ----------------------------------------------------------------------
 // Delete a Specifier object
 static void Specifier_dealloc( SpecifierObject *self )
@@ -138,12 +333,24 @@ static PyObject *Specifier_Add( SpecifierObject *self, PyObject *arg )
 	char *property, *name;
 	int index, range_start, range_run;
 
+	if( self->frozen ) {
+		PyErr_SetString( PyExc_TypeError,
+				"Specifier can't be changed once it's been used; Copy() it first" );
+		return NULL;
+	}
+
 	if( PyArg_ParseTuple( arg, "s", &property ) ) {
 		// It _is_ just a string, so we've got a direct specifier.
 		self->msg->AddSpecifier( property );
 	} else if( PyArg_ParseTuple( arg, "ss", &property, &name ) ) {
-		// It's a name specifier...
-		self->msg->AddSpecifier( property, name );
+		// It's a name specifier, or "*" for all of them...
+		if( strcmp( name, "*" ) == 0 ) {
+			BMessage all( HEY_ALL_SPECIFIER );
+			all.AddString( "property", property );
+			self->msg->AddSpecifier( &all );
+		} else {
+			self->msg->AddSpecifier( property, name );
+		}
 	} else if( PyArg_ParseTuple( arg, "si", &property, &index ) ) {
 		// Either index or reverse index.
 		if( index < 0 ) {
@@ -183,15 +390,38 @@ static PyObject *Specifier_Add( SpecifierObject *self, PyObject *arg )
 	return Py_None;
 }
 
+// ----------------------------------------------------------------------
+// Make a copy you can Add() to.
+static PyObject *Specifier_Copy( SpecifierObject *self, PyObject *arg )
+{
+	if( !PyArg_ParseTuple( arg, "" ) ) {
+		return NULL;
+	}
+
+	SpecifierObject *copy = alloc_specifier();
+	if( copy == NULL ) {
+		return NULL;
+	}
+
+	*copy->msg = *self->msg;
+
+	return (PyObject *)copy;
+}
+
 // ----------------------------------------------------------------------
 // Method table and whatnot for the Specifier object.
 static PyMethodDef SpecifierObject_methods[] = {
 	{ "Add",	(PyCFunction)Specifier_Add,	1,	"Add a specifier." },
+	{ "Copy",	(PyCFunction)Specifier_Copy,	1,	"Return a copy of the specifier that can be changed." },
 	{ NULL, NULL }	// sentinel
 };
 
 static PyObject *Specifier_getattr( SpecifierObject *self, char *name )
 {
+	if( strcmp( name, "frozen" ) == 0 ) {
+		return PyInt_FromLong( self->frozen );
+	}
+
 	return Py_FindMethod( SpecifierObject_methods, (PyObject *)self, name );
 }
 
@@ -213,106 +443,3 @@ PyTypeObject Specifier_Type = {
 	0,			// tp_as_mapping
 	0,			// tp_hash
 };
-
-// ======================================================================
-// Code borrowed from "hey" to parse a "hey" specifier line; it's not
-// just _similar_ parsing, it's the real thing!
-// returns B_OK if successful 
-//         B_ERROR if no more specifiers
-//         B_BAD_SCRIPT_SYNTAX if syntax error
-static status_t add_specifier(BMessage *to_message, char *argv[], int32 *argx)
-{
-
-	char *property=argv[*argx];
-	
-	if(property==NULL) return B_ERROR;		// no more specifiers
-	
-	(*argx)++;
-	
-	if(strcasecmp(property, "to")==0){	// it is the 'to' string!!!
-		return B_ERROR;	// no more specifiers
-	}
-	
-	if(strcasecmp(property, "of")==0){		// skip "of", read real property
-		property=argv[*argx];
-		if(property==NULL) return B_BAD_SCRIPT_SYNTAX;		// bad syntax
-		(*argx)++;
-	}
-	
-	// decide the specifier
-
-	char *specifier=argv[*argx];
-	if(specifier==NULL){	// direct specifier
-		to_message->AddSpecifier(property);
-		return B_ERROR;		// no more specifiers
-	}
-
-	(*argx)++;
-
-	if(strcasecmp(specifier, "of")==0){	// direct specifier
-		to_message->AddSpecifier(property);
-		return B_OK;	
-	}
-
-	if(strcasecmp(specifier, "to")==0){	// direct specifier
-		to_message->AddSpecifier(property);
-		return B_ERROR;		// no more specifiers	
-	}
-
-
-	if(specifier[0]=='['){	// index, reverse index or range
-		char *end;
-		int32 ix1, ix2;
-		if(specifier[1]=='-'){	// reverse index
-			ix1=strtoul(specifier+2, &end, 10);
-			BMessage revspec(B_REVERSE_INDEX_SPECIFIER);
-			revspec.AddString("property", property);
-			revspec.AddInt32("index", ix1);
-			to_message->AddSpecifier(&revspec);
-		}else{	// index or range
-			ix1=strtoul(specifier+1, &end, 10);
-			if(end[0]==']'){	// it was an index
-				to_message->AddSpecifier(property, ix1);
-				return B_OK;	
-			}else{
-				specifier=argv[*argx];
-				if(specifier==NULL){
-					// I was wrong, it was just an index
-					to_message->AddSpecifier(property, ix1);
-					return B_OK;	
-				}		
-				(*argx)++;
-				if(strcasecmp(specifier, "to")==0){
-					specifier=argv[*argx];
-					if(specifier==NULL){
-						return B_BAD_SCRIPT_SYNTAX;		// wrong syntax
-					}
-					(*argx)++;
-					ix2=strtoul(specifier, &end, 10);
-					to_message->AddSpecifier(property, ix1, ix2-ix1>0 ? ix2-ix1+1 : 1);
-					return B_OK;		
-				}else{
-					return B_BAD_SCRIPT_SYNTAX;		// wrong syntax
-				}
-			}
-		}
-	}else{	// name specifier
-		// if it contains only digits, it will be an index...
-		bool contains_only_digits=true;
-		for(size_t i=0;i<strlen(specifier);i++){
-			if(specifier[i]<'0' || specifier[i]>'9'){
-				contains_only_digits=false;
-				break;
-			}
-		}
-		
-		if(contains_only_digits){
-			to_message->AddSpecifier(property, atol(specifier));
-		}else{
-			to_message->AddSpecifier(property, specifier);
-		}
-		
-	}
-	
-	return B_OK;
-}
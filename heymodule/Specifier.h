@@ -23,6 +23,7 @@
 typedef struct {
 	PyObject_HEAD
 	BMessage *msg;
+	int frozen;		// set once it's been built; Add() won't touch it then
 } SpecifierObject;
 
 // The object's type:
@@ -32,6 +33,29 @@ extern PyTypeObject Specifier_Type;
 #define SpecifierObject_Check(v) ((v)->ob_type == &Specifier_Type)
 
 // Methods you can use.
+//
+// Specifiers built from a string are frozen right away, and may be shared
+// with anyone else who asked for the same string; empty ones can have
+// things added to them until they're first used.
 SpecifierObject *newSpecifierObject( PyObject *arg );
 
+// Make a frozen Specifier holding a copy of msg's specifier stack.
+SpecifierObject *newSpecifierFromMessage( const BMessage &msg );
+
+// Pull a specifier out of a one-item argument tuple; you get back a new
+// reference (either to the Specifier you passed, or to a new one built
+// from a hey-style string).  Either way, it's frozen.
+SpecifierObject *parse_specifier( PyObject *args );
+
+// Build a request message for the given command from a Specifier (or an
+// empty one if spec is NULL).  The request is a copy, so the Specifier
+// itself is never changed, but it's frozen from now on.  Returns NULL and
+// sets an exception if we're out of memory.
+BMessage *new_request( SpecifierObject *spec, uint32 what );
+
+// Module functions for the compiled specifier cache.
+PyObject *Specifier_CacheInfo( PyObject *self, PyObject *args );
+PyObject *Specifier_SetCacheSize( PyObject *self, PyObject *args );
+PyObject *Specifier_ClearCache( PyObject *self, PyObject *args );
+
 #endif
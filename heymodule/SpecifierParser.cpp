@@ -0,0 +1,203 @@
+// SpecifierParser
+//
+// Turns a hey-style specifier string ("Frame of Window 0") into a
+// specifier stack on a BMessage.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// The grammar is the one from Attila Mezei's "hey" utility
+// (http://w3.datanet.hu/~amezei/); parse_specifier_string() started life
+// as hey's add_specifier(), reworked to walk the original string instead
+// of a strdup()'d argv.
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "SpecifierParser.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+// ----------------------------------------------------------------------
+// A NUL-terminated copy of a token, for handing to the BMessage calls.
+// Short ones (which is all of them, in practice) live on the stack.
+class TokenString {
+public:
+	TokenString( const spec_token &token );
+	~TokenString();
+
+	bool InitCheck( void ) const { return str != NULL; }
+	const char *String( void ) const { return str; }
+
+private:
+	char buff[128];
+	char *str;
+};
+
+TokenString::TokenString( const spec_token &token )
+{
+	if( token.len < sizeof( buff ) ) {
+		str = buff;
+	} else {
+		str = (char *)malloc( token.len + 1 );
+		if( str == NULL ) return;
+	}
+
+	memcpy( str, token.str, token.len );
+	str[token.len] = '\0';
+}
+
+TokenString::~TokenString()
+{
+	if( str != buff ) free( str );
+}
+
+// ----------------------------------------------------------------------
+// Is this token the given keyword?  Case doesn't matter.
+static bool token_is( const spec_token &token, const char *word, size_t len )
+{
+	return token.len == len && strncasecmp( token.str, word, len ) == 0;
+}
+
+#define TOKEN_IS( token, word )	token_is( token, word, sizeof( word ) - 1 )
+
+// ----------------------------------------------------------------------
+// Read an unsigned number from the front of str (looking at no more than
+// len characters); *used is how many of them were digits.
+static int32 token_number( const char *str, size_t len, size_t *used )
+{
+	uint32 value = 0;
+	size_t idx;
+
+	for( idx = 0; idx < len && str[idx] >= '0' && str[idx] <= '9'; idx++ ) {
+		value = value * 10 + ( str[idx] - '0' );
+	}
+
+	*used = idx;
+	return (int32)value;
+}
+
+// ======================================================================
+// SpecifierLexer
+// ======================================================================
+
+SpecifierLexer::SpecifierLexer( const char *spec )
+	: pos( spec )
+{
+}
+
+bool SpecifierLexer::Next( spec_token *token )
+{
+	while( *pos == ' ' ) pos++;
+	if( *pos == '\0' ) return false;
+
+	token->str = pos;
+	while( *pos != ' ' && *pos != '\0' ) pos++;
+	token->len = pos - token->str;
+
+	return true;
+}
+
+// ======================================================================
+// The parser.
+//
+// specifier_1 [of specifier_2 ... specifier_n], where each specifier is a
+// property name, optionally followed by a number (index), a name, [n]
+// (index), [-n] (reverse index), [n to m] (range) or * (all of them).  A
+// "to" where a property should be ends the specifier stack.
+status_t parse_specifier_string( BMessage *msg, const char *spec )
+{
+	SpecifierLexer lexer( spec );
+	spec_token property;
+	spec_token specifier;
+	size_t used;
+
+	while( lexer.Next( &property ) ) {
+		if( TOKEN_IS( property, "to" ) ) {	// it is the 'to' string!!!
+			break;							// no more specifiers
+		}
+
+		if( TOKEN_IS( property, "of" ) ) {	// skip "of", read real property
+			if( !lexer.Next( &property ) ) return B_BAD_SCRIPT_SYNTAX;
+		}
+
+		TokenString prop( property );
+		if( !prop.InitCheck() ) return B_NO_MEMORY;
+
+		// decide the specifier
+		if( !lexer.Next( &specifier ) ) {	// direct specifier
+			msg->AddSpecifier( prop.String() );
+			break;							// no more specifiers
+		}
+
+		if( TOKEN_IS( specifier, "of" ) ) {	// direct specifier
+			msg->AddSpecifier( prop.String() );
+			continue;
+		}
+
+		if( TOKEN_IS( specifier, "to" ) ) {	// direct specifier
+			msg->AddSpecifier( prop.String() );
+			break;							// no more specifiers
+		}
+
+		if( TOKEN_IS( specifier, "*" ) ) {	// all of them
+			BMessage allspec( HEY_ALL_SPECIFIER );
+			allspec.AddString( "property", prop.String() );
+			msg->AddSpecifier( &allspec );
+			continue;
+		}
+
+		if( specifier.str[0] == '[' ) {		// index, reverse index or range
+			if( specifier.len > 1 && specifier.str[1] == '-' ) {	// reverse index
+				int32 ix1 = token_number( specifier.str + 2, specifier.len - 2, &used );
+				BMessage revspec( B_REVERSE_INDEX_SPECIFIER );
+				revspec.AddString( "property", prop.String() );
+				revspec.AddInt32( "index", ix1 );
+				msg->AddSpecifier( &revspec );
+				continue;
+			}
+
+			// index or range
+			int32 ix1 = token_number( specifier.str + 1, specifier.len - 1, &used );
+			if( used + 1 < specifier.len && specifier.str[used + 1] == ']' ) {
+				msg->AddSpecifier( prop.String(), ix1 );	// it was an index
+				continue;
+			}
+
+			if( !lexer.Next( &specifier ) ) {
+				// I was wrong, it was just an index
+				msg->AddSpecifier( prop.String(), ix1 );
+				break;
+			}
+
+			if( !TOKEN_IS( specifier, "to" ) ) {
+				return B_BAD_SCRIPT_SYNTAX;		// wrong syntax
+			}
+
+			if( !lexer.Next( &specifier ) ) {
+				return B_BAD_SCRIPT_SYNTAX;		// wrong syntax
+			}
+
+			int32 ix2 = token_number( specifier.str, specifier.len, &used );
+			msg->AddSpecifier( prop.String(), ix1, ix2 - ix1 > 0 ? ix2 - ix1 + 1 : 1 );
+			continue;
+		}
+
+		// name specifier; if it contains only digits, it will be an index...
+		int32 index = token_number( specifier.str, specifier.len, &used );
+		if( used == specifier.len ) {
+			msg->AddSpecifier( prop.String(), index );
+		} else {
+			TokenString name( specifier );
+			if( !name.InitCheck() ) return B_NO_MEMORY;
+
+			msg->AddSpecifier( prop.String(), name.String() );
+		}
+	}
+
+	return B_OK;
+}
@@ -0,0 +1,53 @@
+// SpecifierParser
+//
+// Turns a hey-style specifier string ("Frame of Window 0") into a
+// specifier stack on a BMessage.  This doesn't need Python, so the
+// benchmarks can use it too.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_SpecifierParser_H
+#define PyHey_SpecifierParser_H
+
+#include <app/Message.h>
+#include <string.h>
+
+// A word in a specifier string; this points into the original string,
+// it isn't a copy, so it's not NUL-terminated.
+struct spec_token {
+	const char *str;
+	size_t len;
+};
+
+// Splits a specifier string into words in a single pass, without
+// allocating anything.
+class SpecifierLexer {
+public:
+	SpecifierLexer( const char *spec );
+
+	// Fills in token and returns true, or returns false at the end of
+	// the string.
+	bool Next( spec_token *token );
+
+private:
+	const char *pos;
+};
+
+// "*" after a property ("Title of Window *") means every one of them.
+// Targets have never heard of this form; heymodule expands it (and ranges
+// anywhere but the last specifier) before anything is sent.  The
+// specifier has a "property" and nothing else.
+#define HEY_ALL_SPECIFIER	( B_SPECIFIERS_END + 1 )
+
+// Parse spec onto msg's specifier stack.  Returns B_OK,
+// B_BAD_SCRIPT_SYNTAX if the string doesn't make sense, or B_NO_MEMORY.
+status_t parse_specifier_string( BMessage *msg, const char *spec );
+
+#endif
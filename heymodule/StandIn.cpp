@@ -0,0 +1,596 @@
+// StandIn
+//
+// The stand-in is used by heymodule's benchmarks and load tests as a
+// scriptable target living in this team; see StandIn.h for what it looks
+// like from the outside.
+//
+// Every request is resolved by the looper itself: ResolveSpecifier()
+// always answers "me", and MessageReceived() walks the whole specifier
+// stack through its own tree.  That's not how a real application splits
+// the work between its handlers, but the messages going back and forth
+// are the same, and it keeps the stand-in's own cost small and easy to
+// account for.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "StandIn.h"
+#include "Hey.h"
+
+#include <app/Looper.h>
+#include <app/Message.h>
+#include <app/PropertyInfo.h>
+#include <interface/Rect.h>
+#include <support/List.h>
+#include <support/Locker.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+const standin_config standin_defaults = { 4, 4, 2, 0, 0, 16 * 1024 * 1024 };
+
+// ======================================================================
+// The tree
+// ======================================================================
+
+// The application, a window or a view; which one depends on how deep it
+// is.  The application's children are windows, everybody else's are
+// views.
+struct standin_node {
+	char *name;				// a window's Title, or a view's Name
+	BRect frame;
+	BList children;			// standin_node *s
+};
+
+enum { NODE_APP, NODE_WINDOW, NODE_VIEW };
+
+static void refuse( BMessage *reply, status_t error, const char *message );
+
+// ----------------------------------------------------------------------
+static standin_node *new_node( const char *name, BRect frame )
+{
+	standin_node *node = new standin_node;
+	node->name = new char[strlen( name ) + 1];
+	strcpy( node->name, name );
+	node->frame = frame;
+
+	return node;
+}
+
+static void delete_node( standin_node *node )
+{
+	for( int32 idx = 0; idx < node->children.CountItems(); idx++ ) {
+		delete_node( (standin_node *)node->children.ItemAt( idx ) );
+	}
+
+	delete [] node->name;
+	delete node;
+}
+
+// A new child for parent; windows are staggered down the screen, views
+// are staggered inside their parent.
+static standin_node *add_child( standin_node *parent, int kind,
+                                const char *name )
+{
+	int32 idx = parent->children.CountItems();
+
+	char buff[32];
+	if( name == NULL ) {
+		sprintf( buff, "%s %ld", kind == NODE_APP ? "Window" : "View",
+		         (long)idx );
+		name = buff;
+	}
+
+	BRect frame;
+	if( kind == NODE_APP ) {
+		frame = BRect( 32.0 * idx, 24.0 + 32.0 * idx,
+		               32.0 * idx + 639.0, 24.0 + 32.0 * idx + 479.0 );
+	} else {
+		frame = BRect( 8.0 * idx, 8.0 * idx, 8.0 * idx + 99.0, 8.0 * idx + 99.0 );
+	}
+
+	standin_node *child = new_node( name, frame );
+	parent->children.AddItem( child );
+
+	return child;
+}
+
+// What node and everything under it take up, for the max_data limit.
+static size_t node_size( const standin_node *node )
+{
+	size_t size = sizeof( standin_node ) + strlen( node->name ) + 1;
+	for( int32 idx = 0; idx < node->children.CountItems(); idx++ ) {
+		size += node_size( (const standin_node *)node->children.ItemAt( idx ) );
+	}
+
+	return size;
+}
+
+static void add_views( standin_node *parent, int32 views, int32 depth )
+{
+	if( depth < 1 ) return;
+
+	for( int32 idx = 0; idx < views; idx++ ) {
+		add_views( add_child( parent, NODE_VIEW, NULL ), views, depth - 1 );
+	}
+}
+
+// ----------------------------------------------------------------------
+// What each kind of node tells GetSuites.
+static property_info app_props[] = {
+	{ "Window", { B_COUNT_PROPERTIES, B_CREATE_PROPERTY, 0 },
+	  { B_DIRECT_SPECIFIER, 0 }, "Count or create windows." },
+	{ "Window", { B_GET_PROPERTY, B_DELETE_PROPERTY, 0 },
+	  { B_INDEX_SPECIFIER, B_REVERSE_INDEX_SPECIFIER, B_NAME_SPECIFIER, 0 },
+	  "Get a window's title, or delete it." },
+	{ "Name", { B_GET_PROPERTY, 0 }, { B_DIRECT_SPECIFIER, 0 },
+	  "The application's name." },
+	{ 0 }
+};
+
+static property_info window_props[] = {
+	{ "Title", { B_GET_PROPERTY, B_SET_PROPERTY, 0 },
+	  { B_DIRECT_SPECIFIER, 0 }, "The window's title." },
+	{ "Frame", { B_GET_PROPERTY, B_SET_PROPERTY, 0 },
+	  { B_DIRECT_SPECIFIER, 0 }, "The window's frame rectangle." },
+	{ "View", { B_COUNT_PROPERTIES, B_CREATE_PROPERTY, 0 },
+	  { B_DIRECT_SPECIFIER, 0 }, "Count or create views." },
+	{ "View", { B_GET_PROPERTY, B_DELETE_PROPERTY, 0 },
+	  { B_INDEX_SPECIFIER, B_REVERSE_INDEX_SPECIFIER, B_NAME_SPECIFIER, 0 },
+	  "Get a view's name, or delete it." },
+	{ 0 }
+};
+
+static property_info view_props[] = {
+	{ "Name", { B_GET_PROPERTY, 0 }, { B_DIRECT_SPECIFIER, 0 },
+	  "The view's name." },
+	{ "Frame", { B_GET_PROPERTY, B_SET_PROPERTY, 0 },
+	  { B_DIRECT_SPECIFIER, 0 }, "The view's frame rectangle." },
+	{ "View", { B_COUNT_PROPERTIES, B_CREATE_PROPERTY, 0 },
+	  { B_DIRECT_SPECIFIER, 0 }, "Count or create views." },
+	{ "View", { B_GET_PROPERTY, B_DELETE_PROPERTY, 0 },
+	  { B_INDEX_SPECIFIER, B_REVERSE_INDEX_SPECIFIER, B_NAME_SPECIFIER, 0 },
+	  "Get a view's name, or delete it." },
+	{ 0 }
+};
+
+static const char *suite_names[] = {
+	"suite/vnd.ADS-standin-application",
+	"suite/vnd.ADS-standin-window",
+	"suite/vnd.ADS-standin-view"
+};
+
+static property_info *suite_props[] = { app_props, window_props, view_props };
+
+// ======================================================================
+// The looper
+// ======================================================================
+
+// A reply we're sitting on until it's due.
+struct pending_reply {
+	BMessage *request;
+	BMessage *reply;
+	bigtime_t due;
+};
+
+class StandInTarget : public BLooper {
+public:
+	StandInTarget( const standin_config &config );
+	virtual ~StandInTarget();
+
+	virtual BHandler *ResolveSpecifier( BMessage *msg, int32 index,
+	                                    BMessage *specifier, int32 form,
+	                                    const char *property );
+	virtual void MessageReceived( BMessage *msg );
+
+private:
+	void Answer( BMessage *msg, BMessage *reply );
+	bool Fits( size_t more ) const;
+	standin_node *Select( standin_node *node, const BMessage &spec );
+
+	static int32 replier( void *data );
+
+	standin_node *root;
+	size_t stored;			// node_size( root )
+	int32 max_data;
+	bigtime_t latency;
+	bigtime_t busy;
+
+	// Only used when there's a latency.
+	BLocker queue_lock;
+	BList queue;			// pending_reply *s, in order of due time
+	sem_id queued;
+	thread_id replier_thread;
+};
+
+// ----------------------------------------------------------------------
+StandInTarget::StandInTarget( const standin_config &config )
+	: BLooper( "hey stand-in" ),
+	  max_data( config.max_data ),
+	  latency( config.latency ),
+	  busy( config.busy ),
+	  queue_lock( "hey stand-in queue" ),
+	  queued( -1 ),
+	  replier_thread( -1 )
+{
+	root = new_node( "heymodule stand-in", BRect( 0.0, 0.0, 0.0, 0.0 ) );
+	for( int32 idx = 0; idx < config.windows; idx++ ) {
+		add_views( add_child( root, NODE_APP, NULL ), config.views,
+		           config.depth );
+	}
+	stored = node_size( root );
+
+	if( latency > 0 ) {
+		queued = create_sem( 0, "hey stand-in queued" );
+		replier_thread = spawn_thread( replier, "hey stand-in replier",
+		                               B_NORMAL_PRIORITY, this );
+		(void)resume_thread( replier_thread );
+	}
+}
+
+StandInTarget::~StandInTarget()
+{
+	if( replier_thread >= 0 ) {
+		// Deleting the semaphore tells the replier to give up.
+		delete_sem( queued );
+
+		status_t retval;
+		(void)wait_for_thread( replier_thread, &retval );
+
+		for( int32 idx = 0; idx < queue.CountItems(); idx++ ) {
+			pending_reply *pending = (pending_reply *)queue.ItemAt( idx );
+			delete pending->request;
+			delete pending->reply;
+			delete pending;
+		}
+	}
+
+	delete_node( root );
+}
+
+// ----------------------------------------------------------------------
+// Can we hold on to more bytes without going over max_data?
+bool StandInTarget::Fits( size_t more ) const
+{
+	return max_data < 0 || stored + more <= (size_t)max_data;
+}
+
+// ----------------------------------------------------------------------
+// Every request comes to us; MessageReceived() sorts out the specifiers.
+BHandler *StandInTarget::ResolveSpecifier( BMessage *msg, int32 index,
+                                           BMessage *specifier, int32 form,
+                                           const char *property )
+{
+	return this;
+}
+
+// ----------------------------------------------------------------------
+void StandInTarget::MessageReceived( BMessage *msg )
+{
+	switch( msg->what ) {
+	case B_GET_PROPERTY:
+	case B_SET_PROPERTY:
+	case B_COUNT_PROPERTIES:
+	case B_CREATE_PROPERTY:
+	case B_DELETE_PROPERTY:
+	case B_GET_SUPPORTED_SUITES:
+		break;
+
+	default:
+		BLooper::MessageReceived( msg );
+		return;
+	}
+
+	if( busy > 0 ) {
+		snooze( busy );
+	}
+
+	BMessage *reply;
+	try {
+		reply = new BMessage( B_REPLY );
+	} catch ( bad_alloc &ex ) {
+		return;
+	}
+
+	try {
+		Answer( msg, reply );
+	} catch ( bad_alloc &ex ) {
+		refuse( reply, B_NO_MEMORY, "out of memory" );
+	}
+
+	if( latency <= 0 ) {
+		(void)msg->SendReply( reply );
+		delete reply;
+		return;
+	}
+
+	// Everything is delayed by the same amount, so the queue is always in
+	// order of due time.
+	pending_reply *pending;
+	try {
+		pending = new pending_reply;
+	} catch ( bad_alloc &ex ) {
+		delete reply;
+		return;
+	}
+	pending->request = DetachCurrentMessage();
+	pending->reply = reply;
+	pending->due = system_time() + latency;
+
+	queue_lock.Lock();
+	queue.AddItem( pending );
+	queue_lock.Unlock();
+
+	(void)release_sem( queued );
+}
+
+int32 StandInTarget::replier( void *data )
+{
+	StandInTarget *target = (StandInTarget *)data;
+
+	while( acquire_sem( target->queued ) == B_OK ) {
+		target->queue_lock.Lock();
+		pending_reply *pending = (pending_reply *)target->queue.RemoveItem( (int32)0 );
+		target->queue_lock.Unlock();
+
+		if( pending == NULL ) continue;
+
+		(void)snooze_until( pending->due, B_SYSTEM_TIMEBASE );
+		(void)pending->request->SendReply( pending->reply );
+
+		delete pending->request;
+		delete pending->reply;
+		delete pending;
+	}
+
+	return B_OK;
+}
+
+// ----------------------------------------------------------------------
+// The child of node that spec picks out, or NULL.
+standin_node *StandInTarget::Select( standin_node *node, const BMessage &spec )
+{
+	int32 count = node->children.CountItems();
+	int32 index;
+
+	switch( spec.what ) {
+	case B_INDEX_SPECIFIER:
+		index = spec.FindInt32( "index" );
+		break;
+
+	case B_REVERSE_INDEX_SPECIFIER:
+		index = count - spec.FindInt32( "index" );
+		break;
+
+	case B_NAME_SPECIFIER:
+		{
+			const char *name = spec.FindString( "name" );
+			if( name == NULL ) return NULL;
+
+			for( index = 0; index < count; index++ ) {
+				standin_node *child = (standin_node *)node->children.ItemAt( index );
+				if( strcmp( child->name, name ) == 0 ) return child;
+			}
+		}
+		return NULL;
+
+	default:
+		return NULL;
+	}
+
+	return (standin_node *)node->children.ItemAt( index );
+}
+
+// ----------------------------------------------------------------------
+static void refuse( BMessage *reply, status_t error, const char *message )
+{
+	reply->MakeEmpty();
+	reply->what = B_MESSAGE_NOT_UNDERSTOOD;
+	reply->AddInt32( "error", error );
+	reply->AddString( "message", message );
+}
+
+void StandInTarget::Answer( BMessage *msg, BMessage *reply )
+{
+	int32 count = 0;
+	type_code type;
+	if( msg->GetInfo( "specifiers", &type, &count ) != B_OK ) {
+		count = 0;
+	}
+
+	// GetSuites is about the handler the specifiers lead to, so all of
+	// them pick out nodes; anything else leaves the innermost one for the
+	// property it's acting on.
+	bool suites = ( msg->what == B_GET_SUPPORTED_SUITES );
+	int32 last = suites ? 0 : 1;
+
+	standin_node *node = root;
+	int kind = NODE_APP;
+	int32 level;
+	for( level = count - 1; level >= last; level-- ) {
+		BMessage spec;
+		(void)msg->FindMessage( "specifiers", level, &spec );
+
+		const char *property = spec.FindString( "property" );
+		const char *wanted = ( kind == NODE_APP ) ? "Window" : "View";
+		if( property == NULL || strcmp( property, wanted ) != 0 ) {
+			refuse( reply, B_BAD_SCRIPT_SYNTAX, "no such property" );
+			return;
+		}
+
+		node = Select( node, spec );
+		if( node == NULL ) {
+			refuse( reply, B_BAD_INDEX, "no such item" );
+			return;
+		}
+		kind = ( kind == NODE_APP ) ? NODE_WINDOW : NODE_VIEW;
+	}
+
+	if( suites ) {
+		BPropertyInfo info( suite_props[kind] );
+		reply->AddString( "suites", suite_names[kind] );
+		reply->AddFlat( "messages", &info );
+		reply->AddInt32( "error", B_OK );
+		return;
+	}
+
+	if( count < 1 ) {
+		refuse( reply, B_BAD_SCRIPT_SYNTAX, "no property given" );
+		return;
+	}
+
+	BMessage spec;
+	(void)msg->FindMessage( "specifiers", 0, &spec );
+	const char *property = spec.FindString( "property" );
+	if( property == NULL ) property = "";
+
+	const char *children = ( kind == NODE_APP ) ? "Window" : "View";
+	if( strcmp( property, children ) == 0 ) {
+		if( spec.what == B_DIRECT_SPECIFIER ) {
+			if( msg->what == B_COUNT_PROPERTIES ) {
+				reply->AddInt32( "result", node->children.CountItems() );
+			} else if( msg->what == B_CREATE_PROPERTY ) {
+				const char *name = msg->FindString( "data" );
+				standin_node *child = add_child( node, kind, name );
+				size_t size = node_size( child );
+				if( !Fits( size ) ) {
+					(void)node->children.RemoveItem( child );
+					delete_node( child );
+					refuse( reply, B_NO_MEMORY, "the stand-in is full" );
+					return;
+				}
+				stored += size;
+			} else {
+				refuse( reply, B_BAD_SCRIPT_SYNTAX, "can't do that to a list" );
+				return;
+			}
+		} else {
+			standin_node *child = Select( node, spec );
+			if( child == NULL ) {
+				refuse( reply, B_BAD_INDEX, "no such item" );
+				return;
+			}
+
+			if( msg->what == B_GET_PROPERTY ) {
+				reply->AddString( "result", child->name );
+			} else if( msg->what == B_DELETE_PROPERTY ) {
+				(void)node->children.RemoveItem( child );
+				stored -= node_size( child );
+				delete_node( child );
+			} else {
+				refuse( reply, B_BAD_SCRIPT_SYNTAX, "can't do that to an item" );
+				return;
+			}
+		}
+	} else if( spec.what != B_DIRECT_SPECIFIER ) {
+		refuse( reply, B_BAD_SCRIPT_SYNTAX, "property isn't a list" );
+		return;
+	} else if( ( strcmp( property, "Title" ) == 0 && kind == NODE_WINDOW ) ||
+	           ( strcmp( property, "Name" ) == 0 && kind != NODE_WINDOW ) ) {
+		if( msg->what == B_GET_PROPERTY ) {
+			reply->AddString( "result", node->name );
+		} else if( msg->what == B_SET_PROPERTY && kind == NODE_WINDOW &&
+		           msg->HasString( "data" ) ) {
+			const char *name = msg->FindString( "data" );
+			size_t old_size = strlen( node->name );
+			size_t new_size = strlen( name );
+			if( new_size > old_size && !Fits( new_size - old_size ) ) {
+				refuse( reply, B_NO_MEMORY, "the stand-in is full" );
+				return;
+			}
+
+			char *copy = new char[new_size + 1];
+			strcpy( copy, name );
+			delete [] node->name;
+			node->name = copy;
+			stored = stored - old_size + new_size;
+		} else {
+			refuse( reply, B_BAD_SCRIPT_SYNTAX, "can't do that to a name" );
+			return;
+		}
+	} else if( strcmp( property, "Frame" ) == 0 && kind != NODE_APP ) {
+		if( msg->what == B_GET_PROPERTY ) {
+			reply->AddRect( "result", node->frame );
+		} else if( msg->what == B_SET_PROPERTY &&
+		           msg->FindRect( "data", &node->frame ) == B_OK ) {
+			// That's it.
+		} else {
+			refuse( reply, B_BAD_SCRIPT_SYNTAX, "can't do that to a frame" );
+			return;
+		}
+	} else {
+		refuse( reply, B_BAD_SCRIPT_SYNTAX, "no such property" );
+		return;
+	}
+
+	reply->AddInt32( "error", B_OK );
+}
+
+// ----------------------------------------------------------------------
+status_t start_standin( const standin_config &config, BMessenger *messenger )
+{
+	StandInTarget *target;
+	try {
+		target = new StandInTarget( config );
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+
+	// Loopers are born locked; Run() unlocks it.
+	(void)target->Run();
+	*messenger = BMessenger( target );
+
+	return B_OK;
+}
+
+// ======================================================================
+// Module function
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// StandIn( windows = 4, views = 4, depth = 2, latency = 0.0, busy = 0.0,
+//          max_data = 16 MB ): a Hey object for a new stand-in.  Times are
+// in seconds.
+PyObject *StandIn_New( PyObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { "windows", "views", "depth", "latency", "busy",
+	                          "max_data", NULL };
+	int windows = standin_defaults.windows;
+	int views = standin_defaults.views;
+	int depth = standin_defaults.depth;
+	double latency = 0.0;
+	double busy = 0.0;
+	int max_data = standin_defaults.max_data;
+	if( !PyArg_ParseTupleAndKeywords( args, kwds, "|iiiddi", kwlist,
+	                                  &windows, &views, &depth, &latency,
+	                                  &busy, &max_data ) ) {
+		return NULL;
+	}
+
+	if( windows < 0 || views < 0 || depth < 0 || latency < 0.0 || busy < 0.0 ) {
+		PyErr_SetString( PyExc_ValueError,
+				"sizes and times can't be negative" );
+		return NULL;
+	}
+
+	standin_config config;
+	config.windows = windows;
+	config.views = views;
+	config.depth = depth;
+	config.latency = (bigtime_t)( latency * 1000000.0 );
+	config.busy = (bigtime_t)( busy * 1000000.0 );
+	config.max_data = ( max_data < 0 ) ? -1 : max_data;
+
+	BMessenger messenger;
+	if( start_standin( config, &messenger ) != B_OK ) {
+		return PyErr_NoMemory();
+	}
+
+	return (PyObject *)newHeyObjectFromMessenger( messenger );
+}
@@ -0,0 +1,70 @@
+// StandIn
+//
+// The stand-in is used by heymodule's benchmarks and load tests as a
+// scriptable target living in this team: a looper that pretends to be an
+// application with windows, views inside them, and views inside those,
+// each with a Title or Name and a Frame.  Its size, how long it takes to
+// answer and how long it keeps its looper busy can all be set, so you
+// can measure heymodule without paying for a real application (or tell
+// the two apart).
+//
+// The tree looks like this (hey-style):
+//
+//     Name								"heymodule stand-in"
+//     Window [i]						Title, Frame ("Window i")
+//     View [j] of Window [i]			Name, Frame ("View j")
+//     View [k] of View [j] of ...		and so on, depth levels deep
+//
+// Windows and views can be counted, looked up by index, reverse index or
+// name, created and deleted; GetSuites works at every level, so
+// validation and property attributes work too.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_StandIn_H
+#define PyHey_StandIn_H
+
+#include "Python.h"
+
+#include <app/Messenger.h>
+#include <kernel/OS.h>
+
+struct standin_config {
+	int32 windows;			// windows in the application
+	int32 views;			// views in each window, and in each view
+	int32 depth;			// levels of views
+	bigtime_t latency;		// how long each reply takes to come back
+	bigtime_t busy;			// how long each request keeps the looper busy
+	int32 max_data;			// most bytes of names and items to hold, or -1
+};
+
+// The defaults: StandIn() with no arguments.
+extern const standin_config standin_defaults;
+
+// Start a stand-in; messenger gets its address.  Quit it (B_QUIT_REQUESTED
+// with no specifiers, or Hey.Quit()) when you're done.
+//
+// Replies are delayed by latency without holding up the looper, so any
+// number of requests can be waiting at once; busy is time the looper
+// spends on each request, so those pile up like they would in a slow
+// application.
+//
+// Names and items Set() or Create()d are kept until the stand-in quits;
+// once the tree takes up max_data bytes, requests that would make it
+// bigger get B_NO_MEMORY back.
+status_t start_standin( const standin_config &config, BMessenger *messenger );
+
+// Module function:
+//
+// StandIn( windows = 4, views = 4, depth = 2, latency = 0.0, busy = 0.0,
+//          max_data = 16 MB )
+PyObject *StandIn_New( PyObject *self, PyObject *args, PyObject *kwds );
+
+#endif
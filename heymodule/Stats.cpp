@@ -0,0 +1,500 @@
+// Stats
+//
+// The request statistics are used by heymodule to keep counters and
+// latency histograms for every request a Hey object sends.
+//
+// Every thread that sends requests gets its own block of counters (found
+// through thread-local storage), and it's the only one that ever writes
+// to them; Stats() adds all of the blocks up when you ask.  That means
+// recording a request is a handful of increments, with no locks and no
+// atomic operations.  The price is that Stats() can catch a thread in the
+// middle of counting a request, and ClearStats() can lose one that's
+// being counted; the numbers are for watching, not for billing.
+//
+// Blocks live until the team dies, so a thread's requests still count
+// after it's gone.  Targets are told apart by team and reported by
+// signature; after the first STATS_TARGETS - 1 teams, everybody else is
+// lumped together.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Stats.h"
+
+#include <app/AppDefs.h>
+#include <app/Message.h>
+#include <app/Roster.h>
+#include <support/Locker.h>
+#include <support/TLS.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+#define STATS_TARGETS	32
+
+// Everything we know about one command to one target.
+struct stats_cell {
+	uint32 requests;
+	uint32 outcomes[STATS_OUTCOMES];
+	int64 sent;					// bytes
+	int64 received;
+	bigtime_t round_trip_time;	// totals, for averages
+	bigtime_t convert_time;
+	uint32 round_trip[STATS_BUCKETS];
+	uint32 convert[STATS_BUCKETS];
+};
+
+struct stats_row {
+	stats_cell cells[STATS_COMMANDS];
+};
+
+// One thread's counters; a row is only allocated once the thread talks
+// to that target.
+struct stats_block {
+	stats_row *rows[STATS_TARGETS];
+	stats_block *next;
+};
+
+struct stats_target {
+	team_id team;
+	char signature[B_MIME_TYPE_LENGTH];
+};
+
+static const char *command_names[STATS_COMMANDS] = {
+	"Get", "Set", "Count", "Create", "Delete", "GetSuites", "Send", "Other"
+};
+
+// Only the errors get names; the rest are requests - errors.
+static const char *outcome_names[STATS_OUTCOMES] = {
+	NULL, NULL, "not understood", "error", "unknown", "timed out", "failed",
+	"rejected"
+};
+
+static BLocker stats_lock( "hey stats" );
+static stats_block *stats_blocks = NULL;		// protected by stats_lock
+static int32 stats_tls = tls_allocate();
+
+// Slots below target_count never change once they're filled in, so they
+// can be searched without the lock; the last slot is for everybody else.
+static stats_target stats_targets[STATS_TARGETS];
+static volatile int32 target_count = 0;
+
+// ======================================================================
+// Recording
+// ======================================================================
+
+// ----------------------------------------------------------------------
+int stats_command( const char *name )
+{
+	if( name == NULL ) return STATS_SEND;
+
+	for( int idx = 0; idx < STATS_OTHER; idx++ ) {
+		if( strcmp( name, command_names[idx] ) == 0 ) return idx;
+	}
+
+	return STATS_OTHER;
+}
+
+int stats_command_for( uint32 what )
+{
+	switch( what ) {
+	case B_GET_PROPERTY:			return STATS_GET;
+	case B_SET_PROPERTY:			return STATS_SET;
+	case B_COUNT_PROPERTIES:		return STATS_COUNT;
+	case B_CREATE_PROPERTY:			return STATS_CREATE;
+	case B_DELETE_PROPERTY:			return STATS_DELETE;
+	case B_GET_SUPPORTED_SUITES:	return STATS_GETSUITES;
+	default:						break;
+	}
+
+	return STATS_OTHER;
+}
+
+int stats_outcome( uint32 what )
+{
+	switch( what ) {
+	case B_REPLY:					return STATS_OK;
+	case B_NO_REPLY:				return STATS_NO_REPLY;
+	case B_MESSAGE_NOT_UNDERSTOOD:	return STATS_NOT_UNDERSTOOD;
+	case B_ERROR:					return STATS_ERROR;
+	default:						break;
+	}
+
+	return STATS_UNKNOWN;
+}
+
+// ----------------------------------------------------------------------
+static int bucket_for( bigtime_t usecs )
+{
+	int bucket = 0;
+	while( usecs > 1 && bucket < STATS_BUCKETS - 1 ) {
+		usecs >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+// ----------------------------------------------------------------------
+// Find (or make) team's slot.  Looking up a signature costs a trip to the
+// roster, so it's only done the first time we see a team.
+static int target_slot( team_id team )
+{
+	int32 count = target_count;
+	int32 idx;
+	for( idx = 0; idx < count; idx++ ) {
+		if( stats_targets[idx].team == team ) return idx;
+	}
+
+	if( !stats_lock.Lock() ) return STATS_TARGETS - 1;
+
+	for( idx = 0; idx < target_count; idx++ ) {
+		if( stats_targets[idx].team == team ) break;
+	}
+
+	if( idx == target_count ) {
+		if( target_count < STATS_TARGETS - 1 ) {
+			stats_target *target = &stats_targets[idx];
+			target->team = team;
+
+			app_info info;
+			if( be_roster && be_roster->GetRunningAppInfo( team, &info ) == B_OK &&
+				info.signature[0] != '\0' ) {
+				strcpy( target->signature, info.signature );
+			} else {
+				sprintf( target->signature, "team %ld", (long)team );
+			}
+
+			target_count = idx + 1;
+		} else {
+			idx = STATS_TARGETS - 1;
+			strcpy( stats_targets[idx].signature, "(other teams)" );
+		}
+	}
+
+	stats_lock.Unlock();
+	return idx;
+}
+
+// ----------------------------------------------------------------------
+// This thread's counters.
+static stats_block *this_block( void )
+{
+	stats_block *block = (stats_block *)tls_get( stats_tls );
+	if( block ) return block;
+
+	try {
+		block = new stats_block;
+	} catch ( bad_alloc &ex ) {
+		return NULL;
+	}
+	memset( block, 0, sizeof( stats_block ) );
+
+	if( !stats_lock.Lock() ) {
+		delete block;
+		return NULL;
+	}
+	block->next = stats_blocks;
+	stats_blocks = block;
+	stats_lock.Unlock();
+
+	tls_set( stats_tls, block );
+	return block;
+}
+
+// ----------------------------------------------------------------------
+// This thread's counters for command to team.
+static stats_cell *this_cell( team_id team, int command )
+{
+	stats_block *block = this_block();
+	if( block == NULL ) return NULL;
+
+	int slot = target_slot( team );
+	stats_row *row = block->rows[slot];
+	if( row == NULL ) {
+		try {
+			row = new stats_row;
+		} catch ( bad_alloc &ex ) {
+			return NULL;
+		}
+		memset( row, 0, sizeof( stats_row ) );
+		block->rows[slot] = row;
+	}
+
+	return &row->cells[command];
+}
+
+void stats_record( team_id team, int command, int outcome, ssize_t sent,
+                   ssize_t received, bigtime_t round_trip )
+{
+	stats_cell *cell = this_cell( team, command );
+	if( cell == NULL ) return;
+
+	cell->requests++;
+	cell->outcomes[outcome]++;
+	if( sent > 0 ) cell->sent += sent;
+	if( received > 0 ) cell->received += received;
+
+	if( round_trip >= 0 ) {
+		cell->round_trip_time += round_trip;
+		cell->round_trip[bucket_for( round_trip )]++;
+	}
+}
+
+void stats_exchange( team_id team, int command, ssize_t size,
+                     const BMessage *reply, status_t retval,
+                     bigtime_t round_trip )
+{
+	int outcome;
+	if( reply ) {
+		outcome = stats_outcome( reply->what );
+	} else if( retval == B_TIMED_OUT || retval == B_WOULD_BLOCK ) {
+		outcome = STATS_TIMED_OUT;
+	} else {
+		outcome = STATS_FAILED;
+	}
+
+	stats_record( team, command, outcome, size,
+	              reply ? reply->FlattenedSize() : 0, round_trip );
+}
+
+void stats_convert( team_id team, int command, bigtime_t convert )
+{
+	stats_cell *cell = this_cell( team, command );
+	if( cell == NULL ) return;
+
+	cell->convert_time += convert;
+	cell->convert[bucket_for( convert )]++;
+}
+
+// ======================================================================
+// Reading
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static void add_cell( stats_cell &to, const stats_cell &from )
+{
+	int idx;
+
+	to.requests += from.requests;
+	for( idx = 0; idx < STATS_OUTCOMES; idx++ ) {
+		to.outcomes[idx] += from.outcomes[idx];
+	}
+	to.sent += from.sent;
+	to.received += from.received;
+	to.round_trip_time += from.round_trip_time;
+	to.convert_time += from.convert_time;
+	for( idx = 0; idx < STATS_BUCKETS; idx++ ) {
+		to.round_trip[idx] += from.round_trip[idx];
+		to.convert[idx] += from.convert[idx];
+	}
+}
+
+static bool dict_set( PyObject *dict, const char *key, PyObject *value )
+{
+	if( value == NULL ) return false;
+
+	int err = PyDict_SetItemString( dict, (char *)key, value );
+	Py_DECREF( value );
+
+	return err == 0;
+}
+
+static PyObject *histogram( const uint32 *buckets )
+{
+	PyObject *list = PyList_New( STATS_BUCKETS );
+	if( list == NULL ) return NULL;
+
+	for( int idx = 0; idx < STATS_BUCKETS; idx++ ) {
+		PyObject *count = PyInt_FromLong( buckets[idx] );
+		if( count == NULL ) {
+			Py_DECREF( list );
+			return NULL;
+		}
+		PyList_SET_ITEM( list, idx, count );
+	}
+
+	return list;
+}
+
+// ----------------------------------------------------------------------
+static PyObject *cell_to_dict( const stats_cell &cell )
+{
+	PyObject *errors = PyDict_New();
+	if( errors == NULL ) return NULL;
+
+	for( int idx = STATS_NOT_UNDERSTOOD; idx < STATS_OUTCOMES; idx++ ) {
+		if( !dict_set( errors, outcome_names[idx],
+		               PyInt_FromLong( cell.outcomes[idx] ) ) ) {
+			Py_DECREF( errors );
+			return NULL;
+		}
+	}
+
+	PyObject *dict = PyDict_New();
+	if( dict == NULL ) {
+		Py_DECREF( errors );
+		return NULL;
+	}
+
+	if( !dict_set( dict, "errors", errors ) ||
+		!dict_set( dict, "requests", PyInt_FromLong( cell.requests ) ) ||
+		!dict_set( dict, "sent", PyLong_FromLongLong( cell.sent ) ) ||
+		!dict_set( dict, "received", PyLong_FromLongLong( cell.received ) ) ||
+		!dict_set( dict, "round_trip", histogram( cell.round_trip ) ) ||
+		!dict_set( dict, "conversion", histogram( cell.convert ) ) ||
+		!dict_set( dict, "round_trip_time",
+		           PyFloat_FromDouble( (double)cell.round_trip_time / 1000000.0 ) ) ||
+		!dict_set( dict, "conversion_time",
+		           PyFloat_FromDouble( (double)cell.convert_time / 1000000.0 ) ) ) {
+		Py_DECREF( dict );
+		return NULL;
+	}
+
+	return dict;
+}
+
+// ----------------------------------------------------------------------
+// A dictionary of command name -> counters, for the commands in row that
+// have been used.
+static PyObject *row_to_dict( const stats_row &row )
+{
+	PyObject *dict = PyDict_New();
+	if( dict == NULL ) return NULL;
+
+	for( int idx = 0; idx < STATS_COMMANDS; idx++ ) {
+		if( row.cells[idx].requests == 0 ) continue;
+
+		if( !dict_set( dict, command_names[idx],
+		               cell_to_dict( row.cells[idx] ) ) ) {
+			Py_DECREF( dict );
+			return NULL;
+		}
+	}
+
+	return dict;
+}
+
+// ======================================================================
+// Module functions
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Stats(): { "commands": { command: counters },
+//            "targets": { signature: { command: counters } } }
+PyObject *Stats_Info( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	stats_row *rows;
+	try {
+		rows = new stats_row[STATS_TARGETS];
+	} catch ( bad_alloc &ex ) {
+		return PyErr_NoMemory();
+	}
+	memset( rows, 0, sizeof( stats_row ) * STATS_TARGETS );
+
+	// The lock only keeps the list of blocks still; the threads that own
+	// them carry on counting.
+	int32 slot;
+	int cmd;
+	if( stats_lock.Lock() ) {
+		for( stats_block *block = stats_blocks; block; block = block->next ) {
+			for( slot = 0; slot < STATS_TARGETS; slot++ ) {
+				stats_row *row = block->rows[slot];
+				if( row == NULL ) continue;
+
+				for( cmd = 0; cmd < STATS_COMMANDS; cmd++ ) {
+					add_cell( rows[slot].cells[cmd], row->cells[cmd] );
+				}
+			}
+		}
+		stats_lock.Unlock();
+	}
+
+	// An application that was restarted has a new team but the same
+	// signature; fold those together.
+	int32 count = target_count;
+	for( slot = 1; slot < count; slot++ ) {
+		for( int32 first = 0; first < slot; first++ ) {
+			if( strcmp( stats_targets[first].signature,
+			            stats_targets[slot].signature ) == 0 ) {
+				for( cmd = 0; cmd < STATS_COMMANDS; cmd++ ) {
+					add_cell( rows[first].cells[cmd], rows[slot].cells[cmd] );
+				}
+				memset( &rows[slot], 0, sizeof( stats_row ) );
+				break;
+			}
+		}
+	}
+
+	stats_row totals;
+	memset( &totals, 0, sizeof( totals ) );
+
+	PyObject *targets = PyDict_New();
+	PyObject *result = NULL;
+	if( targets == NULL ) goto done;
+
+	for( slot = 0; slot < STATS_TARGETS; slot++ ) {
+		bool used = false;
+		for( cmd = 0; cmd < STATS_COMMANDS; cmd++ ) {
+			if( rows[slot].cells[cmd].requests == 0 ) continue;
+
+			add_cell( totals.cells[cmd], rows[slot].cells[cmd] );
+			used = true;
+		}
+		if( !used ) continue;
+
+		if( !dict_set( targets, stats_targets[slot].signature,
+		               row_to_dict( rows[slot] ) ) ) {
+			Py_DECREF( targets );
+			goto done;
+		}
+	}
+
+	result = PyDict_New();
+	if( result == NULL ) {
+		Py_DECREF( targets );
+		goto done;
+	}
+	if( !dict_set( result, "targets", targets ) ||
+		!dict_set( result, "commands", row_to_dict( totals ) ) ) {
+		Py_DECREF( result );
+		result = NULL;
+	}
+
+done:
+	delete [] rows;
+	return result;
+}
+
+// ----------------------------------------------------------------------
+// ClearStats(): start counting again from zero.
+PyObject *Stats_Clear( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	if( stats_lock.Lock() ) {
+		for( stats_block *block = stats_blocks; block; block = block->next ) {
+			for( int32 slot = 0; slot < STATS_TARGETS; slot++ ) {
+				if( block->rows[slot] ) {
+					memset( block->rows[slot], 0, sizeof( stats_row ) );
+				}
+			}
+		}
+		stats_lock.Unlock();
+	}
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
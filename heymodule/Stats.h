@@ -0,0 +1,95 @@
+// Stats
+//
+// The request statistics are used by heymodule to keep counters and
+// latency histograms for every request a Hey object sends, by command and
+// by target, cheaply enough to leave them on all the time.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Stats_H
+#define PyHey_Stats_H
+
+#include "Python.h"
+
+#include <kernel/OS.h>
+
+class BMessage;
+
+// What we count requests by.
+enum {
+	STATS_GET,
+	STATS_SET,
+	STATS_COUNT,
+	STATS_CREATE,
+	STATS_DELETE,
+	STATS_GETSUITES,
+	STATS_SEND,				// Send(), with your own message
+	STATS_OTHER,			// Quit(), Save() and Load()
+	STATS_COMMANDS
+};
+
+// How requests turned out; everything but the first two is an error.
+enum {
+	STATS_OK,				// B_REPLY
+	STATS_NO_REPLY,			// B_NO_REPLY
+	STATS_NOT_UNDERSTOOD,	// B_MESSAGE_NOT_UNDERSTOOD
+	STATS_ERROR,			// B_ERROR
+	STATS_UNKNOWN,			// some other reply
+	STATS_TIMED_OUT,		// not sent or not answered in time
+	STATS_FAILED,			// not sent or not answered
+	STATS_REJECTED,			// turned down by validation, never sent
+	STATS_OUTCOMES
+};
+
+// Latency histograms have this many buckets; bucket i counts times from
+// 2^i up to 2^(i+1) microseconds (bucket 0 starts at 0, and the last one
+// has no upper end).
+#define STATS_BUCKETS	24
+
+// The command for a Hey method name (NULL for Send()), the command for a
+// request's what (for senders that don't know the method), and the
+// outcome for a reply's what.
+int stats_command( const char *name );
+int stats_command_for( uint32 what );
+int stats_outcome( uint32 what );
+
+// Count a request to team.  Requests are counted where they're sent
+// (send_and_wait(), send_pipelined(), HeyConnection, Future objects and
+// Replay()), the same places they're recorded; validate_request() counts
+// the ones it turns down.
+//
+// sent and received are the flattened sizes of the request and reply, and
+// round_trip is the time spent waiting for the reply (-1 if the request
+// was never sent).
+//
+// Each thread counts into its own buckets, so this never waits for a
+// lock, and doesn't need the interpreter lock.
+void stats_record( team_id team, int command, int outcome, ssize_t sent,
+                   ssize_t received, bigtime_t round_trip );
+
+// Count a request of size bytes that was sent to team, and its reply
+// (NULL if there wasn't one; retval says why).  round_trip is the time
+// spent waiting.
+void stats_exchange( team_id team, int command, ssize_t size,
+                     const BMessage *reply, status_t retval,
+                     bigtime_t round_trip );
+
+// Count the time spent turning a counted request's reply into Python
+// objects.
+void stats_convert( team_id team, int command, bigtime_t convert );
+
+// Module functions:
+//
+// Stats()
+// ClearStats()
+PyObject *Stats_Info( PyObject *self, PyObject *args );
+PyObject *Stats_Clear( PyObject *self, PyObject *args );
+
+#endif
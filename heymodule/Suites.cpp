@@ -0,0 +1,797 @@
+// Suites
+//
+// The suite cache is used by heymodule to remember which scripting suites
+// an application's handlers support.
+//
+// Asking for the suites means a round trip to the application, then
+// unflattening a BPropertyInfo for every suite and turning it into
+// dictionaries; tools that poke around in applications do this
+// constantly, and the answer hardly ever changes.  So we keep the
+// converted suites, keyed by the application's signature and the
+// specifier that got us to the handler ("View 0 of Window 0"), along with
+// an index of ( property, command, specifier form ) -> suite for
+// find_support().
+//
+// Each entry remembers which team it came from; if the application has
+// quit (and maybe been started again) since then, the entry is thrown out
+// and we ask again.
+//
+// validate_request() uses the same suites to turn down requests the
+// target would only answer with B_MESSAGE_NOT_UNDERSTOOD.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Suites.h"
+#include "Stats.h"
+
+#include <app/PropertyInfo.h>
+#include <app/Roster.h>
+#include <string.h>
+#include <stdio.h>
+
+// How many slots a property_info has for commands and specifiers.
+#define INFO_SLOTS(a)	( sizeof( a ) / sizeof( a[0] ) )
+
+// ( signature, path ) -> ( team, suites, index ), plus the order the
+// entries went in, so the oldest can go when the cache is full.
+static PyObject *suite_cache = NULL;
+static PyObject *suite_cache_order = NULL;
+static int suite_cache_limit = 128;
+static long suite_cache_hits = 0;
+static long suite_cache_misses = 0;
+
+// team -> signature, so we don't have to ask the roster every time.
+static PyObject *signatures = NULL;
+
+// Validation counters: requests we've looked at, turned down, and let
+// through without being able to tell (no suites for some handler).
+static long checked_requests = 0;
+static long rejected_requests = 0;
+static long unchecked_requests = 0;
+
+// Command and specifier names, as GetSuites() shows them.
+static struct {
+	const char *name;
+	uint32 code;
+} command_names[] = {
+	{ "Get",		B_GET_PROPERTY },
+	{ "Set",		B_SET_PROPERTY },
+	{ "Create",		B_CREATE_PROPERTY },
+	{ "Delete",		B_DELETE_PROPERTY },
+	{ "Execute",	B_EXECUTE_PROPERTY },
+	{ "Count",		B_COUNT_PROPERTIES },
+	{ "GetSuites",	B_GET_SUPPORTED_SUITES },
+	{ NULL,			0 }
+}, form_names[] = {
+	{ "Direct",			B_DIRECT_SPECIFIER },
+	{ "Index",			B_INDEX_SPECIFIER },
+	{ "Reverse Index",	B_REVERSE_INDEX_SPECIFIER },
+	{ "Range",			B_RANGE_SPECIFIER },
+	{ "Reverse Range",	B_REVERSE_RANGE_SPECIFIER },
+	{ "Name",			B_NAME_SPECIFIER },
+	{ "ID",				B_ID_SPECIFIER },
+	{ NULL,				0 }
+};
+
+static bool init_cache( void );
+static PyObject *team_signature( team_id team );
+static PyObject *path_key( const BMessage *spec );
+static bool index_suite( PyObject *index, PyObject *suite,
+                         const BPropertyInfo &pi );
+static PyObject *fetch_entry( HeyObject *hey, team_id team,
+                              const BMessage *spec,
+                              bigtime_t send_timeout,
+                              bigtime_t reply_timeout,
+                              bool *refused = NULL );
+static PyObject *find_entry( HeyObject *hey, const BMessage *spec,
+                             bigtime_t send_timeout,
+                             bigtime_t reply_timeout,
+                             bool *refused = NULL );
+static void reject( const BMessage *path, const char *property,
+                    uint32 command, uint32 form );
+
+// ======================================================================
+// The cache
+// ======================================================================
+
+// ----------------------------------------------------------------------
+static bool init_cache( void )
+{
+	if( suite_cache ) return true;
+
+	suite_cache = PyDict_New();
+	suite_cache_order = PyList_New( 0 );
+	signatures = PyDict_New();
+	if( suite_cache == NULL || suite_cache_order == NULL || signatures == NULL ) {
+		Py_XDECREF( suite_cache );
+		Py_XDECREF( suite_cache_order );
+		Py_XDECREF( signatures );
+		suite_cache = NULL;
+		suite_cache_order = NULL;
+		signatures = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// A team's signature, as a (borrowed) Python string; NULL if the team
+// isn't an application we can find.
+static PyObject *team_signature( team_id team )
+{
+	PyObject *key = PyInt_FromLong( team );
+	if( key == NULL ) return NULL;
+
+	PyObject *sig = PyDict_GetItem( signatures, key );
+	if( sig == NULL ) {
+		app_info the_app_info;
+		if( be_roster->GetRunningAppInfo( team, &the_app_info ) != B_OK ) {
+			Py_DECREF( key );
+			PyErr_SetString( PyExc_RuntimeError, "target isn't running" );
+			return NULL;
+		}
+
+		sig = PyString_FromString( the_app_info.signature );
+		if( sig == NULL || PyDict_SetItem( signatures, key, sig ) != 0 ) {
+			Py_XDECREF( sig );
+			Py_DECREF( key );
+			return NULL;
+		}
+		Py_DECREF( sig );	// the dictionary has it
+	}
+
+	Py_DECREF( key );
+	return sig;
+}
+
+// ----------------------------------------------------------------------
+// Turn a specifier stack into a string, hey-style, for the cache key:
+// "View 0 of Window 0".  The application itself is "".
+static PyObject *path_key( const BMessage *spec )
+{
+	PyObject *path = PyString_FromString( "" );
+
+	BMessage item;
+	for( int32 idx = 0;
+		 path && spec && spec->FindMessage( "specifiers", idx, &item ) == B_OK;
+		 idx++ ) {
+		char buff[128];
+		const char *property = item.FindString( "property" );
+		const char *name;
+		int32 index = item.FindInt32( "index" );
+		int32 range = item.FindInt32( "range" );
+
+		switch( item.what ) {
+		case B_DIRECT_SPECIFIER:
+			sprintf( buff, "%.64s", property ? property : "" );
+			break;
+		case B_INDEX_SPECIFIER:
+			sprintf( buff, "%.64s %ld", property ? property : "", index );
+			break;
+		case B_REVERSE_INDEX_SPECIFIER:
+			sprintf( buff, "%.64s -%ld", property ? property : "", index );
+			break;
+		case B_RANGE_SPECIFIER:
+			sprintf( buff, "%.64s [%ld+%ld]", property ? property : "",
+					index, range );
+			break;
+		case B_REVERSE_RANGE_SPECIFIER:
+			sprintf( buff, "%.64s [-%ld+%ld]", property ? property : "",
+					index, range );
+			break;
+		case B_NAME_SPECIFIER:
+			name = item.FindString( "name" );
+			sprintf( buff, "%.64s \"%.48s\"", property ? property : "",
+					name ? name : "" );
+			break;
+		case B_ID_SPECIFIER:
+			sprintf( buff, "%.64s #%ld", property ? property : "",
+					item.FindInt32( "id" ) );
+			break;
+		default:
+			sprintf( buff, "%.64s ?%lx", property ? property : "",
+					item.what );
+			break;
+		}
+
+		if( idx > 0 ) {
+			PyString_ConcatAndDel( &path, PyString_FromString( " of " ) );
+		}
+		if( path ) {
+			PyString_ConcatAndDel( &path, PyString_FromString( buff ) );
+		}
+	}
+
+	return path;
+}
+
+// ----------------------------------------------------------------------
+// File everything in one suite's property_info under ( property,
+// command, form ), and under the property's name.  A property with no
+// commands takes any command, and one with no specifiers takes any form;
+// those go in under 0.  If two suites claim the same thing, the first
+// one wins.
+static bool index_suite( PyObject *index, PyObject *suite,
+                         const BPropertyInfo &pi )
+{
+	int32 count = pi.CountProperties();
+	const property_info *props = pi.Properties();
+	for( int32 i = 0; i < count; i++ ) {
+		const property_info &prop = props[i];
+
+		// The name on its own, for loose validation.
+		if( PyDict_GetItemString( index, prop.name ? prop.name : "" ) == NULL &&
+			PyDict_SetItemString( index, prop.name ? prop.name : "", suite ) != 0 ) {
+			return false;
+		}
+
+		for( unsigned int c = 0; c < INFO_SLOTS( prop.commands ); c++ ) {
+			uint32 command = prop.commands[c];
+			if( command == 0 && c > 0 ) break;
+
+			for( unsigned int s = 0; s < INFO_SLOTS( prop.specifiers ); s++ ) {
+				uint32 form = prop.specifiers[s];
+				if( form == 0 && s > 0 ) break;
+
+				PyObject *key = Py_BuildValue( "(sll)",
+							prop.name ? prop.name : "",
+							(long)command, (long)form );
+				if( key == NULL ) return false;
+
+				if( PyDict_GetItem( index, key ) == NULL &&
+					PyDict_SetItem( index, key, suite ) != 0 ) {
+					Py_DECREF( key );
+					return false;
+				}
+				Py_DECREF( key );
+
+				if( form == 0 ) break;
+			}
+
+			if( command == 0 ) break;
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Ask the target for the suites, and build a cache entry out of them.  If
+// the target answers, but not with suites, *refused is set (if refused
+// isn't NULL) as well as the exception.
+static PyObject *fetch_entry( HeyObject *hey, team_id team,
+                              const BMessage *spec,
+                              bigtime_t send_timeout,
+                              bigtime_t reply_timeout, bool *refused )
+{
+	if( refused ) *refused = false;
+
+	BMessage request;
+	if( spec ) {
+		request = *spec;
+		if( request.HasData( "data", B_ANY_TYPE ) ) {
+			(void)request.RemoveName( "data" );
+		}
+	}
+	request.what = B_GET_SUPPORTED_SUITES;
+
+	BMessage reply;
+	if( !send_and_wait( hey, &request, &reply, send_timeout, reply_timeout,
+	                    "GetSuites" ) ) {
+		return NULL;
+	}
+
+	if( reply.what != B_REPLY ) {
+		if( refused ) *refused = true;
+
+		PyObject *obj = explain_reply( reply );
+		if( obj ) {
+			Py_DECREF( obj );
+			PyErr_SetString( PyExc_RuntimeError, "unknown reply type" );
+		}
+		return NULL;
+	}
+
+	PyObject *suites = PyDict_New();
+	PyObject *index = PyDict_New();
+	if( suites == NULL || index == NULL ) {
+		Py_XDECREF( suites );
+		Py_XDECREF( index );
+		return NULL;
+	}
+
+	int32 num_suites = count_message_items( reply, "suites" );
+	for( int32 i = 0; i < num_suites; i++ ) {
+		PyObject *key = PyString_FromString( (char *)reply.FindString( "suites", i ) );
+
+		const void *data;
+		ssize_t size;
+		BPropertyInfo pi;
+		if( reply.FindData( "messages", B_PROPERTY_INFO_TYPE, i, &data, &size ) == B_OK ) {
+			(void)pi.Unflatten( B_PROPERTY_INFO_TYPE, data, size );
+		}
+
+		PyObject *value = key ? build_property_info_dict( pi ) : NULL;
+		if( value == NULL ||
+			PyDict_SetItem( suites, key, value ) != 0 ||
+			!index_suite( index, key, pi ) ) {
+			Py_XDECREF( key );
+			Py_XDECREF( value );
+			Py_DECREF( suites );
+			Py_DECREF( index );
+			return NULL;
+		}
+
+		Py_DECREF( key );
+		Py_DECREF( value );
+	}
+
+	PyObject *entry = Py_BuildValue( "(lOO)", (long)team, suites, index );
+	Py_DECREF( suites );
+	Py_DECREF( index );
+
+	return entry;
+}
+
+// ----------------------------------------------------------------------
+// Find the cache entry for the handler at spec, fetching it if we have
+// to.  Returns a new reference.
+static PyObject *find_entry( HeyObject *hey, const BMessage *spec,
+                             bigtime_t send_timeout,
+                             bigtime_t reply_timeout, bool *refused )
+{
+	if( refused ) *refused = false;
+
+	if( !init_cache() ) {
+		return PyErr_NoMemory();
+	}
+
+	team_id team = hey_team( hey );
+	PyObject *sig = team_signature( team );
+	if( sig == NULL ) {
+		return NULL;
+	}
+
+	PyObject *path = path_key( spec );
+	if( path == NULL ) {
+		return NULL;
+	}
+
+	PyObject *key = Py_BuildValue( "(OO)", sig, path );
+	Py_DECREF( path );
+	if( key == NULL ) {
+		return NULL;
+	}
+
+	PyObject *entry = PyDict_GetItem( suite_cache, key );
+	if( entry && PyInt_AsLong( PyTuple_GetItem( entry, 0 ) ) == team ) {
+		suite_cache_hits++;
+		Py_DECREF( key );
+		Py_INCREF( entry );
+		return entry;
+	}
+
+	// Not there, or it's from a team that's gone.
+	suite_cache_misses++;
+	entry = fetch_entry( hey, team, spec, send_timeout, reply_timeout,
+	                     refused );
+	if( entry == NULL ) {
+		Py_DECREF( key );
+		return NULL;
+	}
+
+	if( suite_cache_limit > 0 ) {
+		if( PyDict_GetItem( suite_cache, key ) == NULL ) {
+			while( PyList_Size( suite_cache_order ) >= suite_cache_limit ) {
+				PyObject *oldest = PyList_GetItem( suite_cache_order, 0 );
+				(void)PyDict_DelItem( suite_cache, oldest );
+				(void)PyList_SetSlice( suite_cache_order, 0, 1, NULL );
+			}
+			(void)PyList_Append( suite_cache_order, key );
+		}
+
+		// Caching is only an optimization; don't let it cause trouble.
+		(void)PyDict_SetItem( suite_cache, key, entry );
+		PyErr_Clear();
+	}
+
+	Py_DECREF( key );
+	return entry;
+}
+
+// ----------------------------------------------------------------------
+PyObject *get_suites( HeyObject *hey, const BMessage *spec,
+                      bigtime_t send_timeout, bigtime_t reply_timeout )
+{
+	PyObject *entry = find_entry( hey, spec, send_timeout, reply_timeout );
+	if( entry == NULL ) {
+		return NULL;
+	}
+
+	// The cached dictionaries are ours, so hand out copies: a new suite
+	// dictionary, new property dictionaries, new lists.  The tuples
+	// inside can't be changed, so they're shared.
+	PyObject *cached = PyTuple_GetItem( entry, 1 );
+	PyObject *suites = PyDict_New();
+
+	int pos = 0;
+	PyObject *name;
+	PyObject *props;
+	while( suites && PyDict_Next( cached, &pos, &name, &props ) ) {
+		PyObject *copy = PyDict_New();
+
+		int prop_pos = 0;
+		PyObject *prop;
+		PyObject *list;
+		while( copy && PyDict_Next( props, &prop_pos, &prop, &list ) ) {
+			PyObject *list_copy = PyList_GetSlice( list, 0, PyList_Size( list ) );
+			if( list_copy == NULL || PyDict_SetItem( copy, prop, list_copy ) != 0 ) {
+				Py_DECREF( copy );
+				copy = NULL;
+			}
+			Py_XDECREF( list_copy );
+		}
+
+		if( copy == NULL || PyDict_SetItem( suites, name, copy ) != 0 ) {
+			Py_DECREF( suites );
+			suites = NULL;
+		}
+		Py_XDECREF( copy );
+	}
+
+	Py_DECREF( entry );
+	return suites;
+}
+
+// ----------------------------------------------------------------------
+PyObject *find_support( HeyObject *hey, const BMessage *spec,
+                        const char *property, uint32 command, uint32 form,
+                        bigtime_t send_timeout, bigtime_t reply_timeout )
+{
+	PyObject *entry = find_entry( hey, spec, send_timeout, reply_timeout );
+	if( entry == NULL ) {
+		return NULL;
+	}
+
+	// Exact match first, then the properties that take any command, any
+	// form, or anything at all.
+	PyObject *index = PyTuple_GetItem( entry, 2 );
+	PyObject *suite = NULL;
+	uint32 commands[] = { command, 0, command, 0 };
+	uint32 forms[] = { form, form, 0, 0 };
+	for( int i = 0; suite == NULL && i < 4; i++ ) {
+		PyObject *key = Py_BuildValue( "(sll)", (char *)property,
+					(long)commands[i], (long)forms[i] );
+		if( key == NULL ) {
+			Py_DECREF( entry );
+			return NULL;
+		}
+		suite = PyDict_GetItem( index, key );
+		Py_DECREF( key );
+	}
+
+	if( suite == NULL ) suite = Py_None;
+	Py_INCREF( suite );
+	Py_DECREF( entry );
+
+	return suite;
+}
+
+
+// ----------------------------------------------------------------------
+PyObject *find_property( HeyObject *hey, const BMessage *spec,
+                         const char *property, bigtime_t send_timeout,
+                         bigtime_t reply_timeout, bool *refused )
+{
+	PyObject *entry = find_entry( hey, spec, send_timeout, reply_timeout,
+	                              refused );
+	if( entry == NULL ) {
+		return NULL;
+	}
+
+	PyObject *suite = PyDict_GetItemString( PyTuple_GetItem( entry, 2 ),
+	                                        (char *)property );
+	if( suite == NULL ) suite = Py_None;
+	Py_INCREF( suite );
+	Py_DECREF( entry );
+
+	return suite;
+}
+
+// ======================================================================
+// Validation
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Raise UnsupportedError for a request we won't send.  The value looks
+// like the one explain_reply() makes for B_MESSAGE_NOT_UNDERSTOOD, so
+// code that picks those apart still works.
+static void reject( const BMessage *path, const char *property,
+                    uint32 command, uint32 form )
+{
+	rejected_requests++;
+
+	const char *command_name = NULL;
+	const char *form_name = NULL;
+	for( int i = 0; command_names[i].name; i++ ) {
+		if( command_names[i].code == command ) command_name = command_names[i].name;
+	}
+	for( int i = 0; form_names[i].name; i++ ) {
+		if( form_names[i].code == form ) form_name = form_names[i].name;
+	}
+
+	PyObject *where = path_key( path );
+	char buff[256];
+	sprintf( buff, "no suite supports %.16s%s%.64s (%.16s) of %.100s",
+			command_name ? command_name : "",
+			command_name ? " " : "",
+			property,
+			form_name ? form_name : "?",
+			( where && PyString_Size( where ) > 0 ) ?
+				PyString_AsString( where ) : "the application" );
+	Py_XDECREF( where );
+
+	PyObject *ex = Py_BuildValue( "(isss)", (int)B_BAD_SCRIPT_SYNTAX,
+				strerror( B_BAD_SCRIPT_SYNTAX ), "not supported", buff );
+	if( ex ) {
+		PyErr_SetObject( HeyUnsupportedError, ex );
+		Py_DECREF( ex );
+	}
+}
+
+// ----------------------------------------------------------------------
+// Requests turned down here never reach the target, so this is the only
+// place they're counted.
+static void count_rejection( HeyObject *hey, const BMessage *request )
+{
+	stats_record( hey_team( hey ), stats_command_for( request->what ),
+	              STATS_REJECTED, request->FlattenedSize(), 0, -1 );
+}
+
+// ----------------------------------------------------------------------
+// Walk the specifier stack the way the target will: the application
+// resolves the last specifier, the handler that gets resolves the one
+// before it, and so on down to the handler that does the command.  Every
+// handler along the way has to know the property it's given; the ones in
+// the middle have to take it with any command (that's how
+// BPropertyInfo::FindMatch() decides whether to pass the request along).
+bool validate_request( HeyObject *hey, const BMessage *request, int mode,
+                       bigtime_t send_timeout, bigtime_t reply_timeout )
+{
+	if( mode <= 0 ) return true;
+
+	int32 levels = count_message_items( *request, "specifiers" );
+	if( levels == 0 ) return true;
+
+	checked_requests++;
+
+	BMessage item;
+	for( int32 level = levels - 1; level >= 0; level-- ) {
+		if( request->FindMessage( "specifiers", level, &item ) != B_OK ) break;
+
+		const char *property = item.FindString( "property" );
+		if( property == NULL ) {
+			unchecked_requests++;
+			return true;
+		}
+
+		// The handler we're asking is whatever the rest of the stack
+		// points at.
+		BMessage path;
+		BMessage outer;
+		for( int32 idx = level + 1; idx < levels; idx++ ) {
+			if( request->FindMessage( "specifiers", idx, &outer ) == B_OK ) {
+				path.AddSpecifier( &outer );
+			}
+		}
+
+		// GetSuites goes to the handler at the end of the stack, so it's
+		// passed along at every level.
+		uint32 command = 0;
+		if( level == 0 && request->what != B_GET_SUPPORTED_SUITES ) {
+			command = request->what;
+		}
+
+		const BMessage *handler = ( level + 1 < levels ) ? &path : NULL;
+		PyObject *suite;
+		if( mode >= VALIDATE_STRICT ) {
+			suite = find_support( hey, handler, property, command, item.what,
+			                      send_timeout, reply_timeout );
+		} else {
+			suite = find_property( hey, handler, property,
+			                       send_timeout, reply_timeout );
+		}
+
+		if( suite == NULL ) {
+			// No suites for this handler.  Strict mode won't send what it
+			// can't check; otherwise, let the target decide.
+			if( mode >= VALIDATE_STRICT ) {
+				rejected_requests++;
+				count_rejection( hey, request );
+				return false;
+			}
+
+			PyErr_Clear();
+			unchecked_requests++;
+			return true;
+		}
+
+		bool supported = ( suite != Py_None );
+		Py_DECREF( suite );
+
+		if( !supported ) {
+			reject( handler, property, command, item.what );
+			count_rejection( hey, request );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Commands and forms can be given by name or number.
+static bool code_from_python( PyObject *obj, uint32 *code,
+                              const char *what, bool four_chars )
+{
+	if( PyInt_Check( obj ) ) {
+		*code = (uint32)PyInt_AsLong( obj );
+		return true;
+	}
+
+	if( PyString_Check( obj ) ) {
+		const char *str = PyString_AsString( obj );
+		for( int i = 0; ; i++ ) {
+			const char *name = four_chars ? command_names[i].name : form_names[i].name;
+			if( name == NULL ) break;
+			if( strcmp( name, str ) == 0 ) {
+				*code = four_chars ? command_names[i].code : form_names[i].code;
+				return true;
+			}
+		}
+
+		// Anything else that looks like a 'what' code is a command.
+		if( four_chars && strlen( str ) == 4 ) {
+			*code = (((uint32)str[0]) << 24 ) +
+			        (((uint32)str[1]) << 16 ) +
+			        (((uint32)str[2]) <<  8 ) +
+			        ((uint32)str[3]);
+			return true;
+		}
+	}
+
+	char buff[64];
+	sprintf( buff, "invalid %s", what );
+	PyErr_SetString( PyExc_ValueError, buff );
+	return false;
+}
+
+bool command_from_python( PyObject *obj, uint32 *command )
+{
+	return code_from_python( obj, command, "command", true );
+}
+
+bool form_from_python( PyObject *obj, uint32 *form )
+{
+	return code_from_python( obj, form, "specifier form", false );
+}
+
+// ----------------------------------------------------------------------
+void forget_suites( team_id team )
+{
+	if( suite_cache == NULL ) return;
+
+	PyObject *key = PyInt_FromLong( team );
+	if( key && PyDict_GetItem( signatures, key ) ) {
+		(void)PyDict_DelItem( signatures, key );
+	}
+	Py_XDECREF( key );
+
+	for( int idx = PyList_Size( suite_cache_order ) - 1; idx >= 0; idx-- ) {
+		PyObject *cache_key = PyList_GetItem( suite_cache_order, idx );
+		PyObject *entry = PyDict_GetItem( suite_cache, cache_key );
+		if( entry == NULL ||
+			PyInt_AsLong( PyTuple_GetItem( entry, 0 ) ) == team ) {
+			(void)PyDict_DelItem( suite_cache, cache_key );
+			(void)PyList_SetSlice( suite_cache_order, idx, idx + 1, NULL );
+		}
+	}
+
+	PyErr_Clear();
+}
+
+// ----------------------------------------------------------------------
+// Module functions for the suite cache.
+PyObject *Suites_CacheInfo( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	int size = suite_cache ? PyDict_Size( suite_cache ) : 0;
+
+	return Py_BuildValue( "{s:l,s:l,s:i,s:i}",
+				"hits", suite_cache_hits,
+				"misses", suite_cache_misses,
+				"size", size,
+				"limit", suite_cache_limit );
+}
+
+PyObject *Suites_SetCacheSize( PyObject *self, PyObject *args )
+{
+	int limit;
+	if( !PyArg_ParseTuple( args, "i", &limit ) ) {
+		return NULL;
+	}
+	if( limit < 0 ) {
+		PyErr_SetString( PyExc_ValueError, "cache size must not be negative" );
+		return NULL;
+	}
+
+	suite_cache_limit = limit;
+
+	// Trim the cache down to size right away.
+	while( suite_cache_order && PyList_Size( suite_cache_order ) > suite_cache_limit ) {
+		PyObject *oldest = PyList_GetItem( suite_cache_order, 0 );
+		(void)PyDict_DelItem( suite_cache, oldest );
+		(void)PyList_SetSlice( suite_cache_order, 0, 1, NULL );
+	}
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+PyObject *Suites_ClearCache( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	if( suite_cache ) {
+		PyDict_Clear( suite_cache );
+		PyDict_Clear( signatures );
+		(void)PyList_SetSlice( suite_cache_order, 0,
+					PyList_Size( suite_cache_order ), NULL );
+	}
+	suite_cache_hits = 0;
+	suite_cache_misses = 0;
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+// ----------------------------------------------------------------------
+// Module functions for the validation counters.
+PyObject *Suites_ValidationInfo( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	return Py_BuildValue( "{s:l,s:l,s:l}",
+				"checked", checked_requests,
+				"rejected", rejected_requests,
+				"unchecked", unchecked_requests );
+}
+
+PyObject *Suites_ClearValidationInfo( PyObject *self, PyObject *args )
+{
+	if( !PyArg_ParseTuple( args, "" ) ) {
+		return NULL;
+	}
+
+	checked_requests = 0;
+	rejected_requests = 0;
+	unchecked_requests = 0;
+
+	Py_INCREF( Py_None );
+	return Py_None;
+}
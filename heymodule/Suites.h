@@ -0,0 +1,82 @@
+// Suites
+//
+// The suite cache is used by heymodule to remember which scripting suites
+// (and so which properties, commands and specifiers) an application's
+// handlers support, so GetSuites() doesn't have to ask every time.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Suites_H
+#define PyHey_Suites_H
+
+#include "Python.h"
+
+#include "Hey.h"
+
+#include <app/Message.h>
+#include <kernel/OS.h>
+
+// Return the suites of the handler spec points at in hey's target (NULL
+// for the application itself), asking the target only if they aren't in
+// the cache.  You get a new dictionary, like the one GetSuites() returns;
+// it's yours to change.
+PyObject *get_suites( HeyObject *hey, const BMessage *spec,
+                      bigtime_t send_timeout, bigtime_t reply_timeout );
+
+// Which suite lets the handler at spec take command with a form
+// specifier for property?  Returns a new reference to the suite's name,
+// or to None if nobody supports it; NULL (with an exception) if we
+// couldn't get the suites.
+PyObject *find_support( HeyObject *hey, const BMessage *spec,
+                        const char *property, uint32 command, uint32 form,
+                        bigtime_t send_timeout, bigtime_t reply_timeout );
+
+// Does any suite of the handler at spec mention property at all?  Same
+// results as find_support(); if it returns NULL because the target
+// answered without any suites (as opposed to not answering), *refused is
+// set.
+PyObject *find_property( HeyObject *hey, const BMessage *spec,
+                         const char *property, bigtime_t send_timeout,
+                         bigtime_t reply_timeout, bool *refused = NULL );
+
+// Convert a command ("Get", "Count"... or a number) or a specifier form
+// ("Direct", "Index"... or a number) from Python.  Returns false and sets
+// an exception if it isn't one.
+bool command_from_python( PyObject *obj, uint32 *command );
+bool form_from_python( PyObject *obj, uint32 *form );
+
+// Validation modes: VALIDATE_LOOSE turns down requests for properties
+// the handler's suites don't mention at all; VALIDATE_STRICT wants every
+// property, command and specifier form in the stack to be listed, and
+// won't send anything it can't check.
+#define VALIDATE_OFF	0
+#define VALIDATE_LOOSE	1
+#define VALIDATE_STRICT	2
+
+// Check request against the suites of every handler it'll pass through
+// before it's sent.  Returns false and sets an exception (UnsupportedError
+// if the target would've said no) if it shouldn't be sent.
+bool validate_request( HeyObject *hey, const BMessage *request, int mode,
+                       bigtime_t send_timeout, bigtime_t reply_timeout );
+
+// Throw out everything we know about a team's suites; the team index
+// calls this when an application quits.
+void forget_suites( team_id team );
+
+// Module functions for the suite cache.
+PyObject *Suites_CacheInfo( PyObject *self, PyObject *args );
+PyObject *Suites_SetCacheSize( PyObject *self, PyObject *args );
+PyObject *Suites_ClearCache( PyObject *self, PyObject *args );
+
+// Module functions for the validation counters.
+PyObject *Suites_ValidationInfo( PyObject *self, PyObject *args );
+PyObject *Suites_ClearValidationInfo( PyObject *self, PyObject *args );
+
+#endif
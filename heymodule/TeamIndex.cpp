@@ -0,0 +1,297 @@
+// TeamIndex
+//
+// The TeamIndex is used by heymodule to turn the name you hand to the
+// Hey constructor (a signature or a thread name) into a team without
+// walking the whole roster every time.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Python.h"
+
+#include "TeamIndex.h"
+#include "ReplyHandler.h"
+#include "Suites.h"
+
+#include <app/Handler.h>
+#include <app/Messenger.h>
+#include <app/Roster.h>
+#include <support/List.h>
+#include <support/Locker.h>
+#include <new>
+
+// ----------------------------------------------------------------------
+// The index itself: name (signature or thread name) -> team id, and
+// team id -> list of the names we filed under it, so we can take them
+// out again when the team quits.  If two teams share a name, the first
+// one we saw wins, same as the old roster walk.
+static PyObject *teams_by_name = NULL;
+static PyObject *names_by_team = NULL;
+
+// Set once the roster has agreed to tell us about launches and quits;
+// until then the index can't be trusted, so it's rebuilt for each lookup.
+static bool watching = false;
+
+// Teams that have launched or quit since the last lookup.  These are
+// filled in by the watcher in the reply looper's thread, which mustn't
+// touch Python objects, so they're applied the next time someone asks.
+static BLocker pending_lock( "hey team index" );
+static BList launched_teams;
+static BList quit_teams;
+
+// ======================================================================
+// TeamWatcher
+// ======================================================================
+
+class TeamWatcher : public BHandler {
+public:
+	TeamWatcher( void ) : BHandler( "hey team watcher" ) {}
+
+	virtual void MessageReceived( BMessage *msg );
+};
+
+void TeamWatcher::MessageReceived( BMessage *msg )
+{
+	team_id team;
+
+	switch( msg->what ) {
+	case B_SOME_APP_LAUNCHED:
+	case B_SOME_APP_QUIT:
+		if( msg->FindInt32( "be:team", &team ) != B_OK ) break;
+
+		if( pending_lock.Lock() ) {
+			if( msg->what == B_SOME_APP_LAUNCHED ) {
+				launched_teams.AddItem( (void *)team );
+			} else {
+				quit_teams.AddItem( (void *)team );
+			}
+			pending_lock.Unlock();
+		}
+		break;
+
+	default:
+		BHandler::MessageReceived( msg );
+		break;
+	}
+}
+
+// ----------------------------------------------------------------------
+// Ask the roster to keep us posted.
+static void start_watching( void )
+{
+	BLooper *looper = reply_looper();
+	if( looper == NULL ) return;
+
+	TeamWatcher *watcher;
+	try {
+		watcher = new TeamWatcher;
+	} catch ( bad_alloc &ex ) {
+		return;
+	}
+
+	if( !looper->Lock() ) {
+		delete watcher;
+		return;
+	}
+	looper->AddHandler( watcher );
+	looper->Unlock();
+
+	if( be_roster->StartWatching( BMessenger( watcher ),
+			B_REQUEST_LAUNCHED | B_REQUEST_QUIT ) == B_OK ) {
+		watching = true;
+	} else {
+		if( looper->Lock() ) {
+			looper->RemoveHandler( watcher );
+			looper->Unlock();
+		}
+		delete watcher;
+	}
+}
+
+// ======================================================================
+// The index
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// File name under team, unless somebody already has it.
+static void add_name( PyObject *names, PyObject *team, const char *name )
+{
+	if( name == NULL || name[0] == '\0' ) return;
+	if( PyDict_GetItemString( teams_by_name, (char *)name ) != NULL ) return;
+
+	PyObject *key = PyString_FromString( (char *)name );
+	if( key == NULL ) {
+		PyErr_Clear();
+		return;
+	}
+
+	if( PyDict_SetItem( teams_by_name, key, team ) == 0 ) {
+		(void)PyList_Append( names, key );
+	}
+	Py_DECREF( key );
+	PyErr_Clear();
+}
+
+// ----------------------------------------------------------------------
+// Add a running team's signature and thread names to the index.
+static void index_team( team_id the_team_id )
+{
+	app_info the_app_info;
+	if( be_roster->GetRunningAppInfo( the_team_id, &the_app_info ) != B_OK ) {
+		return;		// already gone, or not an application
+	}
+
+	PyObject *team = PyInt_FromLong( the_team_id );
+	if( team != NULL && PyDict_GetItem( names_by_team, team ) != NULL ) {
+		Py_DECREF( team );
+		return;		// already got this one
+	}
+
+	PyObject *names = PyList_New( 0 );
+	if( team == NULL || names == NULL ) {
+		Py_XDECREF( team );
+		Py_XDECREF( names );
+		PyErr_Clear();
+		return;
+	}
+
+	add_name( names, team, the_app_info.signature );
+
+	thread_info the_thread_info;
+	int32 cookie = 0L;
+	while( get_next_thread_info( the_team_id, &cookie, &the_thread_info ) == B_OK ) {
+		add_name( names, team, the_thread_info.name );
+	}
+
+	(void)PyDict_SetItem( names_by_team, team, names );
+	Py_DECREF( team );
+	Py_DECREF( names );
+	PyErr_Clear();
+}
+
+// ----------------------------------------------------------------------
+// Take a team's names out of the index (and its suites out of the suite
+// cache).
+static void forget_team( team_id the_team_id )
+{
+	forget_suites( the_team_id );
+
+	PyObject *team = PyInt_FromLong( the_team_id );
+	if( team == NULL ) {
+		PyErr_Clear();
+		return;
+	}
+
+	PyObject *names = PyDict_GetItem( names_by_team, team );
+	if( names != NULL ) {
+		for( int idx = 0; idx < PyList_Size( names ); idx++ ) {
+			PyObject *name = PyList_GetItem( names, idx );
+			PyObject *owner = PyDict_GetItem( teams_by_name, name );
+			if( owner != NULL && PyInt_AsLong( owner ) == the_team_id ) {
+				(void)PyDict_DelItem( teams_by_name, name );
+			}
+		}
+
+		(void)PyDict_DelItem( names_by_team, team );
+	}
+
+	Py_DECREF( team );
+	PyErr_Clear();
+}
+
+// ----------------------------------------------------------------------
+// Throw the index away and walk the roster from scratch.
+static void rebuild_index( void )
+{
+	PyDict_Clear( teams_by_name );
+	PyDict_Clear( names_by_team );
+
+	if( pending_lock.Lock() ) {
+		launched_teams.MakeEmpty();
+		quit_teams.MakeEmpty();
+		pending_lock.Unlock();
+	}
+
+	BList team_list;
+	be_roster->GetAppList( &team_list );
+	for( int32 i = 0; i < team_list.CountItems(); i++ ) {
+		index_team( (team_id)team_list.ItemAt( i ) );
+	}
+}
+
+// ----------------------------------------------------------------------
+// Catch up with whatever the watcher has seen since last time.
+static void apply_changes( void )
+{
+	BList launched;
+	BList quit;
+
+	if( !pending_lock.Lock() ) return;
+	launched.AddList( &launched_teams );
+	quit.AddList( &quit_teams );
+	launched_teams.MakeEmpty();
+	quit_teams.MakeEmpty();
+	pending_lock.Unlock();
+
+	for( int32 i = 0; i < launched.CountItems(); i++ ) {
+		index_team( (team_id)launched.ItemAt( i ) );
+	}
+	for( int32 i = 0; i < quit.CountItems(); i++ ) {
+		forget_team( (team_id)quit.ItemAt( i ) );
+	}
+}
+
+// ----------------------------------------------------------------------
+static team_id lookup( const char *name )
+{
+	PyObject *team = PyDict_GetItemString( teams_by_name, (char *)name );
+	if( team == NULL ) return -1;
+
+	return (team_id)PyInt_AsLong( team );
+}
+
+// ----------------------------------------------------------------------
+team_id find_team( const char *name )
+{
+	bool fresh = false;
+
+	if( teams_by_name == NULL ) {
+		teams_by_name = PyDict_New();
+		names_by_team = PyDict_New();
+		if( teams_by_name == NULL || names_by_team == NULL ) {
+			Py_XDECREF( teams_by_name );
+			Py_XDECREF( names_by_team );
+			teams_by_name = NULL;
+			names_by_team = NULL;
+			PyErr_Clear();
+			return -1;
+		}
+
+		// Start watching before the first scan so we can't miss a team
+		// that launches in between.
+		start_watching();
+		rebuild_index();
+		fresh = true;
+	} else if( watching ) {
+		apply_changes();
+	} else {
+		rebuild_index();
+		fresh = true;
+	}
+
+	team_id the_team_id = lookup( name );
+	if( the_team_id < 0 && !fresh ) {
+		// Threads come and go (and get renamed) without the roster
+		// saying anything, so look again before giving up.
+		rebuild_index();
+		the_team_id = lookup( name );
+	}
+
+	return the_team_id;
+}
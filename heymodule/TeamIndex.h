@@ -0,0 +1,29 @@
+// TeamIndex
+//
+// The TeamIndex is used by heymodule to turn the name you hand to the
+// Hey constructor (a signature or a thread name) into a team without
+// walking the whole roster every time.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_TeamIndex_H
+#define PyHey_TeamIndex_H
+
+#include <kernel/OS.h>
+
+// Find the running team whose signature, or the name of any one of whose
+// threads, is name.  Returns -1 if nobody matches.
+//
+// The index is built the first time you call this, then kept up to date
+// by watching the roster for applications launching and quitting; call
+// this with the interpreter lock held.
+team_id find_team( const char *name );
+
+#endif
@@ -0,0 +1,466 @@
+// Template
+//
+// The Template object is used by heymodule to build lots of specifiers
+// that only differ by an index or a name ("Title of Window %d"), without
+// parsing the string or building the whole specifier stack every time.
+//
+// The string is parsed once, with a dummy value standing in for each
+// placeholder; then we find the levels of the specifier stack the dummies
+// ended up in.  Binding values to the placeholders copies the stack and
+// replaces just those levels.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Template.h"
+#include "Specifier.h"
+#include "SpecifierParser.h"
+#include "Hey.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The dummy values: placeholder n is index slot_index_base + n, or the
+// name "\001n", neither of which anybody is going to use for real.
+static const int32 slot_index_base = 0x7fff0000;
+static const int max_slots = 64;
+
+static bool build_template( TemplateObject *self );
+static void free_slots( TemplateObject *self );
+
+// ======================================================================
+// Template object
+// ======================================================================
+
+// ----------------------------------------------------------------------
+// Create an empty Template object.
+static TemplateObject *alloc_template( void )
+{
+	TemplateObject *self;
+	self = PyObject_NEW( TemplateObject, &Template_Type );
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	self->slots = NULL;
+	self->nslots = 0;
+	self->frozen = 0;
+	try {
+		self->msg = new BMessage;
+	} catch ( bad_alloc &ex ) {
+		self->msg = NULL;
+		Py_DECREF( self );
+		return (TemplateObject *)PyErr_NoMemory();
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+// Turn "Title of Window %d" into "Title of Window 2147418112" (and so on)
+// for the parser.  Returns false and sets an exception if the format is
+// no good; *count is the number of placeholders.
+static bool expand_format( const char *format, char *buff, size_t size,
+                           int *count )
+{
+	char *out = buff;
+	char *end = buff + size - 16;	// room for one dummy and the NUL
+
+	*count = 0;
+	for( const char *in = format; *in; in++ ) {
+		if( out >= end ) {
+			PyErr_SetString( PyExc_ValueError, "template is too long" );
+			return false;
+		}
+
+		if( *in != '%' ) {
+			*out++ = *in;
+			continue;
+		}
+
+		in++;
+		if( *in == '%' ) {
+			*out++ = '%';
+		} else if( *in == 'd' || *in == 's' ) {
+			if( *count >= max_slots ) {
+				PyErr_SetString( PyExc_ValueError,
+				                 "too many placeholders in template" );
+				return false;
+			}
+
+			if( *in == 'd' ) {
+				out += sprintf( out, "%ld", (long)( slot_index_base + *count ) );
+			} else {
+				out += sprintf( out, "\001%d", *count );
+			}
+			(*count)++;
+		} else {
+			PyErr_SetString( PyExc_ValueError,
+			                 "templates only understand %d, %s and %%" );
+			return false;
+		}
+	}
+	*out = '\0';
+
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Create a new Template object.
+TemplateObject *newTemplateObject( PyObject *args )
+{
+	char *format = NULL;
+	if( !PyArg_ParseTuple( args, "|s", &format ) ) {
+		return NULL;
+	}
+
+	TemplateObject *self = alloc_template();
+	if( self == NULL ) {
+		return NULL;
+	}
+
+	if( format ) {
+		char *buff;
+		size_t size = strlen( format ) * 6 + 64;
+		try {
+			buff = new char[size];
+		} catch ( bad_alloc &ex ) {
+			Py_DECREF( self );
+			return (TemplateObject *)PyErr_NoMemory();
+		}
+
+		int count;
+		status_t retval = B_OK;
+		bool ok = expand_format( format, buff, size, &count );
+		if( ok ) {
+			retval = parse_specifier_string( self->msg, buff );
+		}
+		delete [] buff;
+
+		if( !ok ) {
+			Py_DECREF( self );
+			return NULL;
+		}
+
+		switch( retval ) {
+		case B_OK:
+			break;
+
+		case B_NO_MEMORY:
+			Py_DECREF( self );
+			return (TemplateObject *)PyErr_NoMemory();
+
+		default:
+			Py_DECREF( self );
+			PyErr_SetString( PyExc_SyntaxError, "bad script syntax" );
+			return NULL;
+		}
+
+		self->nslots = count;
+		if( !build_template( self ) ) {
+			Py_DECREF( self );
+			return NULL;
+		}
+	}
+
+	return self;
+}
+
+// ----------------------------------------------------------------------
+static void free_slots( TemplateObject *self )
+{
+	if( self->slots ) {
+		for( int idx = 0; idx < self->nslots; idx++ ) {
+			delete self->slots[idx].spec;
+		}
+		delete [] self->slots;
+		self->slots = NULL;
+	}
+}
+
+// ----------------------------------------------------------------------
+// Find the level of the specifier stack each placeholder's dummy value
+// ended up in.  If that works, the Template is frozen.
+static bool build_template( TemplateObject *self )
+{
+	if( self->nslots == 0 ) {
+		self->frozen = 1;
+		return true;
+	}
+
+	try {
+		self->slots = new template_slot[self->nslots];
+	} catch ( bad_alloc &ex ) {
+		(void)PyErr_NoMemory();
+		return false;
+	}
+	for( int idx = 0; idx < self->nslots; idx++ ) {
+		self->slots[idx].spec = NULL;
+	}
+
+	int32 levels = count_message_items( *self->msg, "specifiers" );
+	for( int32 level = 0; level < levels; level++ ) {
+		BMessage spec;
+		if( self->msg->FindMessage( "specifiers", level, &spec ) != B_OK ) {
+			continue;
+		}
+
+		int slot = -1;
+		char kind = 0;
+		switch( spec.what ) {
+		case B_INDEX_SPECIFIER:			// fall through
+		case B_REVERSE_INDEX_SPECIFIER:
+			slot = spec.FindInt32( "index" ) - slot_index_base;
+			kind = 'd';
+			break;
+
+		case B_NAME_SPECIFIER:
+			{
+				const char *name = spec.FindString( "name" );
+				if( name && name[0] == '\001' ) {
+					slot = atoi( name + 1 );
+					kind = 's';
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if( slot < 0 || slot >= self->nslots ) continue;
+
+		template_slot &s = self->slots[slot];
+		s.level = level;
+		s.kind = kind;
+		s.reverse = ( spec.what == B_REVERSE_INDEX_SPECIFIER );
+		delete s.spec;		// only if the same placeholder turns up twice
+		try {
+			s.spec = new BMessage( spec );
+		} catch ( bad_alloc &ex ) {
+			s.spec = NULL;
+			free_slots( self );
+			(void)PyErr_NoMemory();
+			return false;
+		}
+	}
+
+	// Anything we didn't find was somewhere we can't patch, like a range
+	// or the middle of a property name.
+	for( int idx = 0; idx < self->nslots; idx++ ) {
+		if( self->slots[idx].spec == NULL ) {
+			char buff[128];
+			sprintf( buff, "placeholder %d isn't an index or a name", idx + 1 );
+			PyErr_SetString( PyExc_ValueError, buff );
+			free_slots( self );
+			return false;
+		}
+	}
+
+	self->frozen = 1;
+	return true;
+}
+
+// ----------------------------------------------------------------------
+// Delete a Template object
+static void Template_dealloc( TemplateObject *self )
+{
+	free_slots( self );
+	delete self->msg;
+	PyMem_DEL( self );
+}
+
+// ----------------------------------------------------------------------
+// Add a specifier, like Specifier's Add(); "%d" or "%s" as the second
+// argument makes it a placeholder.
+//
+// Add( "Title" )
+// Add( "Window", "%d" )
+// Add( "View", "%s" )
+// Add( "Window", "Untitled" )
+// Add( "Window", 0 )
+// Add( "Line", 0, 10 )
+static PyObject *Template_Add( TemplateObject *self, PyObject *arg )
+{
+	char *property, *name;
+	int index, range_start, range_run;
+
+	if( self->frozen ) {
+		PyErr_SetString( PyExc_TypeError,
+				"Template can't be changed once it's been used" );
+		return NULL;
+	}
+
+	if( PyArg_ParseTuple( arg, "s", &property ) ) {
+		self->msg->AddSpecifier( property );
+	} else if( PyArg_ParseTuple( arg, "ss", &property, &name ) ) {
+		if( strcmp( name, "%d" ) == 0 || strcmp( name, "%s" ) == 0 ) {
+			if( self->nslots >= max_slots ) {
+				PyErr_SetString( PyExc_ValueError,
+				                 "too many placeholders in template" );
+				return NULL;
+			}
+
+			if( name[1] == 'd' ) {
+				self->msg->AddSpecifier( property,
+				                         slot_index_base + self->nslots );
+			} else {
+				char dummy[16];
+				sprintf( dummy, "\001%d", self->nslots );
+				self->msg->AddSpecifier( property, dummy );
+			}
+			self->nslots++;
+		} else if( strcmp( name, "*" ) == 0 ) {
+			BMessage all( HEY_ALL_SPECIFIER );
+			all.AddString( "property", property );
+			self->msg->AddSpecifier( &all );
+		} else {
+			self->msg->AddSpecifier( property, name );
+		}
+	} else if( PyArg_ParseTuple( arg, "sii", &property, &range_start,
+	                             &range_run ) ) {
+		if( range_start < 0 || range_run < 0 ) {
+			PyErr_SetString( PyExc_ValueError,
+			                 "template ranges can't be negative" );
+			return NULL;
+		}
+		self->msg->AddSpecifier( property, range_start, range_run );
+	} else if( PyArg_ParseTuple( arg, "si", &property, &index ) ) {
+		if( index < 0 ) {
+			BMessage reverse( B_REVERSE_INDEX_SPECIFIER );
+			reverse.AddString( "property", property );
+			reverse.AddInt32( "index", -index );
+			self->msg->AddSpecifier( &reverse );
+		} else {
+			self->msg->AddSpecifier( property, index );
+		}
+	} else {
+		PyErr_Clear();
+
+		PyErr_SetString( PyExc_ValueError, "invalid specifier" );
+		return NULL;
+	}
+
+	PyErr_Clear();
+	Py_INCREF( Py_None );
+	return Py_None;
+}
+
+// ----------------------------------------------------------------------
+// Fill in the placeholders and return a Specifier.  Only the levels with
+// placeholders in them are touched; the rest of the stack is copied as it
+// is.
+static PyObject *Template_Bind( TemplateObject *self, PyObject *args )
+{
+	if( !self->frozen && !build_template( self ) ) {
+		return NULL;
+	}
+
+	if( PyTuple_Size( args ) != self->nslots ) {
+		char buff[128];
+		sprintf( buff, "template wants %d values, got %d", self->nslots,
+				 PyTuple_Size( args ) );
+		PyErr_SetString( PyExc_TypeError, buff );
+		return NULL;
+	}
+
+	SpecifierObject *spec = newSpecifierFromMessage( *self->msg );
+	if( spec == NULL ) {
+		return NULL;
+	}
+
+	for( int idx = 0; idx < self->nslots; idx++ ) {
+		template_slot &slot = self->slots[idx];
+		PyObject *value = PyTuple_GetItem( args, idx );
+		BMessage level( *slot.spec );
+
+		if( slot.kind == 'd' ) {
+			if( !PyInt_Check( value ) ) {
+				Py_DECREF( spec );
+				PyErr_SetString( PyExc_TypeError,
+				                 "%d placeholders need an integer" );
+				return NULL;
+			}
+
+			// A negative index counts from the end, like Add() does.
+			long index = PyInt_AsLong( value );
+			if( slot.reverse ) index = -index;
+			if( index < 0 ) {
+				level.what = B_REVERSE_INDEX_SPECIFIER;
+				index = -index;
+			} else {
+				level.what = B_INDEX_SPECIFIER;
+			}
+			level.ReplaceInt32( "index", (int32)index );
+		} else {
+			if( !PyString_Check( value ) ) {
+				Py_DECREF( spec );
+				PyErr_SetString( PyExc_TypeError,
+				                 "%s placeholders need a string" );
+				return NULL;
+			}
+
+			level.ReplaceString( "name", PyString_AsString( value ) );
+		}
+
+		if( spec->msg->ReplaceMessage( "specifiers", slot.level,
+		                               &level ) != B_OK ) {
+			Py_DECREF( spec );
+			PyErr_SetString( PyExc_RuntimeError, "unable to bind template" );
+			return NULL;
+		}
+	}
+
+	return (PyObject *)spec;
+}
+
+static PyObject *Template_call( TemplateObject *self, PyObject *args,
+                                PyObject *kwds )
+{
+	return Template_Bind( self, args );
+}
+
+// ----------------------------------------------------------------------
+// Method table and whatnot for the Template object.
+static PyMethodDef TemplateObject_methods[] = {
+	{ "Add",	(PyCFunction)Template_Add,	1,	"Add a specifier, or a placeholder." },
+	{ "Bind",	(PyCFunction)Template_Bind,	1,	"Fill in the placeholders and return a Specifier." },
+	{ NULL, NULL }	// sentinel
+};
+
+static PyObject *Template_getattr( TemplateObject *self, char *name )
+{
+	if( strcmp( name, "placeholders" ) == 0 ) {
+		return PyInt_FromLong( self->nslots );
+	}
+
+	return Py_FindMethod( TemplateObject_methods, (PyObject *)self, name );
+}
+
+PyTypeObject Template_Type = {
+	PyObject_HEAD_INIT(&PyType_Type)
+	0,			// ob_size
+	"Template",			// tp_name
+	sizeof(TemplateObject),	// tp_basicsize
+	0,			// tp_itemsize
+	//  methods
+	(destructor)Template_dealloc, // tp_dealloc
+	0,			// tp_print
+	(getattrfunc)Template_getattr, // tp_getattr
+	0,			// tp_setattr
+	0,			// tp_compare
+	0,			// tp_repr
+	0,			// tp_as_number
+	0,			// tp_as_sequence
+	0,			// tp_as_mapping
+	0,			// tp_hash
+	(ternaryfunc)Template_call,	// tp_call
+};
@@ -0,0 +1,53 @@
+// Template
+//
+// The Template object is used by heymodule to build lots of specifiers
+// that only differ by an index or a name ("Title of Window %d"), without
+// parsing the string or building the whole specifier stack every time.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Template_H
+#define PyHey_Template_H
+
+#include "Python.h"
+
+#include <app/Message.h>
+
+// A placeholder in the specifier stack.
+struct template_slot {
+	int32 level;		// which item of the "specifiers" field it's in
+	char kind;			// 'd' for an index, 's' for a name
+	bool reverse;		// it's a reverse index
+	BMessage *spec;		// that level's specifier, ready to be patched
+};
+
+// The object:
+typedef struct {
+	PyObject_HEAD
+	BMessage *msg;			// the specifier stack, with dummy values
+	template_slot *slots;	// the placeholders, in order; NULL until built
+	int nslots;
+	int frozen;				// set once it's been built; no more Add()
+} TemplateObject;
+
+// The object's type:
+extern PyTypeObject Template_Type;
+
+// Macro for checking the type:
+#define TemplateObject_Check(v)	((v)->ob_type == &Template_Type)
+
+// Methods you can use.
+//
+// Create a Template from a one-item argument tuple holding a hey-style
+// string with %d (index) and %s (name) placeholders in it, or from an
+// empty tuple (use Add() to fill it in).
+TemplateObject *newTemplateObject( PyObject *args );
+
+#endif
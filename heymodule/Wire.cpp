@@ -0,0 +1,327 @@
+// Wire
+//
+// The wire format is used by heymodule to carry scripting messages over a
+// socket; see Wire.h for the format.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Wire.h"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined( __BEOS__ )
+#include <socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#endif
+
+#if defined( MSG_NOSIGNAL )
+#define WIRE_SEND_FLAGS		MSG_NOSIGNAL
+#else
+#define WIRE_SEND_FLAGS		0
+#endif
+
+// In network byte order on the wire.
+struct wire_header {
+	uint32 magic;
+	uint32 id;
+	int32 size;
+};
+
+// ----------------------------------------------------------------------
+static bool is_local( const char *address )
+{
+	return strchr( address, '/' ) != NULL;
+}
+
+// Split "host:port" or "port" into an AF_INET address.
+static status_t inet_address( const char *address, struct sockaddr_in *sin )
+{
+	const char *colon = strrchr( address, ':' );
+	const char *port = colon ? colon + 1 : address;
+
+	char host[256];
+	if( colon ) {
+		size_t len = colon - address;
+		if( len >= sizeof( host ) ) return B_BAD_VALUE;
+		memcpy( host, address, len );
+		host[len] = '\0';
+	} else {
+		strcpy( host, "localhost" );
+	}
+
+	char *end;
+	long number = strtol( port, &end, 10 );
+	if( *port == '\0' || *end != '\0' || number <= 0 || number > 65535 ) {
+		return B_BAD_VALUE;
+	}
+
+	struct hostent *ent = gethostbyname( host[0] ? host : "localhost" );
+	if( ent == NULL || ent->h_length != sizeof( sin->sin_addr ) ) {
+		return B_NAME_NOT_FOUND;
+	}
+
+	memset( sin, 0, sizeof( *sin ) );
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons( (unsigned short)number );
+	memcpy( &sin->sin_addr, ent->h_addr, sizeof( sin->sin_addr ) );
+
+	return B_OK;
+}
+
+#if defined( AF_UNIX )
+static status_t local_address( const char *address, struct sockaddr_un *local )
+{
+	if( strlen( address ) >= sizeof( local->sun_path ) ) return B_NAME_TOO_LONG;
+
+	memset( local, 0, sizeof( *local ) );
+	local->sun_family = AF_UNIX;
+	strcpy( local->sun_path, address );
+
+	return B_OK;
+}
+#endif
+
+// ----------------------------------------------------------------------
+// Make a socket for address, and connect it or bind it.
+static status_t open_socket( const char *address, bool listen, int *sock )
+{
+	int domain;
+	struct sockaddr *addr;
+	int addr_len;
+	status_t retval;
+
+	struct sockaddr_in sin;
+#if defined( AF_UNIX )
+	struct sockaddr_un local;
+#endif
+
+	if( is_local( address ) ) {
+#if defined( AF_UNIX )
+		retval = local_address( address, &local );
+		domain = AF_UNIX;
+		addr = (struct sockaddr *)&local;
+		addr_len = sizeof( local );
+#else
+		return B_BAD_VALUE;
+#endif
+	} else {
+		retval = inet_address( address, &sin );
+		domain = AF_INET;
+		addr = (struct sockaddr *)&sin;
+		addr_len = sizeof( sin );
+	}
+	if( retval != B_OK ) return retval;
+
+	*sock = socket( domain, SOCK_STREAM, 0 );
+	if( *sock < 0 ) return B_ERROR;
+
+	if( listen ) {
+		if( domain == AF_INET ) {
+			int on = 1;
+			(void)setsockopt( *sock, SOL_SOCKET, SO_REUSEADDR,
+			                  (char *)&on, sizeof( on ) );
+		} else {
+			wire_unlink( address );
+		}
+		retval = ( bind( *sock, addr, addr_len ) == 0 &&
+		           ::listen( *sock, 8 ) == 0 ) ? B_OK : B_ERROR;
+	} else {
+		retval = ( connect( *sock, addr, addr_len ) == 0 ) ? B_OK : B_ERROR;
+	}
+
+	if( retval != B_OK ) {
+		wire_close( *sock );
+		*sock = -1;
+	}
+
+	return retval;
+}
+
+status_t wire_connect( const char *address, int *sock )
+{
+	return open_socket( address, false, sock );
+}
+
+status_t wire_listen( const char *address, int *sock )
+{
+	return open_socket( address, true, sock );
+}
+
+status_t wire_accept( int listener, int *sock )
+{
+	*sock = accept( listener, NULL, NULL );
+	return ( *sock < 0 ) ? B_ERROR : B_OK;
+}
+
+// ----------------------------------------------------------------------
+static status_t send_all( int sock, const char *buff, size_t size )
+{
+	while( size > 0 ) {
+		ssize_t sent = send( sock, buff, size, WIRE_SEND_FLAGS );
+		if( sent <= 0 ) return B_ERROR;
+
+		buff += sent;
+		size -= sent;
+	}
+
+	return B_OK;
+}
+
+static status_t recv_all( int sock, char *buff, size_t size )
+{
+	while( size > 0 ) {
+		ssize_t got = recv( sock, buff, size, 0 );
+		if( got == 0 ) return B_ENTRY_NOT_FOUND;
+		if( got < 0 ) return B_ERROR;
+
+		buff += got;
+		size -= got;
+	}
+
+	return B_OK;
+}
+
+// ----------------------------------------------------------------------
+status_t wire_write( int sock, uint32 id, const BMessage &msg )
+{
+	ssize_t size = msg.FlattenedSize();
+	if( size < 0 ) return size;
+
+	char *buff;
+	try {
+		buff = new char[sizeof( wire_header ) + size];
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+
+	wire_header *header = (wire_header *)buff;
+	header->magic = htonl( HEY_WIRE_FRAME );
+	header->id = htonl( id );
+	header->size = htonl( size );
+
+	status_t retval = msg.Flatten( buff + sizeof( wire_header ), size );
+	if( retval == B_OK ) {
+		retval = send_all( sock, buff, sizeof( wire_header ) + size );
+	}
+
+	delete [] buff;
+	return retval;
+}
+
+status_t wire_read( int sock, uint32 *id, BMessage *msg )
+{
+	wire_header header;
+	status_t retval = recv_all( sock, (char *)&header, sizeof( header ) );
+	if( retval != B_OK ) return retval;
+
+	header.magic = ntohl( header.magic );
+	header.id = ntohl( header.id );
+	header.size = ntohl( header.size );
+	if( header.magic != HEY_WIRE_FRAME || header.size <= 0 ||
+		header.size > HEY_WIRE_MAX_SIZE ) {
+		return B_BAD_VALUE;
+	}
+
+	char *buff;
+	try {
+		buff = new char[header.size];
+	} catch ( bad_alloc &ex ) {
+		return B_NO_MEMORY;
+	}
+
+	retval = recv_all( sock, buff, header.size );
+	if( retval == B_OK ) {
+		retval = msg->Unflatten( buff );
+		*id = header.id;
+	}
+
+	delete [] buff;
+	return retval;
+}
+
+// ----------------------------------------------------------------------
+void wire_shutdown( int sock )
+{
+	(void)shutdown( sock, 2 );
+}
+
+void wire_close( int sock )
+{
+#if defined( __BEOS__ )
+	(void)closesocket( sock );
+#else
+	(void)close( sock );
+#endif
+}
+
+void wire_unlink( const char *address )
+{
+	if( is_local( address ) ) {
+		(void)unlink( address );
+	}
+}
+
+// ----------------------------------------------------------------------
+status_t wire_pair( int sock[2] )
+{
+#if defined( AF_UNIX )
+	return ( socketpair( AF_UNIX, SOCK_STREAM, 0, sock ) == 0 ) ? B_OK : B_ERROR;
+#else
+	// No socketpair() in net_server, so connect to ourselves over the
+	// loopback, on whatever port we're given.
+	struct sockaddr_in sin;
+	memset( &sin, 0, sizeof( sin ) );
+	sin.sin_family = AF_INET;
+	sin.sin_port = 0;
+	sin.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+	sock[0] = -1;
+	sock[1] = -1;
+
+	int listener = socket( AF_INET, SOCK_STREAM, 0 );
+	if( listener < 0 ) return B_ERROR;
+
+	status_t retval = B_ERROR;
+	int len = sizeof( sin );
+	if( bind( listener, (struct sockaddr *)&sin, sizeof( sin ) ) == 0 &&
+		::listen( listener, 1 ) == 0 &&
+		getsockname( listener, (struct sockaddr *)&sin, &len ) == 0 ) {
+		sock[1] = socket( AF_INET, SOCK_STREAM, 0 );
+		if( sock[1] >= 0 &&
+			connect( sock[1], (struct sockaddr *)&sin, sizeof( sin ) ) == 0 ) {
+			sock[0] = accept( listener, NULL, NULL );
+			if( sock[0] >= 0 ) retval = B_OK;
+		}
+	}
+	wire_close( listener );
+
+	if( retval != B_OK && sock[1] >= 0 ) {
+		wire_close( sock[1] );
+		sock[1] = -1;
+	}
+
+	return retval;
+#endif
+}
+
+void wire_notify( int sock )
+{
+	(void)send( sock, "!", 1, WIRE_SEND_FLAGS );
+}
@@ -0,0 +1,80 @@
+// Wire
+//
+// The wire format is used by heymodule to carry scripting messages over a
+// socket instead of a port: a connection to a ScriptingAgent (see
+// Agent.h) living in the target's team.  The two ends can be different
+// machines, so the frame header is in network byte order; a flattened
+// BMessage says what order it's in, and Unflatten() sorts it out.
+//
+// Each message is a frame:
+//
+// uint32	HEY_WIRE_FRAME
+// uint32	request id; a reply has the id of its request
+// int32	size of the flattened message
+//			the flattened message
+//
+// The agent starts every connection with a HEY_WIRE_HELLO message (id 0)
+// holding its target's "team" and (if it has one) "signature", so the
+// client knows who it's talking to.
+// After that, requests can be sent whenever you like, without waiting
+// for replies, and replies come back in whatever order the target
+// answers them.
+//
+// Addresses are either a path (anything with a '/' in it) for a local
+// socket, or "port" or "host:port" for TCP.  BeOS's net_server doesn't
+// do local sockets, so there it's TCP, and you'll want "localhost".
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#ifndef PyHey_Wire_H
+#define PyHey_Wire_H
+
+#include <app/Message.h>
+#include <kernel/OS.h>
+
+#define HEY_WIRE_FRAME	'hWir'
+#define HEY_WIRE_HELLO	'hHlo'
+
+// Nobody's sending us a message bigger than this.
+#define HEY_WIRE_MAX_SIZE	( 64 * 1024 * 1024 )
+
+// Open a connection to address; sock gets the socket.
+status_t wire_connect( const char *address, int *sock );
+
+// Listen on address; for a local socket, any old socket file there is
+// removed first.
+status_t wire_listen( const char *address, int *sock );
+
+// Wait for a connection on a listening socket.
+status_t wire_accept( int listener, int *sock );
+
+// Send one frame; it goes out in one piece, so several threads can write
+// to the same socket as long as they take turns.
+status_t wire_write( int sock, uint32 id, const BMessage &msg );
+
+// Read one frame; B_ENTRY_NOT_FOUND if the other end hung up.
+status_t wire_read( int sock, uint32 *id, BMessage *msg );
+
+// Stop anybody reading or writing the socket (they get errors), without
+// giving up the descriptor.
+void wire_shutdown( int sock );
+
+void wire_close( int sock );
+
+// Remove the socket file for a local address (if it is one).
+void wire_unlink( const char *address );
+
+// A pair of connected sockets, for waking up select(): sock[0] becomes
+// readable once wire_notify( sock[1] ) has been called.  BeOS's select()
+// only takes sockets, so a pipe won't do there.
+status_t wire_pair( int sock[2] );
+void wire_notify( int sock );
+
+#endif
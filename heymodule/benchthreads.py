@@ -0,0 +1,62 @@
+#! /bin/env python
+#
+# Threaded throughput benchmark for the heymodule.
+#
+# Start heytarget first ("make bench-threads" does that for you), then
+# this has 1, 2, 4 ... threads hammer it with Get requests.  With -s, the
+# requests go to a StandIn() in this team instead, with the same 2ms
+# reply delay.  Each result is a line of tab-separated fields, like
+# heybench's:
+#
+#     threads  thread-count  requests  seconds  requests-per-second
+#
+# Since the interpreter lock is released while a request is waiting for
+# its reply, requests-per-second should go up with the thread count.
+
+import sys
+import time
+import threading
+
+from BeOS.hey import Hey, StandIn
+
+TARGET = "application/x-vnd.ADS-heytarget"
+REQUESTS = 2000
+
+def worker( app, count ):
+	for i in range( count ):
+		app.Get( "Title of Window 0" )
+
+def run( threads, count ):
+	workers = []
+	for i in range( threads ):
+		app = standin or Hey( TARGET )
+		workers.append( threading.Thread( target = worker, args = ( app, count ) ) )
+
+	start = time.time()
+	for w in workers:
+		w.start()
+	for w in workers:
+		w.join()
+
+	return time.time() - start
+
+args = sys.argv[1:]
+standin = None
+if args and args[0] == "-s":
+	standin = StandIn( latency = 0.002 )
+	args = args[1:]
+
+counts = [ 1, 2, 4, 8, 16 ]
+if args:
+	counts = map( int, args )
+
+# Make sure it's there before the clock starts.
+( standin or Hey( TARGET ) ).Get( "Title of Window 0" )
+
+for threads in counts:
+	per_thread = REQUESTS / threads
+	elapsed = run( threads, per_thread )
+	total = per_thread * threads
+	print "threads\t%d\t%d\t%.3f\t%.1f" % ( threads, total, elapsed, total / elapsed )
+
+( standin or Hey( TARGET ) ).Quit()
@@ -0,0 +1,413 @@
+// heybench.cpp
+//
+// Micro-benchmarks for heymodule's hot spots.  Run "make bench"; each
+// result is printed on its own line as tab-separated fields:
+//
+//     group  case  implementation  iterations  usec-per-iteration
+//
+// so the output can be fed straight into a spreadsheet or diffed
+// between releases.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "SpecifierParser.h"
+#include "MessageWalker.h"
+
+#include <app/Message.h>
+#include <kernel/OS.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <support/TypeConstants.h>
+
+// ======================================================================
+// The specifier parser heymodule 1.1 shipped with, kept here so we've
+// got something to measure the new one against.  This is Attila
+// Mezei's add_specifier() from "hey", fed by a strdup()/strtok() argv.
+static status_t legacy_add_specifier( BMessage *to_message, char *argv[], int32 *argx )
+{
+	char *property=argv[*argx];
+
+	if(property==NULL) return B_ERROR;		// no more specifiers
+
+	(*argx)++;
+
+	if(strcasecmp(property, "to")==0){	// it is the 'to' string!!!
+		return B_ERROR;	// no more specifiers
+	}
+
+	if(strcasecmp(property, "of")==0){		// skip "of", read real property
+		property=argv[*argx];
+		if(property==NULL) return B_BAD_SCRIPT_SYNTAX;		// bad syntax
+		(*argx)++;
+	}
+
+	// decide the specifier
+
+	char *specifier=argv[*argx];
+	if(specifier==NULL){	// direct specifier
+		to_message->AddSpecifier(property);
+		return B_ERROR;		// no more specifiers
+	}
+
+	(*argx)++;
+
+	if(strcasecmp(specifier, "of")==0){	// direct specifier
+		to_message->AddSpecifier(property);
+		return B_OK;
+	}
+
+	if(strcasecmp(specifier, "to")==0){	// direct specifier
+		to_message->AddSpecifier(property);
+		return B_ERROR;		// no more specifiers
+	}
+
+
+	if(specifier[0]=='['){	// index, reverse index or range
+		char *end;
+		int32 ix1, ix2;
+		if(specifier[1]=='-'){	// reverse index
+			ix1=strtoul(specifier+2, &end, 10);
+			BMessage revspec(B_REVERSE_INDEX_SPECIFIER);
+			revspec.AddString("property", property);
+			revspec.AddInt32("index", ix1);
+			to_message->AddSpecifier(&revspec);
+		}else{	// index or range
+			ix1=strtoul(specifier+1, &end, 10);
+			if(end[0]==']'){	// it was an index
+				to_message->AddSpecifier(property, ix1);
+				return B_OK;
+			}else{
+				specifier=argv[*argx];
+				if(specifier==NULL){
+					// I was wrong, it was just an index
+					to_message->AddSpecifier(property, ix1);
+					return B_OK;
+				}
+				(*argx)++;
+				if(strcasecmp(specifier, "to")==0){
+					specifier=argv[*argx];
+					if(specifier==NULL){
+						return B_BAD_SCRIPT_SYNTAX;		// wrong syntax
+					}
+					(*argx)++;
+					ix2=strtoul(specifier, &end, 10);
+					to_message->AddSpecifier(property, ix1, ix2-ix1>0 ? ix2-ix1+1 : 1);
+					return B_OK;
+				}else{
+					return B_BAD_SCRIPT_SYNTAX;		// wrong syntax
+				}
+			}
+		}
+	}else{	// name specifier
+		// if it contains only digits, it will be an index...
+		bool contains_only_digits=true;
+		for(size_t i=0;i<strlen(specifier);i++){
+			if(specifier[i]<'0' || specifier[i]>'9'){
+				contains_only_digits=false;
+				break;
+			}
+		}
+
+		if(contains_only_digits){
+			to_message->AddSpecifier(property, atol(specifier));
+		}else{
+			to_message->AddSpecifier(property, specifier);
+		}
+
+	}
+
+	return B_OK;
+}
+
+static status_t legacy_parse( BMessage *msg, const char *spec )
+{
+	char *tmp = strdup( spec );
+
+	int spec_argc = 1;
+	for( size_t idx = 0; idx < strlen( tmp ); idx++ ) {
+		if( tmp[idx] == ' ' ) spec_argc++;
+	}
+
+	char **spec_argv = (char **)malloc( sizeof( char * ) * ( spec_argc + 1 ) );
+
+	int arg = 0;
+	char *ptr = strtok( tmp, " " );
+	while( ptr ) {
+		spec_argv[arg++] = strdup( ptr );
+		ptr = strtok( NULL, " " );
+	}
+	spec_argv[arg] = NULL;
+
+	int32 argx = 0;
+	status_t retval = B_OK;
+	while( retval == B_OK ) {
+		retval = legacy_add_specifier( msg, spec_argv, &argx );
+	}
+
+	for( int idx = 0; spec_argv[idx] != NULL; idx++ ) {
+		free( spec_argv[idx] );
+	}
+	free( spec_argv );
+	free( tmp );
+
+	return ( retval == B_ERROR ) ? B_OK : retval;
+}
+
+// ======================================================================
+// Benchmark plumbing.
+
+typedef status_t (*parse_func)( BMessage *msg, const char *spec );
+
+// Keep going until we've used up at least this much time per case.
+static const bigtime_t min_run_time = 250000;
+
+static void report( const char *group, const char *name, const char *impl,
+                    int32 iterations, bigtime_t elapsed )
+{
+	printf( "%s\t%s\t%s\t%ld\t%.3f\n", group, name, impl, (long)iterations,
+			(double)elapsed / (double)iterations );
+}
+
+static void bench_parse( const char *name, const char *spec,
+                         const char *impl, parse_func parse )
+{
+	int32 iterations = 0;
+	bigtime_t start = system_time();
+	bigtime_t elapsed;
+
+	do {
+		for( int32 idx = 0; idx < 100; idx++ ) {
+			BMessage msg;
+			(void)parse( &msg, spec );
+		}
+		iterations += 100;
+		elapsed = system_time() - start;
+	} while( elapsed < min_run_time );
+
+	report( "parse", name, impl, iterations, elapsed );
+}
+
+// Make sure the two parsers agree before we bother timing them.
+static bool same_result( const char *spec )
+{
+	BMessage legacy;
+	BMessage current;
+	status_t legacy_rv = legacy_parse( &legacy, spec );
+	status_t current_rv = parse_specifier_string( &current, spec );
+	if( legacy_rv != current_rv ) return false;
+
+	ssize_t size = legacy.FlattenedSize();
+	if( size != current.FlattenedSize() ) return false;
+
+	char *a = (char *)malloc( size );
+	char *b = (char *)malloc( size );
+	bool same = a && b &&
+				legacy.Flatten( a, size ) == B_OK &&
+				current.Flatten( b, size ) == B_OK &&
+				memcmp( a, b, size ) == 0;
+	free( a );
+	free( b );
+
+	return same;
+}
+
+// A programmatically generated specifier, like the ones our scripts
+// build: "Text of View 0 of View 1 of ... of Window Untitled".
+static char *deep_specifier( int32 depth )
+{
+	char *spec = (char *)malloc( depth * 24 + 64 );
+	char *ptr = spec;
+
+	ptr += sprintf( ptr, "Text" );
+	for( int32 idx = 0; idx < depth; idx++ ) {
+		ptr += sprintf( ptr, " of View %ld", (long)idx );
+	}
+	sprintf( ptr, " of Window Untitled" );
+
+	return spec;
+}
+
+static void parser_benchmarks( void )
+{
+	const char *fixed[][2] = {
+		{ "direct", "Title" },
+		{ "frame", "Frame of Window 0" },
+		{ "named", "Title of View MyView of Window Untitled" },
+		{ "range", "Line [0 to 99] of View 0 of Window 0" },
+		{ "reverse", "Title of Window [-1]" },
+		{ NULL, NULL }
+	};
+
+	for( int idx = 0; fixed[idx][0] != NULL; idx++ ) {
+		if( !same_result( fixed[idx][1] ) ) {
+			fprintf( stderr, "parsers disagree on \"%s\"\n", fixed[idx][1] );
+			exit( 1 );
+		}
+
+		bench_parse( fixed[idx][0], fixed[idx][1], "legacy", legacy_parse );
+		bench_parse( fixed[idx][0], fixed[idx][1], "current", parse_specifier_string );
+	}
+
+	int32 depths[] = { 8, 64, 512, 0 };
+	for( int idx = 0; depths[idx] != 0; idx++ ) {
+		char name[32];
+		sprintf( name, "deep-%ld", (long)depths[idx] );
+
+		char *spec = deep_specifier( depths[idx] );
+		if( !same_result( spec ) ) {
+			fprintf( stderr, "parsers disagree on %s\n", name );
+			exit( 1 );
+		}
+
+		bench_parse( name, spec, "legacy", legacy_parse );
+		bench_parse( name, spec, "current", parse_specifier_string );
+		free( spec );
+	}
+}
+
+// ======================================================================
+// Reply decoding.  Both of these touch every item of every field the way
+// heymodule does when it turns a reply into Python objects; the Python
+// side of it costs the same either way, so it's left out.
+
+typedef ssize_t (*decode_func)( const BMessage &msg );
+
+// How heymodule 1.1 did it: find each field by index, then look it up by
+// name to count it, then look it up by name again for every item.
+static ssize_t legacy_decode( const BMessage &msg )
+{
+	ssize_t total = 0;
+
+	int32 names = msg.CountNames( B_ANY_TYPE );
+	for( int32 idx = 0; idx < names; idx++ ) {
+		char *name;
+		type_code type;
+		msg.GetInfo( B_ANY_TYPE, idx, &name, &type );
+
+		int32 count = 0;
+		msg.GetInfo( name, &type, &count );
+		for( int32 item = 0; item < count; item++ ) {
+			const void *ptr;
+			ssize_t size;
+			if( msg.GetInfo( name, &type ) == B_OK &&
+				msg.FindData( name, type, item, &ptr, &size ) == B_OK ) {
+				total += size;
+			}
+		}
+	}
+
+	return total;
+}
+
+static ssize_t walker_decode( const BMessage &msg )
+{
+	ssize_t total = 0;
+
+	MessageWalker walker( msg );
+	while( walker.NextField() ) {
+		for( int32 item = 0; item < walker.Count(); item++ ) {
+			const void *ptr;
+			ssize_t size;
+			if( walker.ItemAt( item, &ptr, &size ) == B_OK ) {
+				total += size;
+			}
+		}
+	}
+
+	return total;
+}
+
+static void bench_decode( const char *name, const BMessage &msg,
+                          const char *impl, decode_func decode )
+{
+	int32 iterations = 0;
+	bigtime_t start = system_time();
+	bigtime_t elapsed;
+
+	do {
+		for( int32 idx = 0; idx < 10; idx++ ) {
+			(void)decode( msg );
+		}
+		iterations += 10;
+		elapsed = system_time() - start;
+	} while( elapsed < min_run_time );
+
+	report( "decode", name, impl, iterations, elapsed );
+}
+
+// A synthetic reply with lots of fields, like a Get of a big property
+// list: each field has a name, a few numbers and a string.
+static void wide_reply( BMessage *msg, int32 fields )
+{
+	for( int32 idx = 0; idx < fields; idx++ ) {
+		char name[32];
+		sprintf( name, "field-%ld", (long)idx );
+		msg->AddInt32( name, idx );
+		msg->AddInt32( name, idx * 2 );
+		msg->AddString( name, "some text" );
+	}
+	msg->AddInt32( "error", B_OK );
+}
+
+// A reply with one long "result" field, like a Get of a big list.
+static void long_reply( BMessage *msg, int32 items, type_code type )
+{
+	for( int32 idx = 0; idx < items; idx++ ) {
+		if( type == B_STRING_TYPE ) {
+			msg->AddString( "result", "an item" );
+		} else {
+			msg->AddInt32( "result", idx );
+		}
+	}
+	msg->AddInt32( "error", B_OK );
+}
+
+static void check_and_bench_decode( const char *name, const BMessage &msg )
+{
+	if( legacy_decode( msg ) != walker_decode( msg ) ) {
+		fprintf( stderr, "decoders disagree on %s\n", name );
+		exit( 1 );
+	}
+
+	bench_decode( name, msg, "legacy", legacy_decode );
+	bench_decode( name, msg, "walker", walker_decode );
+}
+
+static void decode_benchmarks( void )
+{
+	int32 widths[] = { 16, 128, 512, 0 };
+	for( int idx = 0; widths[idx] != 0; idx++ ) {
+		char name[32];
+		sprintf( name, "wide-%ld", (long)widths[idx] );
+
+		BMessage msg( B_REPLY );
+		wide_reply( &msg, widths[idx] );
+		check_and_bench_decode( name, msg );
+	}
+
+	BMessage numbers( B_REPLY );
+	long_reply( &numbers, 4096, B_INT32_TYPE );
+	check_and_bench_decode( "long-int32-4096", numbers );
+
+	BMessage strings( B_REPLY );
+	long_reply( &strings, 4096, B_STRING_TYPE );
+	check_and_bench_decode( "long-string-4096", strings );
+}
+
+// ======================================================================
+int main( void )
+{
+	parser_benchmarks();
+	decode_benchmarks();
+
+	return 0;
+}
@@ -32,7 +32,16 @@
 #include "Python.h"
 
 #include "Specifier.h"
+#include "Connection.h"
 #include "Hey.h"
+#include "Packed.h"
+#include "Reply.h"
+#include "Recorder.h"
+#include "Snapshot.h"
+#include "StandIn.h"
+#include "Stats.h"
+#include "Suites.h"
+#include "Template.h"
 
 #include <app/Application.h>
 
@@ -68,10 +77,50 @@ static PyObject *Specifier_new( PyObject *self, PyObject *args )
 	return (PyObject *)rv;
 }
 
+// Convenience function
+static PyObject *Template_new( PyObject *self, PyObject *args )
+{
+	TemplateObject *rv;
+	
+	rv = newTemplateObject( args );
+
+	if ( rv == NULL )
+	    return NULL;
+
+	return (PyObject *)rv;
+}
+
 //  List of functions defined in the module 
 static PyMethodDef hey_methods[] = {
 	{ "Hey",		Hey_new,		1,	"create a new Hey object" },
 	{ "Specifier",	Specifier_new,	1,	"create a new Specifier object" },
+	{ "Template",	Template_new,	1,	"create a new Template object" },
+	{ "SpecifierCacheInfo",	Specifier_CacheInfo,	1,	"return the specifier cache's hit/miss counters and size" },
+	{ "SetSpecifierCacheSize",	Specifier_SetCacheSize,	1,	"set the number of specifier strings to remember (0 turns the cache off)" },
+	{ "ClearSpecifierCache",	Specifier_ClearCache,	1,	"forget every cached specifier string and reset the counters" },
+	{ "SuiteCacheInfo",	Suites_CacheInfo,	1,	"return the suite cache's hit/miss counters and size" },
+	{ "SetSuiteCacheSize",	Suites_SetCacheSize,	1,	"set the number of handlers' suites to remember (0 turns the cache off)" },
+	{ "ClearSuiteCache",	Suites_ClearCache,	1,	"forget every cached suite and reset the counters" },
+	{ "ValidationInfo",	Suites_ValidationInfo,	1,	"return the counts of requests checked, rejected and left unchecked" },
+	{ "ClearValidationInfo",	Suites_ClearValidationInfo,	1,	"reset the validation counters" },
+	{ "SetDefaultTimeouts",	(PyCFunction)Hey_SetDefaultTimeouts,	METH_VARARGS | METH_KEYWORDS,	"set the reply and delivery timeouts (in seconds) for new Hey objects" },
+	{ "DefaultTimeouts",	Hey_DefaultTimeouts,	1,	"return the ( reply, delivery ) timeouts for new Hey objects" },
+	{ "SetDataViewThreshold",	Reply_SetDataViewThreshold,	1,	"set the size (in bytes) at which Reply objects return buffers instead of strings (-1 for never)" },
+	{ "DataViewThreshold",	Reply_DataViewThreshold,	1,	"return the size at which Reply objects return buffers instead of strings" },
+	{ "SetPackedThreshold",	Packed_SetThreshold,	1,	"set the number of items at which numeric fields come back as PackedArrays (-1 for only when asked)" },
+	{ "PackedThreshold",	Packed_Threshold,	1,	"return the number of items at which numeric fields come back as PackedArrays" },
+	{ "Snapshot",	(PyCFunction)Snapshot_Take,	METH_VARARGS | METH_KEYWORDS,	"write everything a target's scripting interface will tell you to a file; returns ( handlers, requests, errors )" },
+	{ "ReadSnapshot",	Snapshot_Read,	1,	"read a snapshot file back as a dictionary" },
+	{ "StartRecording",	Recorder_Start,	1,	"write every request sent from now on, and its reply, to a log file" },
+	{ "StopRecording",	Recorder_Stop,	1,	"stop recording; returns the number of requests recorded" },
+	{ "Replay",	(PyCFunction)Recorder_Replay,	METH_VARARGS | METH_KEYWORDS,	"send a recorded log's requests again and compare the replies" },
+	{ "Replayer",	(PyCFunction)Recorder_Replayer,	METH_VARARGS | METH_KEYWORDS,	"create a Hey object for a stand-in that answers from a recorded log" },
+	{ "Stats",	Stats_Info,	1,	"return request counters and latency histograms, by command and by target signature" },
+	{ "ClearStats",	Stats_Clear,	1,	"reset the request counters and histograms" },
+	{ "StandIn",	(PyCFunction)StandIn_New,	METH_VARARGS | METH_KEYWORDS,	"create a Hey object for a stand-in application with windows and views, living in this team" },
+	{ "Connect",	Connection_Connect,	1,	"create a Hey object for the target of a scripting agent listening on a socket" },
+	{ "Serve",	(PyCFunction)Connection_Serve,	METH_VARARGS | METH_KEYWORDS,	"answer scripting requests for a target that come in on a socket" },
+	{ "StopServing",	Connection_StopServing,	1,	"stop answering requests on a socket Serve() is listening on" },
 	{ NULL,		NULL }		//  sentinel 
 };
 
@@ -100,7 +149,19 @@ extern "C" void inithey( void )
 			"\n"
 			"Create a new Specifier object:\n"
 			"\ts = Specifier()\t# Empty specifier\n"
-			"\ts = Specifier( hey_specifier_string )" ) );
+			"\ts = Specifier( hey_specifier_string )\n"
+			"\n"
+			"Create a new Template object:\n"
+			"\tt = Template( hey_specifier_string_with_placeholders )\n"
+			"\ts = t( index_or_name, ... )" ) );
+
+	HeyTimeoutError = PyErr_NewException( "hey.TimeoutError",
+			PyExc_RuntimeError, NULL );
+	PyDict_SetItemString( d, "TimeoutError", HeyTimeoutError );
+
+	HeyUnsupportedError = PyErr_NewException( "hey.UnsupportedError",
+			PyExc_RuntimeError, NULL );
+	PyDict_SetItemString( d, "UnsupportedError", HeyUnsupportedError );
 
 	PyDict_SetItemString( d, "__rcs_id__", 
 		PyString_FromString( "$Id: heymodule.cpp,v 1.1.1.1 1999/06/08 12:49:38 chrish Exp $" ) );
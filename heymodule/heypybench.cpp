@@ -0,0 +1,415 @@
+// heypybench.cpp
+//
+// Micro-benchmarks for heymodule's Python-facing hot spots: building
+// Specifier objects, Add()'s argument dispatch, turning replies into
+// Python objects, and Get round trips against a stand-in target living in
+// this team.  It embeds the interpreter and links the module's objects
+// directly, so nothing has to be installed; run "make bench".
+//
+// Results are printed the same way heybench prints them, one per line as
+// tab-separated fields:
+//
+//     group  case  implementation  iterations  usec-per-iteration
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include "Python.h"
+
+#include "Hey.h"
+#include "Packed.h"
+#include "Specifier.h"
+#include "StandIn.h"
+
+#include <app/Application.h>
+#include <app/Message.h>
+#include <app/Messenger.h>
+#include <app/PropertyInfo.h>
+#include <kernel/OS.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" void inithey( void );
+
+// ======================================================================
+// Benchmark plumbing; the same rules as heybench.
+
+// Keep going until we've used up at least this much time per case.
+static const bigtime_t min_run_time = 250000;
+
+// One iteration of a case; returns false (with a Python exception set)
+// if something went wrong.
+typedef bool (*bench_func)( void *data );
+
+static void report( const char *group, const char *name, const char *impl,
+                    int32 iterations, bigtime_t elapsed )
+{
+	printf( "%s\t%s\t%s\t%ld\t%.3f\n", group, name, impl, (long)iterations,
+			(double)elapsed / (double)iterations );
+}
+
+static void bench( const char *group, const char *name, const char *impl,
+                   bench_func func, void *data, int32 batch = 100 )
+{
+	int32 iterations = 0;
+	bigtime_t start = system_time();
+	bigtime_t elapsed;
+
+	do {
+		for( int32 idx = 0; idx < batch; idx++ ) {
+			if( !func( data ) ) {
+				fprintf( stderr, "%s %s %s failed:\n", group, name, impl );
+				PyErr_Print();
+				exit( 1 );
+			}
+		}
+		iterations += batch;
+		elapsed = system_time() - start;
+	} while( elapsed < min_run_time );
+
+	report( group, name, impl, iterations, elapsed );
+}
+
+// Most cases just want a Python call made and its result thrown away.
+static bool keep( PyObject *obj )
+{
+	Py_XDECREF( obj );
+	return obj != NULL;
+}
+
+// ======================================================================
+// Specifiers
+
+static PyObject *hey_module = NULL;
+
+static bool set_spec_cache( int size )
+{
+	return keep( PyObject_CallMethod( hey_module, "SetSpecifierCacheSize",
+	                                  "i", size ) );
+}
+
+// newSpecifierObject() on a specifier string; the string's already a
+// Python object, like it would be coming from a script.
+static bool new_specifier( void *data )
+{
+	return keep( (PyObject *)newSpecifierObject( (PyObject *)data ) );
+}
+
+static void specifier_benchmarks( void )
+{
+	const char *fixed[][2] = {
+		{ "direct", "Title" },
+		{ "frame", "Frame of Window 0" },
+		{ "named", "Title of View MyView of Window Untitled" },
+		{ "range", "Line [0 to 99] of View 0 of Window 0" },
+		{ "reverse", "Title of Window [-1]" },
+		{ NULL, NULL }
+	};
+
+	for( int idx = 0; fixed[idx][0] != NULL; idx++ ) {
+		PyObject *args = Py_BuildValue( "(s)", fixed[idx][1] );
+
+		(void)set_spec_cache( 0 );
+		bench( "specifier", fixed[idx][0], "uncached", new_specifier, args );
+		(void)set_spec_cache( 256 );
+		bench( "specifier", fixed[idx][0], "cached", new_specifier, args );
+
+		Py_DECREF( args );
+	}
+}
+
+// ----------------------------------------------------------------------
+// Specifier.Add(), one case per overload; every iteration builds a fresh
+// Specifier, so that's measured on its own as "empty".
+struct add_case {
+	const char *name;
+	const char *format;
+	PyObject *args;
+};
+
+static bool add_specifier( void *data )
+{
+	add_case *the_case = (add_case *)data;
+
+	PyObject *empty = PyTuple_New( 0 );
+	PyObject *spec = (PyObject *)newSpecifierObject( empty );
+	Py_DECREF( empty );
+	if( spec == NULL ) return false;
+
+	bool ok = true;
+	if( the_case->args ) {
+		PyObject *add = PyObject_GetAttrString( spec, "Add" );
+		ok = add && keep( PyEval_CallObject( add, the_case->args ) );
+		Py_XDECREF( add );
+	}
+
+	Py_DECREF( spec );
+	return ok;
+}
+
+static void add_benchmarks( void )
+{
+	add_case cases[] = {
+		{ "empty", NULL, NULL },
+		{ "direct", "(s)", NULL },
+		{ "index", "(si)", NULL },
+		{ "reverse-index", "(si)", NULL },
+		{ "name", "(ss)", NULL },
+		{ "all", "(ss)", NULL },
+		{ "range", "(sii)", NULL },
+		{ NULL, NULL, NULL }
+	};
+
+	cases[1].args = Py_BuildValue( cases[1].format, "Title" );
+	cases[2].args = Py_BuildValue( cases[2].format, "Window", 0 );
+	cases[3].args = Py_BuildValue( cases[3].format, "Window", -1 );
+	cases[4].args = Py_BuildValue( cases[4].format, "Window", "Untitled" );
+	cases[5].args = Py_BuildValue( cases[5].format, "Window", "*" );
+	cases[6].args = Py_BuildValue( cases[6].format, "Line", 1, 5 );
+
+	for( int idx = 0; cases[idx].name != NULL; idx++ ) {
+		bench( "add", cases[idx].name, "current", add_specifier, &cases[idx] );
+		Py_XDECREF( cases[idx].args );
+	}
+}
+
+// ======================================================================
+// Reply conversion, on synthetic replies shaped like the ones we get.
+
+struct item_case {
+	uint32 type;
+	const void *ptr;
+	ssize_t size;
+};
+
+static bool convert_item( void *data )
+{
+	item_case *the_case = (item_case *)data;
+	return keep( obj_to_python( the_case->type, the_case->ptr, the_case->size ) );
+}
+
+struct reply_case {
+	BMessage *msg;
+	int packed;
+};
+
+static bool convert_reply( void *data )
+{
+	reply_case *the_case = (reply_case *)data;
+	return keep( explain_reply( *the_case->msg, the_case->packed ) );
+}
+
+static bool convert_dict( void *data )
+{
+	return keep( msg_to_dict( *(BMessage *)data ) );
+}
+
+// A reply with one long "result" field, like a Get of a big list.
+static void long_reply( BMessage *msg, int32 items, type_code type )
+{
+	for( int32 idx = 0; idx < items; idx++ ) {
+		if( type == B_STRING_TYPE ) {
+			msg->AddString( "result", "an item" );
+		} else {
+			msg->AddInt32( "result", idx );
+		}
+	}
+	msg->AddInt32( "error", B_OK );
+}
+
+// A reply with lots of fields: each has a name, a few numbers and a
+// string.
+static void wide_reply( BMessage *msg, int32 fields )
+{
+	for( int32 idx = 0; idx < fields; idx++ ) {
+		char name[32];
+		sprintf( name, "field-%ld", (long)idx );
+		msg->AddInt32( name, idx );
+		msg->AddInt32( name, idx * 2 );
+		msg->AddString( name, "some text" );
+	}
+	msg->AddInt32( "error", B_OK );
+}
+
+// A GetSuites reply, like a window's.
+static property_info suite_props[] = {
+	{ "Frame", { B_GET_PROPERTY, B_SET_PROPERTY, 0 }, { B_DIRECT_SPECIFIER, 0 },
+	  "The window's frame rectangle." },
+	{ "Title", { B_GET_PROPERTY, B_SET_PROPERTY, 0 }, { B_DIRECT_SPECIFIER, 0 },
+	  "The window's title." },
+	{ "View", { 0 }, { B_INDEX_SPECIFIER, B_REVERSE_INDEX_SPECIFIER,
+	  B_NAME_SPECIFIER, 0 }, "The window's views." },
+	{ "Hidden", { B_GET_PROPERTY, B_SET_PROPERTY, 0 }, { B_DIRECT_SPECIFIER, 0 },
+	  "Whether the window is hidden." },
+	{ 0 }
+};
+
+static void suites_reply( BMessage *msg )
+{
+	BPropertyInfo info( suite_props );
+	msg->AddString( "suites", "suite/vnd.Be-window" );
+	msg->AddFlat( "messages", &info );
+	msg->AddString( "suites", "suite/vnd.Be-handler" );
+	msg->AddFlat( "messages", &info );
+	msg->AddInt32( "error", B_OK );
+}
+
+static void convert_benchmarks( void )
+{
+	int32 number = 42;
+	double real = 3.14159;
+	const char *text = "Untitled";
+	BRect rect( 0.0, 0.0, 639.0, 479.0 );
+
+	item_case items[] = {
+		{ B_INT32_TYPE, &number, sizeof( number ) },
+		{ B_DOUBLE_TYPE, &real, sizeof( real ) },
+		{ B_STRING_TYPE, text, strlen( text ) + 1 },
+		{ B_RECT_TYPE, &rect, sizeof( rect ) }
+	};
+	const char *item_names[] = { "int32", "double", "string", "rect" };
+	for( int idx = 0; idx < 4; idx++ ) {
+		bench( "obj_to_python", item_names[idx], "current", convert_item,
+		       &items[idx] );
+	}
+
+	BMessage title( B_REPLY );
+	title.AddString( "result", "Untitled" );
+	title.AddInt32( "error", B_OK );
+
+	BMessage numbers( B_REPLY );
+	long_reply( &numbers, 4096, B_INT32_TYPE );
+
+	BMessage strings( B_REPLY );
+	long_reply( &strings, 4096, B_STRING_TYPE );
+
+	BMessage suites( B_REPLY );
+	suites_reply( &suites );
+
+	// explain_reply() picks build_message_list() or build_suite_dict().
+	reply_case replies[] = {
+		{ &title, PACK_AUTO },
+		{ &numbers, PACK_NEVER },
+		{ &numbers, PACK_ALWAYS },
+		{ &strings, PACK_AUTO },
+		{ &suites, PACK_AUTO }
+	};
+	const char *reply_names[][2] = {
+		{ "build_message_list", "title" },
+		{ "build_message_list", "long-int32-4096" },
+		{ "build_message_list", "long-int32-4096" },
+		{ "build_message_list", "long-string-4096" },
+		{ "build_suite_dict", "suites-2" }
+	};
+	const char *reply_impls[] = { "auto", "list", "packed", "auto", "current" };
+	for( int idx = 0; idx < 5; idx++ ) {
+		bench( reply_names[idx][0], reply_names[idx][1], reply_impls[idx],
+		       convert_reply, &replies[idx], 10 );
+	}
+
+	int32 widths[] = { 16, 128, 512, 0 };
+	for( int idx = 0; widths[idx] != 0; idx++ ) {
+		char name[32];
+		sprintf( name, "wide-%ld", (long)widths[idx] );
+
+		BMessage msg( B_REPLY );
+		wide_reply( &msg, widths[idx] );
+		bench( "msg_to_dict", name, "current", convert_dict, &msg, 10 );
+	}
+}
+
+// ======================================================================
+// Round trips against a stand-in in this team (see StandIn.h); it
+// answers straight away, so what's left is the port and heymodule.
+
+// The message alone, for comparison.
+static bool raw_get( void *data )
+{
+	BMessenger *target = (BMessenger *)data;
+
+	BMessage request( B_GET_PROPERTY );
+	request.AddSpecifier( "Title" );
+	request.AddSpecifier( "Window", (int32)0 );
+
+	BMessage reply;
+	return target->SendMessage( &request, &reply ) == B_OK;
+}
+
+static bool hey_get( void *data )
+{
+	return keep( PyObject_CallMethod( (PyObject *)data, "Get", "s",
+	                                  "Title of Window 0" ) );
+}
+
+// app.Window[0].Title(), through the attribute proxies.
+static bool proxy_get( void *data )
+{
+	PyObject *window = PyObject_GetAttrString( (PyObject *)data, "Window" );
+	if( window == NULL ) return false;
+
+	PyObject *index = PyInt_FromLong( 0 );
+	PyObject *first = index ? PyObject_GetItem( window, index ) : NULL;
+	Py_XDECREF( index );
+	Py_DECREF( window );
+	if( first == NULL ) return false;
+
+	bool ok = keep( PyObject_CallMethod( first, "Title", NULL ) );
+	Py_DECREF( first );
+
+	return ok;
+}
+
+static void get_benchmarks( void )
+{
+	BMessenger target;
+	if( start_standin( standin_defaults, &target ) != B_OK ) {
+		fprintf( stderr, "can't start the stand-in\n" );
+		exit( 1 );
+	}
+
+	PyObject *hey = (PyObject *)newHeyObjectFromMessenger( target );
+	if( hey == NULL ) {
+		PyErr_Print();
+		exit( 1 );
+	}
+
+	bench( "get", "title", "raw", raw_get, &target, 10 );
+	bench( "get", "title", "hey", hey_get, hey, 10 );
+	bench( "get", "title", "proxy", proxy_get, hey, 10 );
+
+	Py_DECREF( hey );
+	(void)target.SendMessage( B_QUIT_REQUESTED );
+}
+
+// ======================================================================
+int main( int argc, char **argv )
+{
+	BApplication app( "application/x-vnd.ADS-heypybench" );
+
+	Py_SetProgramName( argv[0] );
+	Py_Initialize();
+	inithey();
+
+	hey_module = PyImport_ImportModule( "hey" );
+	if( hey_module == NULL ) {
+		PyErr_Print();
+		return 1;
+	}
+
+	specifier_benchmarks();
+	add_benchmarks();
+	convert_benchmarks();
+	get_benchmarks();
+
+	Py_DECREF( hey_module );
+	Py_Finalize();
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+// heytarget.cpp
+//
+// A stand-in scripting target for the benchmarks.  It answers every
+// scripting request (Get gets "Untitled") after a fixed delay, given in
+// microseconds on the command line:
+//
+//     heytarget [delay]
+//
+// Replies are sent from a separate thread, so any number of requests can
+// be waiting at once; that way it's the client we're measuring, not the
+// target.
+//
+// Copyright © 1998 Chris Herborth (chrish@kagi.com)
+//                  Arcane Dragon Software
+//
+// License:  You can do anything you want with this source code, including
+//           incorporating it into commercial applications, as long as you
+//           give me credit in the About box and documentation.
+//
+// $Id$
+
+#include <app/Application.h>
+#include <app/Message.h>
+#include <support/List.h>
+#include <support/Locker.h>
+#include <kernel/OS.h>
+#include <stdlib.h>
+
+#define HEYTARGET_SIGNATURE "application/x-vnd.ADS-heytarget"
+
+// A request we haven't answered yet.
+struct pending_reply {
+	BMessage *request;
+	bigtime_t due;
+};
+
+class TargetApp : public BApplication {
+public:
+	TargetApp( bigtime_t delay );
+	virtual ~TargetApp();
+
+	virtual BHandler *ResolveSpecifier( BMessage *msg, int32 index,
+	                                    BMessage *specifier, int32 form,
+	                                    const char *property );
+	virtual void MessageReceived( BMessage *msg );
+
+private:
+	static int32 replier( void *data );
+
+	bigtime_t reply_delay;
+
+	BLocker queue_lock;
+	BList queue;
+	sem_id queued;
+	thread_id replier_thread;
+};
+
+// ----------------------------------------------------------------------
+TargetApp::TargetApp( bigtime_t delay )
+	: BApplication( HEYTARGET_SIGNATURE ),
+	  reply_delay( delay ),
+	  queue_lock( "heytarget queue" )
+{
+	queued = create_sem( 0, "heytarget queued" );
+	replier_thread = spawn_thread( replier, "heytarget replier",
+	                               B_NORMAL_PRIORITY, this );
+	(void)resume_thread( replier_thread );
+}
+
+TargetApp::~TargetApp()
+{
+	// Deleting the semaphore tells the replier to give up.
+	delete_sem( queued );
+
+	status_t retval;
+	(void)wait_for_thread( replier_thread, &retval );
+
+	for( int32 idx = 0; idx < queue.CountItems(); idx++ ) {
+		pending_reply *pending = (pending_reply *)queue.ItemAt( idx );
+		delete pending->request;
+		delete pending;
+	}
+}
+
+// ----------------------------------------------------------------------
+// Every property is ours.
+BHandler *TargetApp::ResolveSpecifier( BMessage *msg, int32 index,
+                                       BMessage *specifier, int32 form,
+                                       const char *property )
+{
+	return this;
+}
+
+// ----------------------------------------------------------------------
+void TargetApp::MessageReceived( BMessage *msg )
+{
+	switch( msg->what ) {
+	case B_GET_PROPERTY:
+	case B_SET_PROPERTY:
+	case B_COUNT_PROPERTIES:
+	case B_CREATE_PROPERTY:
+	case B_DELETE_PROPERTY:
+		break;
+
+	default:
+		BApplication::MessageReceived( msg );
+		return;
+	}
+
+	pending_reply *pending = new pending_reply;
+	pending->request = DetachCurrentMessage();
+	pending->due = system_time() + reply_delay;
+
+	queue_lock.Lock();
+	queue.AddItem( pending );
+	queue_lock.Unlock();
+
+	(void)release_sem( queued );
+}
+
+// ----------------------------------------------------------------------
+// Everything is delayed by the same amount, so the queue is always in
+// order of due time.
+int32 TargetApp::replier( void *data )
+{
+	TargetApp *app = (TargetApp *)data;
+
+	while( acquire_sem( app->queued ) == B_OK ) {
+		app->queue_lock.Lock();
+		pending_reply *pending = (pending_reply *)app->queue.RemoveItem( (int32)0 );
+		app->queue_lock.Unlock();
+
+		if( pending == NULL ) continue;
+
+		(void)snooze_until( pending->due, B_SYSTEM_TIMEBASE );
+
+		BMessage reply( B_REPLY );
+		switch( pending->request->what ) {
+		case B_GET_PROPERTY:
+			reply.AddString( "result", "Untitled" );
+			break;
+
+		case B_COUNT_PROPERTIES:
+			reply.AddInt32( "result", 1 );
+			break;
+
+		default:
+			break;
+		}
+		reply.AddInt32( "error", B_OK );
+
+		(void)pending->request->SendReply( &reply );
+
+		delete pending->request;
+		delete pending;
+	}
+
+	return B_OK;
+}
+
+// ======================================================================
+int main( int argc, char **argv )
+{
+	bigtime_t delay = 1000;
+	if( argc > 1 ) {
+		delay = atol( argv[1] );
+	}
+
+	TargetApp app( delay );
+	app.Run();
+
+	return 0;
+}
@@ -19,16 +19,11 @@ print "x.Get( t ) returned '%s'" % ( a, )
 (left, top, right, bottom) = old_rect
 
 for foo in range( 5, 105, 5 ):
-	# Looks like you need to refresh the specifier every time you want
-	# to use it... bug or feature?
-	f = x.Specifier( "Frame of Window 0" )
 	x.SetRect( f, ( ( left + foo ), ( top + foo ), ( right + foo ), ( bottom + foo ) ) )
-	f = x.Specifier( "Frame of Window 0" )
 	now_rect = x.Get( f )
 	print "rect is now '%s'" % ( now_rect, )
 	sleep( 1 )
 
-f = x.Specifier( "Frame of Window 0" )
 new_rect = x.Get( f )
 print "x.Get( f ) returned '%s'" % ( new_rect, )
 
@@ -49,3 +44,13 @@ for i in range( num ):
 	name = p.Get( s )
 
 	print "Pe's window %d is named '%s'" % ( i, name )
+
+# The same walk, through attribute-style proxies.
+num = p.Window.Count()
+
+print "Pe still has %d windows..." % ( num )
+
+for i in range( num ):
+	name = p.Window[i].Title()
+
+	print "Pe's window %d is still named '%s'" % ( i, name )